@@ -31,6 +31,53 @@ extern "C" {
 // Número máximo de moedas a rastrear
 #define MAX_COINS 50
 
+// Capacidade inicial das tabelas do rastreador (crescem conforme necessário)
+#define VC_TRACKER_INITIAL_CAPACITY 64
+
+// Frames que um ponto de exclusão dura sem voltar a ser visto (por omissão)
+#define VC_EXCLUDE_MEMORY 60
+
+// Unidade das janelas de memória do rastreador
+#define VC_WINDOW_FRAMES 0 /**< Janelas em frames */
+#define VC_WINDOW_MS 1     /**< Janelas em milissegundos do tempo de captura */
+
+// Intervalo (em frames) entre limpezas das entradas expiradas do rastreador
+#define VC_TRACKER_SWEEP_INTERVAL 30
+
+// Peso de cada nova medição na estimativa de velocidade das moedas (0 a 1)
+#define VC_TRACK_VELOCITY_GAIN 0.5f
+
+// Resolução de referência: os parâmetros espaciais (e os diâmetros em pixels
+// de coins.cfg) estão definidos para frames com esta altura
+#define VC_REFERENCE_WIDTH 640
+#define VC_REFERENCE_HEIGHT 480
+
+// Velocidade máxima esperada das moedas (pixels por frame), por omissão
+#define VC_TRACK_MAX_SPEED 20.0f
+
+// Frames durante os quais a distância máxima de uma moeda vista uma só vez cresce
+#define VC_TRACK_YOUNG_FRAMES 3
+
+// Re-deteção nas ROIs previstas: frames entre passagens completas, margem das ROIs
+// e diâmetro assumido para moedas ainda sem diâmetro medido
+#define VC_ROI_FULL_INTERVAL 10
+#define VC_ROI_MARGIN 24
+#define VC_ROI_DEFAULT_DIAMETER 180.0f
+
+// Evidência da denominação de cada moeda rastreada: deteções necessárias e
+// fração dos votos da classe de cor para a contar, fração a partir da qual
+// deixa de ser reclassificada, vantagem necessária para rever a classe de
+// uma moeda já contada e número de deteções completas guardadas para as
+// medianas do diâmetro e da circularidade
+#define VC_EVIDENCE_MIN_HITS 3
+#define VC_EVIDENCE_CONFIDENCE 0.6f
+#define VC_EVIDENCE_STABLE 0.9f
+#define VC_EVIDENCE_REVISE_RATIO 2.0f
+#define VC_EVIDENCE_SAMPLES 5
+
+// Peso das deteções junto às bordas ou parciais (as completas pesam 1)
+#define VC_EVIDENCE_EDGE_WEIGHT 0.5f
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //                           MACROS
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -81,6 +128,589 @@ typedef struct {
     int label;               /**< Etiqueta do objeto */
 } OVC;
 
+/**
+ * @brief Região retangular de uma imagem
+ */
+typedef struct {
+    int x, y;                /**< Canto superior esquerdo */
+    int width, height;       /**< Dimensões (0 = região vazia) */
+} ImageRegion;
+
+/**
+ * @brief Número máximo de níveis de uma pirâmide de imagens
+ */
+#define VC_PYRAMID_MAX_LEVELS 4
+
+/**
+ * @brief Estrutura para armazenar uma pirâmide de imagens
+ *
+ * O nível 0 é a imagem original (não pertence à pirâmide) e cada nível
+ * seguinte tem metade da largura e da altura do anterior. O buffer das
+ * somas verticais é reservado com a pirâmide, para a redução de cada frame
+ * não alocar memória.
+ */
+typedef struct {
+    IVC *levels[VC_PYRAMID_MAX_LEVELS]; /**< Imagens de cada nível */
+    int nlevels;                        /**< Número de níveis em uso */
+    unsigned short *rowSums;            /**< Somas verticais de uma linha do nível 0 */
+} ImagePyramid;
+
+// Opções de createIntegral()
+#define VC_INTEGRAL_32 0      /**< Acumulador de 32 bits */
+#define VC_INTEGRAL_64 1      /**< Acumulador de 64 bits */
+#define VC_INTEGRAL_SQUARED 2 /**< Calcula também a integral dos quadrados */
+
+/**
+ * @brief Estrutura para armazenar uma imagem integral (summed-area table)
+ *
+ * As tabelas têm (width + 1) x (height + 1) entradas; a entrada (x, y)
+ * guarda a soma de todos os pixels acima e à esquerda de (x, y). Só uma
+ * de sum32/sum64 está alocada.
+ */
+typedef struct {
+    int width, height;          /**< Dimensões da imagem de origem */
+    int stride;                 /**< Entradas por linha da tabela (width + 1) */
+    unsigned int *sum32;        /**< Somas com acumulador de 32 bits, ou NULL */
+    unsigned long long *sum64;  /**< Somas com acumulador de 64 bits, ou NULL */
+    unsigned long long *sqsum;  /**< Somas dos quadrados, ou NULL */
+} IntegralImage;
+
+// Modos de seleção do limiar de uma máscara
+#define VC_THRESH_FIXED 0 /**< Limiar fixo */
+#define VC_THRESH_OTSU 1  /**< Limiar global de Otsu, recalculado incrementalmente */
+#define VC_THRESH_LOCAL 2 /**< Limiar local pela média da vizinhança (imagem integral) */
+
+/**
+ * @brief Estado do limiar de uma máscara ao longo da sequência de frames
+ */
+typedef struct {
+    int mode;               /**< VC_THRESH_FIXED, VC_THRESH_OTSU ou VC_THRESH_LOCAL */
+    int value;              /**< Limiar global em vigor (0-255) */
+    int interval;           /**< Recalcula o limiar de Otsu a cada N frames */
+    float driftTolerance;   /**< Variação da média que obriga a recalcular antes disso */
+    int localRadius;        /**< Raio da janela local (0 = 1/8 do maior lado da imagem) */
+    int localOffset;        /**< Quanto um pixel tem de exceder a média local */
+    int framesSinceUpdate;  /**< Frames desde o último cálculo (-1 = nunca) */
+    float lastMean;         /**< Média amostrada no último cálculo */
+} ThresholdSelector;
+
+// Lado das células da grelha espacial (maior raio de associação do rastreador)
+#define VC_GRID_CELL_SIZE 85
+
+/**
+ * @brief Grelha espacial uniforme de identificadores inteiros
+ *
+ * Cada célula tem uma lista duplamente ligada dos identificadores que lá
+ * estão, pelo que inserir, mover e remover custam O(1) e uma pesquisa por
+ * raio só visita as células vizinhas.
+ */
+typedef struct {
+    int cellSize;               /**< Lado de cada célula em pixels */
+    int cols, rows;             /**< Dimensões da grelha em células */
+    int capacity;               /**< Número de identificadores (0 a capacity-1) */
+    int *cellHead;              /**< Primeiro identificador de cada célula (-1 = vazia) */
+    int *next, *prev;           /**< Ligações da lista de cada identificador */
+    int *itemCell;              /**< Célula de cada identificador (-1 = não inserido) */
+} SpatialGrid;
+
+// Máscaras segmentadas em cada frame
+#define VC_MASK_MAIN 0   /**< Máscara geral por luminância */
+#define VC_MASK_GOLD 1   /**< Moedas douradas (10c, 20c, 50c) */
+#define VC_MASK_COPPER 2 /**< Moedas de cobre (1c, 2c, 5c) */
+#define VC_MASK_EURO 3   /**< Moedas de Euro (1€, 2€) */
+#define VC_NUM_MASKS 4
+
+// Número máximo de denominações (tamanho dos contadores por tipo)
+#define VC_MAX_COIN_TYPES 8
+
+// Ficheiro com a especificação das moedas, lido no arranque se existir
+#define VC_COIN_SPEC_FILE "coins.cfg"
+
+// Calibração automática da escala (px/mm)
+#define VC_CALIBRATION_IMAGE "images/calibration.ppm" /**< Imagem de referência, usada se existir */
+#define VC_CALIBRATION_FRAMES 60        /**< Frames amostrados por omissão */
+#define VC_CALIBRATION_MAX_SAMPLES 1024 /**< Limite de diâmetros guardados */
+#define VC_CALIBRATION_MIN_SAMPLES 4    /**< Amostras explicadas necessárias para aceitar a escala */
+
+/**
+ * @brief Especificação de uma denominação
+ *
+ * O tipo de moeda usado no resto da biblioteca é a posição na tabela + 1.
+ */
+typedef struct {
+    char name[8];               /**< Nome curto ("1c", "2€") */
+    char label[48];             /**< Texto registado quando a moeda é contada */
+    float value;                /**< Valor facial */
+    float diameter;             /**< Diâmetro nominal em pixels */
+    float diameterMm;           /**< Diâmetro real em mm (0 = não entra no cálculo da escala) */
+    int colorClass;             /**< Máscara de cor (VC_MASK_COPPER, VC_MASK_GOLD ou VC_MASK_EURO) */
+    float tolerance;            /**< Tolerância relativa do diâmetro */
+    float minCircularity;       /**< Circularidade mínima de uma deteção completa */
+    int edgeMargin;             /**< Distância à borda abaixo da qual a moeda está parcialmente visível */
+} CoinSpec;
+
+/**
+ * @brief Tabela de denominações e índices por classe de cor
+ *
+ * order guarda, para cada classe de cor, as denominações por diâmetro
+ * crescente, para que a classificação seja uma pesquisa binária.
+ */
+typedef struct {
+    CoinSpec specs[VC_MAX_COIN_TYPES];  /**< Denominações (tipo = índice + 1) */
+    int nSpecs;                         /**< Denominações definidas */
+    int order[VC_NUM_MASKS][VC_MAX_COIN_TYPES]; /**< Índices de cada classe por diâmetro */
+    int nOrder[VC_NUM_MASKS];           /**< Denominações de cada classe */
+    float minCircularity[VC_NUM_MASKS]; /**< Menor circularidade mínima de cada classe */
+    int edgeMargin[VC_NUM_MASKS];       /**< Maior margem de borda de cada classe */
+} CoinSpecTable;
+
+/**
+ * @brief Parâmetros espaciais do processamento de uma sequência
+ *
+ * Os valores entre parênteses são os da montagem de referência (frames de
+ * VC_REFERENCE_HEIGHT linhas com a tabela de moedas por omissão). Todos os
+ * comprimentos são multiplicados por scale e as áreas por scale², uma vez
+ * por sequência, quando a tabela de denominações muda.
+ */
+typedef struct {
+    float scale;                /**< Fator linear em relação à montagem de referência */
+    int minBlobArea;            /**< Área mínima de um blob principal (9000) */
+    int maxBlobArea;            /**< Área a partir da qual um blob principal é ignorado (30000) */
+    int maxBlobWidth;           /**< Largura máxima de um blob principal (220) */
+    int matchDistanceSq;        /**< Distância² máxima entre um blob principal e o blob de cor (30²) */
+    int openKernel[VC_NUM_MASKS];  /**< Kernel da abertura de cada máscara (3, 7, 3, 3) */
+    int closeKernel[VC_NUM_MASKS]; /**< Kernel do fecho de cada máscara (5, 0, 0, 0; 0 = sem fecho) */
+    int coarseMinArea;          /**< Área mínima de um blob grosseiro para ser refinado (4000) */
+    int minClassArea;           /**< Área mínima de um blob de cor (6000) */
+    int euroMaxArea;            /**< Área máxima de um blob de Euro (100000) */
+    int euroPartialMinArea;     /**< Área mínima de uma moeda de Euro parcial (14000) */
+    int euroPartialMinSize;     /**< Largura e altura mínimas de uma moeda de Euro parcial (130) */
+    float euroPartialMinCircularity; /**< Circularidade mínima de uma moeda de Euro parcial (0.65, não escala) */
+    int drawMinArea;            /**< Área mínima dos blobs de cêntimos desenhados (7000) */
+    int drawEuroMinArea;        /**< Área mínima das moedas de Euro parciais desenhadas (12000) */
+    int toleranceMargin;        /**< Distância à borda em que a tolerância do diâmetro aumenta (50) */
+    int coinGate;               /**< Porta de associação das moedas de cêntimo (50) */
+    int euroGate;               /**< Porta de associação das moedas de Euro (75) */
+    int locationRadius;         /**< Raio de getCoinTypeAtLocation() (50) */
+    int exclusionRadius;        /**< Raio dos pontos de exclusão (30) */
+    int roiMargin;              /**< Margem das ROIs previstas (VC_ROI_MARGIN) */
+    float roiDefaultDiameter;   /**< Diâmetro assumido sem medida (VC_ROI_DEFAULT_DIAMETER) */
+    float maxSpeed;             /**< Velocidade máxima esperada (VC_TRACK_MAX_SPEED) */
+} PipelineParams;
+
+/**
+ * @brief Moeda rastreada
+ */
+typedef struct {
+    int x, y;                   /**< Última posição observada */
+    int px, py;                 /**< Posição prevista para o frame atual */
+    float vx, vy;               /**< Velocidade estimada em pixels por frame */
+    int type;                   /**< Denominação da classe de cor mais votada (fixa enquanto for estável) */
+    float evidence[VC_MAX_COIN_TYPES]; /**< Votos acumulados de cada denominação */
+    float evidenceTotal;        /**< Soma de evidence */
+    const char *label;          /**< Texto da denominação atual */
+    float diameters[VC_EVIDENCE_SAMPLES];     /**< Diâmetros das últimas deteções completas */
+    float circularities[VC_EVIDENCE_SAMPLES]; /**< Circularidades das mesmas deteções */
+    int sampleClasses[VC_EVIDENCE_SAMPLES];   /**< Classe de cor de cada uma */
+    int nSamples;               /**< Deteções completas guardadas até agora */
+    float diameter;             /**< Mediana dos últimos diâmetros (0 = desconhecido) */
+    float blobDiameter;         /**< Maior diâmetro do blob principal medido (0 = desconhecido) */
+    long long lastFrame;        /**< Frame em que foi vista pela última vez */
+    long long lastTimeMs;       /**< Tempo de captura (ms) desse frame */
+    long long assignedFrame;    /**< Último frame em que recebeu uma deteção */
+    int hits;                   /**< Número de deteções associadas */
+    int counted;                /**< 1 se a denominação já foi confirmada e contabilizada */
+    bool alive;                 /**< false quando a entrada foi removida ou expirou */
+} TrackedCoin;
+
+/**
+ * @brief Moeda detetada num frame, à espera de ser associada ao rastreador
+ */
+typedef struct {
+    int x, y;                   /**< Centro da moeda */
+    int type;                   /**< Tipo de moeda (posição em CoinTracker::specs + 1) */
+    float diameter;             /**< Diâmetro medido */
+    float circularity;          /**< Circularidade medida */
+    int area;                   /**< Área do blob */
+    const char *label;          /**< Texto a registar quando é contada (NULL = nenhum) */
+    float weight;               /**< Peso na evidência da denominação (0 = só atualiza a posição) */
+    int track;                  /**< Moeda rastreada associada (-1 = nenhuma) */
+    float blobDiameter;         /**< Diâmetro do blob principal (0 = desconhecido) */
+} CoinDetection;
+
+/**
+ * @brief Par candidato (deteção, moeda rastreada) dentro da distância máxima
+ */
+typedef struct {
+    int detection, track;       /**< Índices da deteção e da moeda rastreada */
+    int distSq;                 /**< Distância ao quadrado à posição prevista */
+} TrackPair;
+
+/**
+ * @brief Posição de uma moeda já analisada, ignorada nos frames seguintes
+ */
+typedef struct {
+    int x, y;                   /**< Posição */
+    long long lastFrame;        /**< Último frame em que foi criada ou revista */
+    long long lastTimeMs;       /**< Tempo de captura (ms) desse frame */
+    bool alive;                 /**< false quando foi removida ou expirou */
+} ExclusionPoint;
+
+/**
+ * @brief Estado do rastreamento de moedas de uma sequência de vídeo
+ *
+ * Cada sequência (ou câmara) tem o seu próprio rastreador, o que permite
+ * processar várias sequências no mesmo processo. As moedas rastreadas e
+ * os pontos de exclusão estão em tabelas que crescem conforme necessário
+ * e indexados em grelhas espaciais, para que as pesquisas por proximidade
+ * não percorram todas as entradas. As entradas expiram quando deixam de
+ * ser vistas e as tabelas são compactadas periodicamente.
+ */
+typedef struct {
+    TrackedCoin *coins;         /**< Moedas rastreadas (0 a nCoins-1, vivas ou não) */
+    int nCoins, coinCapacity;   /**< Entradas usadas e alocadas */
+    int nAliveCoins;            /**< Entradas vivas */
+    ExclusionPoint *excluded;   /**< Pontos de exclusão */
+    int nExcluded, excludedCapacity, nAliveExcluded;
+    int countedByType[VC_MAX_COIN_TYPES]; /**< Moedas contabilizadas por tipo, incluindo as já expiradas */
+    CoinSpecTable specs;        /**< Denominações reconhecidas (à escala dos frames) */
+    PipelineParams params;      /**< Parâmetros espaciais derivados da escala de specs */
+    int width, height;          /**< Dimensões dos frames */
+    long long frameIndex;       /**< Índice do frame atual (64 bits, nunca dá a volta) */
+    long long timestampMs;      /**< Tempo de captura do frame atual em ms (monótono) */
+    double nominalFps;          /**< Cadência usada quando o frame não traz tempo de captura */
+    int verbose;                /**< 1 = regista as moedas contadas e os resumos periódicos */
+    float maxSpeed;             /**< Velocidade máxima esperada (px/frame) para moedas sem velocidade */
+    int windowUnit;             /**< VC_WINDOW_FRAMES ou VC_WINDOW_MS */
+    long long coinWindow;       /**< Memória das moedas de cêntimo */
+    long long euroWindow;       /**< Memória das moedas de Euro */
+    long long excludeWindow;    /**< Memória dos pontos de exclusão */
+    SpatialGrid *coinGrid;      /**< Índice espacial de coins */
+    SpatialGrid *excludeGrid;   /**< Índice espacial de excluded */
+    int *candidates;            /**< Buffer de resultados das pesquisas na grelha */
+    int candidateCapacity;
+    CoinDetection *pending;     /**< Deteções do frame atual por associar */
+    int nPending, pendingCapacity;
+    TrackPair *pairs;           /**< Pares candidatos da associação */
+    int nPairs, pairCapacity;
+} CoinTracker;
+
+/**
+ * @brief Amostras da calibração automática da escala
+ *
+ * Diâmetros (em pixels) de blobs circulares e completos de cada classe de
+ * cor, recolhidos nos primeiros frames ou numa imagem de referência.
+ */
+typedef struct {
+    float *diameters;           /**< Diâmetro de cada amostra */
+    int *classes;               /**< Classe de cor (VC_MASK_*) de cada amostra */
+    int nSamples, capacity;
+    int frames;                 /**< Frames a amostrar (0 = calibração desligada) */
+    int framesDone;             /**< Frames já amostrados */
+    float pxPerMm;              /**< Última escala ajustada (0 = tabela por calibrar) */
+} ScaleCalibration;
+
+// Deteção de movimento (frames sem alterações são saltados)
+#define VC_MOTION_LEVEL 3         /**< Nível da pirâmide comparado (1/8 da resolução) */
+#define VC_MOTION_TILE 8          /**< Lado das células comparadas, em pixels do nível reduzido */
+#define VC_MOTION_THRESHOLD 6.0f  /**< Diferença média por amostra de uma célula que conta como movimento */
+#define VC_MOTION_MAX_SKIP 10     /**< Máximo de frames seguidos saltados */
+
+/**
+ * @brief Detetor de movimento por diferença com o último frame processado
+ *
+ * Compara uma versão reduzida de cada frame com a do último frame
+ * processado, por soma das diferenças absolutas em células; os frames sem
+ * movimento podem ser saltados.
+ */
+typedef struct {
+    ImagePyramid *pyramid;      /**< Redução do frame atual */
+    IVC *reference;             /**< Redução do último frame processado */
+    int hasReference;           /**< 0 até ao primeiro frame processado */
+    int level;                  /**< Nível da pirâmide comparado */
+    int tile;                   /**< Lado das células, em pixels do nível reduzido */
+    float threshold;            /**< Diferença média por amostra acima da qual há movimento */
+    int maxSkip;                /**< Máximo de frames seguidos saltados */
+    int skipped;                /**< Frames saltados desde o último processado */
+    float score;                /**< Maior diferença média de uma célula no último frame */
+    long long frames;           /**< Frames avaliados */
+    long long skippedFrames;    /**< Frames saltados */
+} MotionGate;
+
+// Modelo de fundo (regiões alteradas de uma câmara fixa)
+#define VC_BG_LEVEL 2                /**< Nível da pirâmide do modelo (1/4 da resolução) */
+#define VC_BG_LEARNING_RATE 0.05f    /**< Taxa de aprendizagem das amostras de fundo */
+#define VC_BG_FOREGROUND_RATE 0.005f /**< Taxa de aprendizagem das amostras de primeiro plano (um décimo da do fundo) */
+#define VC_BG_THRESHOLD 30           /**< Diferença de uma amostra para o modelo que a torna primeiro plano */
+#define VC_BG_MIN_AREA 4             /**< Área mínima (pixels do nível reduzido) de uma região alterada */
+#define VC_BG_MAX_COVERAGE 0.5f      /**< Fração de primeiro plano a partir da qual se processa o frame completo */
+
+/**
+ * @brief Modelo de fundo por média móvel e máscara de alterações
+ *
+ * Mantém a média de cada amostra de uma versão reduzida dos frames e, em
+ * cada frame, a máscara das amostras que se afastam dela e as caixas das
+ * regiões alteradas à resolução dos frames.
+ */
+typedef struct {
+    int width, height;          /**< Dimensões dos frames */
+    int level;                  /**< Nível da pirâmide do modelo */
+    ImagePyramid *pyramid;      /**< Redução do frame atual */
+    float *mean;                /**< Média de cada amostra (pixel e canal) do nível reduzido */
+    unsigned char *changed;     /**< Amostras alteradas no último frame (0 ou 255) */
+    IVC *mask;                  /**< Máscara de primeiro plano do nível reduzido (0/255) */
+    IVC *labels;                /**< Imagem de trabalho da etiquetagem */
+    int initialised;            /**< 0 até ao primeiro frame */
+    float learningRate;         /**< Taxa de aprendizagem do fundo */
+    float foregroundRate;       /**< Taxa de aprendizagem do primeiro plano */
+    int threshold;              /**< Diferença que torna uma amostra primeiro plano */
+    float coverage;             /**< Fração de pixels de primeiro plano no último frame */
+    ImageRegion *regions;       /**< Regiões alteradas (changeRegions()) */
+    int nRegions, regionCapacity;
+    long long regionPixels;     /**< Soma das áreas das regiões, à resolução dos frames */
+    long long frames;           /**< Frames comparados com o modelo pelo processador */
+    double areaSum;             /**< Soma da fração de cada frame que foi segmentada */
+} BackgroundModel;
+
+// Contagem por passagem numa linha (tapetes com câmara fixa)
+#define VC_TRIP_BAND_FACTOR 0.75f /**< Meia altura da banda automática, em diâmetros da maior moeda */
+#define VC_TRIP_DEBOUNCE 5        /**< Frames em que não se conta outra moeda no sítio de uma passagem */
+#define VC_TRIP_LANE_MEMORY 10    /**< Frames sem deteções ao fim dos quais uma moeda é esquecida */
+#define VC_TRIP_MAX_LANES 64      /**< Máximo de pistas ao longo da linha */
+#define VC_TRIP_LANE_COINS 4      /**< Moedas seguidas ao mesmo tempo em cada pista */
+
+/**
+ * @brief Moeda em aproximação ou em passagem na linha de contagem
+ */
+typedef struct {
+    int x, y;                   /**< Centro da última deteção */
+    long long lastFrame;        /**< Frame da última deteção (0 = entrada livre) */
+    long long assignedFrame;    /**< Último frame em que recebeu uma deteção */
+    int crossed;                /**< 1 se o centro já passou para o outro lado da linha */
+    int counted;                /**< 1 se a moeda já foi contada */
+    float votes[VC_MAX_COIN_TYPES]; /**< Votos de cada denominação */
+} TripCoin;
+
+/**
+ * @brief Pista da linha de contagem (faixa de colunas com a largura da maior moeda)
+ */
+typedef struct {
+    TripCoin coins[VC_TRIP_LANE_COINS]; /**< Moedas na banda desta pista */
+    long long countFrame;       /**< Frame da última passagem contada */
+    int countX, countY;         /**< Centro da moeda nessa passagem */
+} TripLane;
+
+/**
+ * @brief Linha de contagem horizontal e estado das suas pistas
+ *
+ * Só a banda de linhas à volta da linha é segmentada. A linha é dividida
+ * em pistas com a largura da maior moeda; cada moeda é contada uma vez,
+ * quando o centro do seu blob passa para o outro lado da linha. Durante
+ * debounce frames, uma passagem a menos de coinSpacing de outra já contada
+ * é a mesma moeda, partida em dois blobs.
+ */
+typedef struct {
+    int width, height;          /**< Dimensões dos frames */
+    int y;                      /**< Linha de contagem */
+    int halfBand;               /**< Meia altura da banda (0 = automática) */
+    int debounce;               /**< Frames em que uma passagem junto de outra já contada não conta */
+    int laneWidth;              /**< Largura das pistas (último frame) */
+    int nLanes;                 /**< Pistas em uso (último frame) */
+    int coinSpacing;            /**< Distância mínima entre os centros de duas moedas (menor diâmetro) */
+    ImageRegion band;           /**< Banda segmentada (último frame) */
+    TripLane lanes[VC_TRIP_MAX_LANES];
+    long long crossings;        /**< Moedas contadas */
+    long long frames;           /**< Frames em que a banda foi segmentada */
+} Tripwire;
+
+// Modos de deteção do processador de frames
+#define VC_DETECT_FULL 0   /**< Segmenta e etiqueta à resolução total */
+#define VC_DETECT_COARSE 1 /**< Segmenta na pirâmide e refina só nas ROIs candidatas */
+
+/**
+ * @brief Estado de processamento de uma sequência de frames
+ *
+ * Guarda a configuração do processamento e os buffers de trabalho, que são
+ * alocados uma única vez em vez de em cada frame.
+ */
+typedef struct {
+    int width, height;          /**< Dimensões dos frames processados */
+    int detectMode;             /**< VC_DETECT_FULL ou VC_DETECT_COARSE */
+    CoinTracker *tracker;       /**< Rastreador de moedas da sequência */
+    int coarseLevel;            /**< Nível da pirâmide usado no modo grosseiro */
+    IVC *rgbImage, *rgbImage2;  /**< frame e frame2 convertidos para RGB */
+    IVC *hsvImage;              /**< Imagem de trabalho da segmentação HSV */
+    IVC *binaryImage;           /**< Máscara binária antes da morfologia */
+    IVC *labelImage;            /**< Máscara após morfologia, etiquetada no local */
+    IVC *grayImage;             /**< Luminância para os limiares automáticos */
+    IntegralImage *integral;    /**< Integral de grayImage (limiar local) */
+    ThresholdSelector thresholds[VC_NUM_MASKS]; /**< Limiar de cada máscara (VC_MASK_*) */
+    ImagePyramid *pyramid;      /**< Pirâmide de rgbImage (modo grosseiro) */
+    ImagePyramid *pyramid2;     /**< Pirâmide de rgbImage2 (modo grosseiro) */
+    int roiTracking;            /**< 1 = entre passagens completas só processa as ROIs previstas */
+    int fullFrameInterval;      /**< Frames entre passagens completas com roiTracking */
+    ImageRegion entryBand;      /**< Faixa por onde entram as moedas, processada em todos os frames */
+    ImageRegion *regions;       /**< ROIs do frame atual */
+    int nRegions, regionCapacity;
+    IVC *roiImage;              /**< Recorte RGB de uma ROI */
+    ScaleCalibration calibration; /**< Calibração automática da escala das denominações */
+    struct TaskScheduler *scheduler; /**< Divide os kernels da segmentação em faixas (NULL = sequencial) */
+    MotionGate *motion;         /**< Salta os frames sem movimento (NULL = processa todos) */
+    BackgroundModel *background; /**< Restringe a segmentação às regiões alteradas (NULL = desligado) */
+    Tripwire *tripwire;         /**< Conta as passagens numa linha em vez de rastrear (NULL = desligado) */
+} FrameProcessor;
+
+/**
+ * @brief Frame em trânsito no modo pipeline
+ *
+ * Cada slot tem as suas próprias imagens, para que estágios diferentes
+ * possam trabalhar ao mesmo tempo em frames diferentes. Os slots formam um
+ * conjunto fixo, alocado uma única vez, e circulam entre os estágios pelo
+ * seu índice. O frame secundário (frame2 de processFrameAt()) não é
+ * copiado: a segmentação usa a imagem RGB do slot do frame de referência.
+ * Os blobs de cada máscara são extraídos pela thread que segmenta o slot
+ * e libertados pela análise.
+ */
+typedef struct {
+    int index;                  /**< Posição do slot no conjunto */
+    IVC *frame;                 /**< Frame BGR (recebe as visualizações) */
+    IVC *rgb;                   /**< frame convertido para RGB (na leitura) */
+    IVC *hsv, *gray, *binary;   /**< Imagens de trabalho da segmentação */
+    IntegralImage *integral;    /**< Integral do limiar local */
+    IVC *masks[VC_NUM_MASKS];   /**< Máscaras limpas e etiquetadas no local */
+    OVC *blobs[VC_NUM_MASKS];   /**< Blobs de cada máscara (NULL = nenhum) */
+    int nblobs[VC_NUM_MASKS];   /**< Número de blobs de cada máscara */
+    int colourMasks;            /**< 1 = as máscaras de cor foram segmentadas */
+    long long timestampMs;      /**< Tempo de captura (negativo = desconhecido) */
+    long long sequence;         /**< Número de ordem do frame na sequência */
+} FrameSlot;
+
+// Estágios do modo pipeline
+#define VC_STAGE_DECODE 0   /**< Leitura/descodificação e conversão para RGB */
+#define VC_STAGE_SEGMENT 1  /**< Limiar, morfologia e etiquetagem (soma das threads de trabalho) */
+#define VC_STAGE_ANALYSE 2  /**< Classificação e rastreamento, pela ordem dos frames */
+#define VC_STAGE_RENDER 3   /**< Visualização */
+#define VC_PIPELINE_STAGES 4
+#define VC_PIPELINE_DEPTH 4 /**< Slots em circulação por omissão */
+#define VC_PIPELINE_MAX_WORKERS 64 /**< Máximo de threads de segmentação */
+
+/**
+ * @brief frame2 é o último frame com índice múltiplo deste intervalo
+ *
+ * Corresponde a atualizar frame2 "a cada dois frames", como no modo
+ * sequencial; o pipeline precisa de pelo menos este número de slots.
+ */
+#define VC_FRAME2_INTERVAL 2
+
+/**
+ * @brief Anel sem bloqueios de índices de slots (um produtor, um consumidor)
+ */
+typedef struct SlotRing SlotRing;
+
+/**
+ * @brief Estágios fornecidos pela aplicação ao modo pipeline
+ *
+ * read preenche slot->frame e slot->timestampMs e devolve 0 no fim da
+ * sequência (deve descodificar diretamente para slot->frame->data);
+ * render mostra slot->frame e devolve 0 para parar. read corre numa
+ * thread própria e render na thread que chamou runPipeline().
+ */
+typedef struct {
+    int (*read)(void *user, FrameSlot *slot);
+    int (*render)(void *user, FrameSlot *slot); /**< Pode ser NULL */
+    void *user;
+} PipelineCallbacks;
+
+/**
+ * @brief Tempos do modo pipeline
+ */
+typedef struct {
+    long long frames;                           /**< Frames que chegaram ao fim do pipeline */
+    double stageSeconds[VC_PIPELINE_STAGES];    /**< Tempo ocupado de cada estágio (VC_STAGE_*) */
+    double wallSeconds;                         /**< Duração total */
+} PipelineStats;
+
+/**
+ * @brief Frames processados antes de cada bloco só para refazer o rastreamento
+ *
+ * Tem de cobrir o tempo que uma moeda fica à vista (e as janelas de
+ * memória do rastreador) para que as contagens sejam as de uma execução
+ * sequencial.
+ */
+#define VC_CHUNK_OVERLAP 150
+#define VC_MAX_CHUNKS 64 /**< Máximo de blocos em processChunks() */
+
+/**
+ * @brief Acesso da aplicação a um vídeo no modo por blocos
+ *
+ * open abre uma leitura independente posicionada no frame dado (NULL em
+ * caso de erro); read descodifica o frame seguinte em BGR para frame e
+ * devolve 0 no fim; close liberta a leitura. Cada bloco usa a sua leitura,
+ * e leituras de blocos diferentes correm em threads diferentes.
+ */
+typedef struct {
+    void *(*open)(void *user, long long firstFrame);
+    int (*read)(void *stream, IVC *frame, long long *timestampMs);
+    void (*close)(void *stream);
+    void *user;
+} ChunkCallbacks;
+
+/**
+ * @brief Resultado de um bloco de processChunks()
+ */
+typedef struct {
+    long long firstFrame;           /**< Primeiro frame do bloco */
+    long long endFrame;             /**< Frame seguinte ao último (negativo = até ao fim do vídeo) */
+    long long leadIn;               /**< Frames processados antes de firstFrame */
+    long long frames;               /**< Frames processados, incluindo os de leadIn */
+    int counts[VC_MAX_COIN_TYPES];  /**< Variação das contagens nos frames do bloco */
+    long long skipped;              /**< Frames do bloco saltados pelo detetor de movimento */
+    double seconds;                 /**< Duração do processamento do bloco */
+    int ok;                         /**< 0 se o bloco não pôde ser processado */
+} ChunkResult;
+
+/**
+ * @brief Escalonador de tarefas com roubo de trabalho (vc_scheduler.cpp)
+ *
+ * Cada thread de trabalho tem uma fila dupla própria; as threads sem
+ * trabalho roubam tarefas das filas das outras.
+ */
+typedef struct TaskScheduler TaskScheduler;
+
+/**
+ * @brief Conjunto de tarefas por cujo fim se pode esperar (waitTaskGroup())
+ */
+typedef struct TaskGroup TaskGroup;
+
+typedef void (*TaskFunction)(void *arg);                 /**< Tarefa do escalonador */
+typedef void (*RowFunction)(void *arg, int y0, int y1);  /**< Processa as linhas [y0, y1) */
+
+#define VC_SCHED_MAX_WORKERS 64 /**< Máximo de threads de um escalonador */
+#define VC_SCHED_MAX_BANDS 64   /**< Máximo de faixas de parallelRows() */
+#define VC_SCHED_MIN_ROWS 32    /**< Linhas mínimas de uma faixa dos kernels de segmentação */
+
+#define VC_MAX_STREAMS 64 /**< Máximo de streams em runStreams() */
+
+/**
+ * @brief Sequência de vídeo independente no modo multi-stream
+ *
+ * Cada stream tem o seu contexto (processador, rastreador, frames e
+ * contadores), pelo que vários streams podem ser processados ao mesmo
+ * tempo por threads diferentes. read descodifica o frame seguinte em BGR
+ * para frame e devolve 0 no fim da sequência.
+ */
+typedef struct {
+    FrameProcessor *proc;               /**< Contexto de processamento do stream */
+    IVC *frame, *frame2;                /**< Frame atual e frame secundário */
+    int (*read)(void *source, IVC *frame, long long *timestampMs);
+    void *source;                       /**< Origem passada a read */
+    int coinCounts[VC_MAX_COIN_TYPES];  /**< Contadores do stream */
+    long long frames;                   /**< Frames processados */
+    double seconds;                     /**< Tempo até ao fim da sequência */
+    double busySeconds;                 /**< Tempo de leitura e processamento */
+    double latencySum, latencyMax;      /**< Latência dos frames: desde que o stream fica pronto até ao resultado */
+} VideoStream;
+
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //                    FUNÇÕES PRINCIPAIS
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -135,6 +765,15 @@ int bgr2rgb(IVC *src, IVC *dst);
  */
 int rgb2gray(IVC *src, IVC *dst);
 
+/**
+ * @brief Converte uma imagem RGB numa imagem binária numa só passagem
+ * @param src Imagem de origem no formato RGB
+ * @param dst Imagem de destino binária (1 canal)
+ * @param threshold Limiar de luminância (0-255); pixels >= limiar ficam a 255
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int rgb2binary(IVC *src, IVC *dst, int threshold);
+
 /**
  * @brief Converte uma imagem RGB para o espaço de cores HSV e segmenta com base no tipo
  * @param srcdst Imagem a ser convertida e segmentada (altera a original)
@@ -171,6 +810,28 @@ int binaryOpen(IVC *src, IVC *dst, int kernel);
  */
 int binaryClose(IVC *src, IVC *dst, int kernel);
 
+/**
+ * @brief Erosão binária das linhas [y0, y1) de dst (src e dst diferentes)
+ * @param src Imagem de origem binária
+ * @param dst Imagem de destino binária
+ * @param kernel Tamanho do kernel (matriz estruturante)
+ * @param y0 Primeira linha a calcular
+ * @param y1 Linha seguinte à última
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int binaryErode(IVC *src, IVC *dst, int kernel, int y0, int y1);
+
+/**
+ * @brief Dilatação binária das linhas [y0, y1) de dst (src e dst diferentes)
+ * @param src Imagem de origem binária
+ * @param dst Imagem de destino binária
+ * @param kernel Tamanho do kernel (matriz estruturante)
+ * @param y0 Primeira linha a calcular
+ * @param y1 Linha seguinte à última
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int binaryDilate(IVC *src, IVC *dst, int kernel, int y0, int y1);
+
 // Deteção de bordas
 /**
  * @brief Deteta bordas numa imagem em escala de cinzento
@@ -181,6 +842,16 @@ int binaryClose(IVC *src, IVC *dst, int kernel);
  */
 int detectEdges(IVC *src, IVC *dst, float threshold);
 
+/**
+ * @brief Deteta bordas e, opcionalmente, a direção do gradiente
+ * @param src Imagem de origem em escala de cinzento
+ * @param dst Imagem de destino com as bordas detetadas
+ * @param direction Imagem de 1 canal com a direção quantizada (0=0°, 1=45°, 2=90°, 3=135°), ou NULL
+ * @param threshold Limiar para determinar o que é considerado uma borda
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int detectEdgesDirection(IVC *src, IVC *dst, IVC *direction, float threshold);
+
 // Análise de blobs
 /**
  * @brief Etiqueta objetos (blobs) numa imagem binária
@@ -200,52 +871,925 @@ OVC *blobLabel(IVC *src, IVC *dst, int *nlabels);
  */
 int blobInfo(IVC *src, OVC *blobs, int nblobs);
 
-//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-//                    FUNÇÕES PARA MOEDAS
+// Pirâmides de imagens
+/**
+ * @brief Reduz uma imagem para metade com uma média 2x2
+ * @param src Imagem de origem (1 ou mais canais)
+ * @param dst Imagem de destino com metade da largura e da altura de src
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int downsample2x(IVC *src, IVC *dst);
 
-// Constantes para diâmetros de moedas (em pixels)
-extern const float DIAM_1CENT;
-extern const float DIAM_2CENT;
-extern const float DIAM_5CENT;
-extern const float DIAM_10CENT;
-extern const float DIAM_20CENT;
-extern const float DIAM_50CENT;
-extern const float DIAM_1EURO;
-extern const float DIAM_2EURO;
-extern const float BASE_TOLERANCE;
+/**
+ * @brief Cria uma pirâmide de imagens (os níveis 1..nlevels-1 são alocados)
+ * @param width Largura da imagem base
+ * @param height Altura da imagem base
+ * @param channels Número de canais
+ * @param nlevels Número de níveis, incluindo a base
+ * @return Ponteiro para a pirâmide criada ou NULL em caso de erro
+ */
+ImagePyramid *createPyramid(int width, int height, int channels, int nlevels);
 
 /**
- * @brief Funções para deteção e classificação de moedas
+ * @brief Liberta a memória alocada para uma pirâmide
+ * @param pyramid Ponteiro para a pirâmide
+ * @return NULL após a libertação
  */
+ImagePyramid *freePyramid(ImagePyramid *pyramid);
 
-// Funções de deteção de moedas específicas
-bool detectCopperCoins(OVC *blob, OVC *copperBlobs, int ncopperBlobs, 
-                     int *excludeList, int *counters, int distThresholdSq);
-                     
-bool detectGoldCoins(OVC *blob, OVC *goldBlobs, int ngoldBlobs, 
-                   int *excludeList, int *counters, int distThresholdSq);
-                   
-bool detectEuroCoins(OVC *blob, OVC *euroBlobs, int neuroBlobs, 
-                   int *excludeList, int *counters, int distThresholdSq);
+/**
+ * @brief Constrói os níveis da pirâmide a partir da imagem base
+ * @param src Imagem base (nível 0)
+ * @param pyramid Pirâmide de destino
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int buildPyramid(IVC *src, ImagePyramid *pyramid);
 
-// Funções auxiliares para o processador de frames
-void processFrame(IVC *frame, IVC *frame2, int *excludeList, int *coinCounts);
+/**
+ * @brief Copia uma região retangular de uma imagem
+ * @param src Imagem de origem
+ * @param dst Imagem de destino; as suas dimensões definem o tamanho da região
+ * @param x Coluna do canto superior esquerdo da região em src
+ * @param y Linha do canto superior esquerdo da região em src
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int extractRegion(IVC *src, IVC *dst, int x, int y);
 
-// Funções de rastreamento e gestão de moedas
-int trackCoin(int x, int y, int coinType, int countIt);
-int excludeCoin(int *excludeList, int xc, int yc, int option);
-void frameCounter(int reset);
-int getFrameCount();
-void correctGoldCoins(int x, int y, int *counters);
-int getCoinTypeAtLocation(int x, int y);
+// Deteção de movimento
+/**
+ * @brief Soma das diferenças absolutas entre duas imagens num retângulo (SSE2)
+ * @param a Primeira imagem
+ * @param b Segunda imagem, com as dimensões e canais de a
+ * @param x Coluna do canto superior esquerdo
+ * @param y Linha do canto superior esquerdo
+ * @param w Largura do retângulo
+ * @param h Altura do retângulo
+ * @return Soma de |a - b| sobre os pixels e canais do retângulo
+ */
+unsigned long long imageSAD(const IVC *a, const IVC *b, int x, int y, int w, int h);
+
+/**
+ * @brief Cria um detetor de movimento com os parâmetros por omissão (VC_MOTION_*)
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param channels Canais dos frames
+ * @return Ponteiro para o detetor ou NULL em caso de erro
+ */
+MotionGate *createMotionGate(int width, int height, int channels);
+
+/**
+ * @brief Liberta um detetor de movimento
+ * @param gate Ponteiro para o detetor
+ * @return NULL após a libertação
+ */
+MotionGate *freeMotionGate(MotionGate *gate);
+
+/**
+ * @brief Avalia um frame e decide se deve ser processado
+ *
+ * Um frame processado passa a ser a referência das comparações seguintes.
+ *
+ * @param gate Detetor de movimento
+ * @param frame Frame a avaliar
+ * @return 1 se o frame deve ser processado, 0 se pode ser saltado
+ */
+int updateMotionGate(MotionGate *gate, IVC *frame);
+
+// Modelo de fundo
+/**
+ * @brief Cria um modelo de fundo vazio com os parâmetros por omissão (VC_BG_*)
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param channels Canais dos frames
+ * @return Ponteiro para o modelo ou NULL em caso de erro
+ */
+BackgroundModel *createBackgroundModel(int width, int height, int channels);
+
+/**
+ * @brief Liberta um modelo de fundo
+ * @param bg Ponteiro para o modelo
+ * @return NULL após a libertação
+ */
+BackgroundModel *freeBackgroundModel(BackgroundModel *bg);
+
+/**
+ * @brief Compara um frame com o modelo (máscara e cobertura) e atualiza o modelo (SSE2)
+ * @param bg Modelo de fundo
+ * @param frame Frame com as dimensões do modelo
+ * @return 1 se bg->mask é válida para este frame, 0 se o modelo foi inicializado ou em caso de erro
+ */
+int updateBackground(BackgroundModel *bg, IVC *frame);
+
+/**
+ * @brief Caixas das regiões alteradas à resolução dos frames, com margem e fundidas
+ * @param bg Modelo de fundo (depois de updateBackground())
+ * @param margin Margem em pixels à resolução dos frames
+ * @return Número de regiões (em bg->regions), ou -1 em caso de erro
+ */
+int changeRegions(BackgroundModel *bg, int margin);
+
+// Contagem por passagem numa linha
+/**
+ * @brief Cria uma linha de contagem na linha y com os parâmetros por omissão (VC_TRIP_*)
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param y Linha de contagem (0 a height-1)
+ * @return Ponteiro para a linha ou NULL em caso de erro
+ */
+Tripwire *createTripwire(int width, int height, int y);
+
+/**
+ * @brief Liberta uma linha de contagem
+ * @param tw Ponteiro para a linha
+ * @return NULL após a libertação
+ */
+Tripwire *freeTripwire(Tripwire *tw);
+
+/**
+ * @brief Banda a segmentar e largura das pistas para a escala atual das denominações
+ * @param tw Linha de contagem
+ * @param specs Denominações à escala dos frames
+ * @return Banda a segmentar (também em tw->band)
+ */
+ImageRegion tripwireBand(Tripwire *tw, const CoinSpecTable *specs);
+
+/**
+ * @brief Verifica se um blob segmentado na banda foi cortado pelo seu limite de cima ou de baixo
+ * @param tw Linha de contagem
+ * @param blob Blob em coordenadas do frame
+ * @return 1 se o blob está cortado, 0 caso contrário
+ */
+int tripwireCut(const Tripwire *tw, const OVC *blob);
+
+/**
+ * @brief Conta as deteções pendentes do rastreador que passaram a linha e esvazia a fila
+ * @param tw Linha de contagem
+ * @param tracker Rastreador com as deteções do frame (relógio e denominações)
+ * @param counters Contadores por tipo, atualizados com as moedas contadas
+ * @return Moedas contadas neste frame
+ */
+int crossTripwire(Tripwire *tw, CoinTracker *tracker, int *counters);
+
+/**
+ * @brief Desenha a linha de contagem num frame BGR
+ * @param tw Linha de contagem
+ * @param frame Frame com as dimensões da linha
+ */
+void drawTripwire(const Tripwire *tw, IVC *frame);
+
+// Imagens integrais
+/**
+ * @brief Cria uma imagem integral
+ * @param width Largura da imagem de origem
+ * @param height Altura da imagem de origem
+ * @param flags Combinação de VC_INTEGRAL_64 e VC_INTEGRAL_SQUARED
+ * @return Ponteiro para a imagem integral ou NULL em caso de erro
+ */
+IntegralImage *createIntegral(int width, int height, int flags);
+
+/**
+ * @brief Liberta a memória de uma imagem integral
+ * @param ii Ponteiro para a imagem integral
+ * @return NULL após a libertação
+ */
+IntegralImage *freeIntegral(IntegralImage *ii);
+
+/**
+ * @brief Calcula a imagem integral de uma imagem de 1 canal
+ * @param src Imagem de origem
+ * @param ii Imagem integral com as mesmas dimensões
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int computeIntegral(IVC *src, IntegralImage *ii);
+
+/**
+ * @brief Vista sobre as tabelas de uma integral para uma imagem mais pequena
+ *
+ * A vista partilha as tabelas de ii, sem alocar memória, com as dimensões
+ * dadas e stride width + 1; computeIntegral() sobre a vista invalida o
+ * conteúdo de ii.
+ * @param ii Imagem integral com as tabelas
+ * @param width Largura da imagem de origem da vista (<= ii->width)
+ * @param height Altura da imagem de origem da vista (<= ii->height)
+ * @param view Vista de destino
+ * @return 1 em caso de sucesso, 0 se a imagem não couber nas tabelas de ii
+ */
+int integralView(const IntegralImage *ii, int width, int height, IntegralImage *view);
+
+/**
+ * @brief Soma dos pixels do retângulo (x, y, w, h), recortado à imagem
+ */
+unsigned long long integralSum(const IntegralImage *ii, int x, int y, int w, int h);
+
+/**
+ * @brief Soma dos quadrados dos pixels do retângulo (requer VC_INTEGRAL_SQUARED)
+ */
+unsigned long long integralSqSum(const IntegralImage *ii, int x, int y, int w, int h);
+
+/**
+ * @brief Média dos pixels do retângulo (x, y, w, h)
+ */
+float integralMean(const IntegralImage *ii, int x, int y, int w, int h);
+
+/**
+ * @brief Variância dos pixels do retângulo (requer VC_INTEGRAL_SQUARED)
+ */
+float integralVariance(const IntegralImage *ii, int x, int y, int w, int h);
+
+/**
+ * @brief Fração (0-1) de pixels a 255 de uma máscara binária no retângulo
+ */
+float integralFillRatio(const IntegralImage *ii, int x, int y, int w, int h);
+
+/**
+ * @brief Filtro de média com janela (2*radius+1)² calculado a partir da integral
+ * @param ii Imagem integral da imagem a filtrar
+ * @param dst Imagem de destino (1 canal)
+ * @param radius Raio da janela
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int boxFilter(const IntegralImage *ii, IVC *dst, int radius);
+
+// Histogramas e limiares automáticos
+/**
+ * @brief Calcula o histograma de uma imagem de 1 canal
+ * @param src Imagem de origem
+ * @param hist Histograma de destino (256 posições)
+ * @param step Passo de amostragem em linhas e colunas (1 = todos os pixels)
+ * @return Número de pixels amostrados, ou 0 em caso de erro
+ */
+long int computeHistogram(IVC *src, unsigned int *hist, int step);
+
+/**
+ * @brief Limiar de Otsu de um histograma de 256 posições
+ * @return Limiar (pixel >= limiar é primeiro plano), ou -1 se o histograma estiver vazio
+ */
+int otsuThreshold(const unsigned int *hist);
+
+/**
+ * @brief Limiarização local: 255 onde o pixel excede a média da janela em pelo menos offset
+ * @param src Imagem em níveis de cinzento
+ * @param dst Imagem binária de destino
+ * @param ii Imagem integral de src
+ * @param radius Raio da janela
+ * @param offset Diferença mínima em relação à média local
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int adaptiveThreshold(IVC *src, IVC *dst, const IntegralImage *ii, int radius, int offset);
+
+/**
+ * @brief Inicializa o seletor de limiar de uma máscara
+ * @param sel Seletor a inicializar
+ * @param mode VC_THRESH_FIXED, VC_THRESH_OTSU ou VC_THRESH_LOCAL
+ * @param value Limiar fixo / inicial
+ */
+void initThreshold(ThresholdSelector *sel, int mode, int value);
+
+/**
+ * @brief Atualiza (se for altura disso) o limiar automático com o frame atual
+ * @param sel Seletor de limiar
+ * @param gray Imagem em níveis de cinzento do frame
+ * @return Limiar global em vigor
+ */
+int updateThreshold(ThresholdSelector *sel, IVC *gray);
+
+// Grelha espacial
+/**
+ * @brief Cria uma grelha espacial que cobre uma área width x height
+ * @param width Largura da área
+ * @param height Altura da área
+ * @param cellSize Lado das células
+ * @param capacity Número de identificadores
+ * @return Ponteiro para a grelha ou NULL em caso de erro
+ */
+SpatialGrid *createGrid(int width, int height, int cellSize, int capacity);
+
+/**
+ * @brief Liberta uma grelha espacial
+ * @return NULL após a libertação
+ */
+SpatialGrid *freeGrid(SpatialGrid *grid);
+
+void gridClear(SpatialGrid *grid);
+int gridReserve(SpatialGrid *grid, int capacity);
+void gridInsert(SpatialGrid *grid, int id, int x, int y);
+void gridRemove(SpatialGrid *grid, int id);
+
+/**
+ * @brief Identificadores candidatos a estar a menos de radius de (x, y)
+ * @param out Array de destino
+ * @param maxOut Tamanho de out
+ * @return Número de candidatos (a distância exata é verificada pelo chamador)
+ */
+int gridQuery(const SpatialGrid *grid, int x, int y, int radius, int *out, int maxOut);
+
+//++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//                    FUNÇÕES PARA MOEDAS
+
+// Tolerância relativa do diâmetro na montagem de referência
+extern const float BASE_TOLERANCE;
+
+/**
+ * @brief Funções para deteção e classificação de moedas
+ */
+
+// Funções de deteção de moedas específicas
+bool detectCopperCoins(CoinTracker *tracker, OVC *blob, OVC *copperBlobs, int ncopperBlobs, 
+                     int distThresholdSq);
+                     
+bool detectGoldCoins(CoinTracker *tracker, OVC *blob, OVC *goldBlobs, int ngoldBlobs, 
+                   int distThresholdSq);
+                   
+bool detectEuroCoins(CoinTracker *tracker, OVC *blob, OVC *euroBlobs, int neuroBlobs, 
+                   int distThresholdSq);
+
+// Funções auxiliares para o processador de frames
+/**
+ * @brief Cria o estado de processamento para frames com as dimensões dadas
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @return Ponteiro para o processador criado ou NULL em caso de erro
+ */
+FrameProcessor *createFrameProcessor(int width, int height);
+
+/**
+ * @brief Liberta o estado de processamento e todos os seus buffers
+ * @param proc Ponteiro para o processador
+ * @return NULL após a libertação
+ */
+FrameProcessor *freeFrameProcessor(FrameProcessor *proc);
+
+/**
+ * @brief Cria um processador com a configuração de outro (buffers novos e rastreador vazio)
+ * @param proc Processador de referência
+ * @return Ponteiro para o novo processador ou NULL em caso de erro
+ */
+FrameProcessor *cloneFrameProcessor(const FrameProcessor *proc);
+
+void processFrame(FrameProcessor *proc, IVC *frame, IVC *frame2, int *coinCounts);
+
+/**
+ * @brief Processa um frame com o tempo de captura conhecido
+ * @param timestampMs Tempo de captura do frame em ms (negativo = desconhecido)
+ */
+void processFrameAt(FrameProcessor *proc, IVC *frame, IVC *frame2, int *coinCounts, long long timestampMs);
+
+/**
+ * @brief Inicia a calibração automática da escala nos próximos frames
+ *
+ * Durante os frames de calibração as moedas não são contadas; no fim a
+ * tabela de denominações do rastreador é reescalada.
+ *
+ * @param proc Ponteiro para o processador
+ * @param frames Número de frames a amostrar (0 = cancela a calibração)
+ */
+void startCalibration(FrameProcessor *proc, int frames);
+
+/**
+ * @brief Liga, ajusta ou desliga o salto dos frames sem movimento
+ *
+ * Com o detetor ligado, processFrameAt() salta os frames cuja diferença
+ * com o último frame processado não passa de threshold (o relógio do
+ * rastreador avança e as moedas seguidas ficam paradas, ver holdTracks()),
+ * até maxSkip frames seguidos. Nunca salta frames durante a calibração.
+ *
+ * @param proc Ponteiro para o processador
+ * @param threshold Diferença média por amostra que conta como movimento (<= 0 = desliga)
+ * @param maxSkip Máximo de frames seguidos saltados
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int setMotionGate(FrameProcessor *proc, float threshold, int maxSkip);
+
+/**
+ * @brief Liga, ajusta ou desliga a segmentação restrita às regiões alteradas
+ *
+ * Com o modelo ligado, processFrameAt() compara cada frame com o modelo de
+ * fundo e segmenta, limpa e etiqueta só as regiões alteradas (com a
+ * margem das ROIs). O frame completo é processado no primeiro frame,
+ * durante a calibração e quando as alterações cobrem mais de
+ * VC_BG_MAX_COVERAGE do frame.
+ *
+ * @param proc Ponteiro para o processador
+ * @param learningRate Taxa de aprendizagem do fundo (<= 0 = desliga)
+ * @param threshold Diferença de uma amostra que a torna primeiro plano
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int setBackgroundModel(FrameProcessor *proc, float learningRate, int threshold);
+
+/**
+ * @brief Liga, ajusta ou desliga a contagem por passagem numa linha
+ *
+ * Com a linha ligada, processFrameAt() só segmenta a banda à volta da
+ * linha (fora da calibração) e as moedas são contadas quando o centro do
+ * seu blob a atravessa, em vez de serem associadas pelo rastreador. O
+ * modelo de fundo e roiTracking deixam de ser usados.
+ *
+ * @param proc Ponteiro para o processador
+ * @param y Linha de contagem (< 0 = desliga)
+ * @param halfBand Meia altura da banda em pixels (0 = automática)
+ * @param debounce Frames em que uma passagem junto de outra já contada não conta
+ * @return 1 em caso de sucesso, 0 em caso de erro (linha fora do frame)
+ */
+int setTripwire(FrameProcessor *proc, int y, int halfBand, int debounce);
+
+/**
+ * @brief Calibra a escala a partir de uma imagem de referência
+ * @param proc Ponteiro para o processador
+ * @param image Imagem BGR com as dimensões dos frames e várias moedas visíveis
+ * @return Escala em px/mm, ou 0 se a calibração falhar (a tabela fica inalterada)
+ */
+float calibrateFromImage(FrameProcessor *proc, IVC *image);
+
+/**
+ * @brief Ajusta a escala às amostras recolhidas e reescala as denominações
+ * @param proc Ponteiro para o processador
+ * @return Escala em px/mm, ou 0 se a calibração falhar (a tabela fica inalterada)
+ */
+float finishCalibration(FrameProcessor *proc);
+
+/**
+ * @brief Liga, ajusta ou desliga a re-deteção nas ROIs previstas (roiTracking)
+ *
+ * Com a re-deteção ligada, processFrameAt() só segmenta o frame completo
+ * de fullFrameInterval em fullFrameInterval frames; nos restantes segmenta
+ * as ROIs das moedas seguidas e a faixa de entrada, onde aparecem as
+ * moedas novas.
+ *
+ * @param proc Ponteiro para o processador
+ * @param fullFrameInterval Frames entre passagens completas (<= 0 = desliga)
+ * @param entryRows Linhas da faixa de entrada: > 0 as primeiras do frame, < 0 as últimas, 0 nenhuma
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int setRoiTracking(FrameProcessor *proc, int fullFrameInterval, int entryRows);
+
+/**
+ * @brief Escolhe o modo de limiar de uma máscara
+ *
+ * O limiar fixo e o valor inicial dos modos automáticos são os da máscara.
+ * O modo de Otsu é atualizado em cada passagem completa; runPipeline()
+ * recusa-o com mais de uma thread de segmentação.
+ *
+ * @param proc Ponteiro para o processador
+ * @param mask Máscara (VC_MASK_*)
+ * @param mode VC_THRESH_FIXED, VC_THRESH_OTSU ou VC_THRESH_LOCAL
+ * @param localRadius Raio da janela do modo local à resolução total (0 = 1/8 do maior lado do frame)
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int setMaskThreshold(FrameProcessor *proc, int mask, int mode, int localRadius);
+
+/**
+ * @brief Cria um slot de frame com todas as imagens de trabalho
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @return Ponteiro para o slot ou NULL em caso de erro
+ */
+FrameSlot *createFrameSlot(int width, int height);
+
+/**
+ * @brief Liberta um slot de frame
+ * @param slot Ponteiro para o slot
+ * @return NULL após a libertação
+ */
+FrameSlot *freeFrameSlot(FrameSlot *slot);
+
+/**
+ * @brief Estágio de segmentação: limpa as máscaras do slot (rgb já convertido)
+ *
+ * Pode correr em várias threads ao mesmo tempo, em slots diferentes e
+ * com conjuntos de limiares diferentes.
+ *
+ * @param proc Ponteiro para o processador (parâmetros, só lidos)
+ * @param slot Slot com frame e rgb preenchidos
+ * @param reference Slot do frame secundário (NULL ou slot = o próprio frame)
+ * @param thresholds Limiares de cada máscara (VC_NUM_MASKS), atualizados no modo de Otsu
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int segmentSlot(FrameProcessor *proc, FrameSlot *slot, const FrameSlot *reference,
+                ThresholdSelector *thresholds);
+
+/**
+ * @brief Etiqueta as máscaras de um slot segmentado e extrai os blobs
+ * @param slot Slot já segmentado por segmentSlot()
+ * @return Número de blobs da máscara principal
+ */
+int labelSlot(FrameSlot *slot);
+
+/**
+ * @brief Estágio de análise: classifica os blobs do slot e atualiza o rastreador
+ *
+ * Tem de ser chamada pela ordem dos frames. Liberta os blobs do slot.
+ *
+ * @param proc Ponteiro para o processador
+ * @param slot Slot já etiquetado por labelSlot()
+ * @param coinCounts Contadores de cada denominação
+ */
+void analyseSlot(FrameProcessor *proc, FrameSlot *slot, int *coinCounts);
+
+// Modo pipeline (vc_pipeline.cpp)
+/**
+ * @brief Cria um anel de índices de slots
+ * @param capacity Número máximo de índices no anel
+ * @return Ponteiro para o anel ou NULL em caso de erro
+ */
+SlotRing *createSlotRing(int capacity);
+
+/**
+ * @brief Liberta um anel de índices
+ * @param ring Ponteiro para o anel
+ * @return NULL após a libertação
+ */
+SlotRing *freeSlotRing(SlotRing *ring);
+
+/**
+ * @brief Coloca um índice no anel sem esperar (só o produtor)
+ * @return 1 em caso de sucesso, 0 se o anel estiver cheio
+ */
+int ringPush(SlotRing *ring, int index);
+
+/**
+ * @brief Retira o índice mais antigo do anel sem esperar (só o consumidor)
+ * @return 1 em caso de sucesso, 0 se o anel estiver vazio
+ */
+int ringPop(SlotRing *ring, int *index);
+
+/**
+ * @brief Fecha o anel: o consumidor termina depois de o esvaziar
+ */
+void ringClose(SlotRing *ring);
+
+/**
+ * @brief Processa uma sequência em pipeline (leitura, segmentação, análise e visualização)
+ *
+ * Cada estágio corre na sua thread, ligado ao seguinte por uma fila
+ * limitada; a segmentação e a etiquetagem podem correr em várias threads,
+ * cada uma com frames diferentes, e o rastreador é atualizado por uma
+ * única thread, pela ordem dos frames. Os frames de uma calibração em
+ * curso são processados sequencialmente antes de o pipeline arrancar.
+ *
+ * @param proc Ponteiro para o processador
+ * @param callbacks Estágios de leitura e visualização da aplicação
+ * @param depth Número de slots em circulação (<= 0 = VC_PIPELINE_DEPTH)
+ * @param workers Threads de segmentação (1 a VC_PIPELINE_MAX_WORKERS; 1 se alguma máscara usar VC_THRESH_OTSU)
+ * @param coinCounts Contadores de cada denominação
+ * @param stats Tempos por estágio (pode ser NULL)
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int runPipeline(FrameProcessor *proc, const PipelineCallbacks *callbacks, int depth, int workers,
+                int *coinCounts, PipelineStats *stats);
+
+// Processamento por blocos (vc_chunks.cpp)
+/**
+ * @brief Processa um vídeo dividido em blocos de frames, em paralelo
+ *
+ * Cada bloco é uma tarefa de um escalonador com roubo de trabalho, com
+ * uma cópia da configuração de proc e um rastreador próprio, e começa
+ * overlap frames antes do seu início para reconstruir as moedas em
+ * trânsito. Só contam as alterações feitas nos frames do próprio bloco,
+ * pelo que cada moeda é contada uma única vez. Uma calibração em curso em
+ * proc é feita antes, em sequência. O limiar de Otsu é recusado com mais
+ * de um bloco, e o detetor de movimento recomeça em cada bloco.
+ *
+ * @param proc Processador com a configuração (recebe também os totais)
+ * @param callbacks Acesso ao vídeo
+ * @param totalFrames Número de frames do vídeo (<= 0 = desconhecido, um só bloco)
+ * @param chunks Número de blocos (1 a VC_MAX_CHUNKS)
+ * @param overlap Frames de sobreposição (< 0 = VC_CHUNK_OVERLAP; no mínimo a maior janela de memória do rastreador)
+ * @param coinCounts Contadores de cada denominação
+ * @param results Resultado de cada bloco (chunks elementos, pode ser NULL)
+ * @return Número de blocos processados, ou 0 em caso de erro (incluindo VC_THRESH_OTSU com chunks > 1)
+ */
+int processChunks(FrameProcessor *proc, const ChunkCallbacks *callbacks, long long totalFrames,
+                  int chunks, int overlap, int *coinCounts, ChunkResult *results);
+
+// Modo multi-stream (vc_streams.cpp)
+/**
+ * @brief Cria um stream com um processador e frames próprios
+ * @param width Largura dos frames do stream
+ * @param height Altura dos frames do stream
+ * @return Ponteiro para o stream ou NULL em caso de erro
+ */
+VideoStream *createVideoStream(int width, int height);
+
+/**
+ * @brief Liberta um stream e o seu processador (não fecha a origem)
+ * @param stream Ponteiro para o stream
+ * @return NULL após a libertação
+ */
+VideoStream *freeVideoStream(VideoStream *stream);
+
+/**
+ * @brief Processa vários streams ao mesmo tempo num escalonador com roubo de trabalho
+ *
+ * Os frames de cada stream são processados por ordem, um de cada vez, e
+ * as threads rodam pelos streams prontos; as threads sem stream roubam
+ * faixas de linhas da segmentação dos frames em curso.
+ *
+ * @param streams Streams a processar (com read e source definidos)
+ * @param nStreams Número de streams (1 a VC_MAX_STREAMS)
+ * @param workers Threads de trabalho (<= 0 = uma por núcleo)
+ * @return Número de threads de trabalho, ou 0 em caso de erro
+ */
+int runStreams(VideoStream **streams, int nStreams, int workers);
+
+// Escalonador de tarefas (vc_scheduler.cpp)
+/**
+ * @brief Cria um escalonador com as suas threads de trabalho
+ * @param workers Threads de trabalho (<= 0 = uma por núcleo, no máximo VC_SCHED_MAX_WORKERS)
+ * @return Ponteiro para o escalonador ou NULL em caso de erro
+ */
+TaskScheduler *createScheduler(int workers);
+
+/**
+ * @brief Termina as threads de trabalho e liberta o escalonador (sem tarefas pendentes)
+ * @param sched Ponteiro para o escalonador
+ * @return NULL após a libertação
+ */
+TaskScheduler *freeScheduler(TaskScheduler *sched);
+
+/**
+ * @brief Número de threads que executam tarefas do escalonador
+ * @param sched Ponteiro para o escalonador (NULL = execução sequencial)
+ * @return Threads de trabalho, ou 1 se não houver nenhuma
+ */
+int schedulerWorkers(const TaskScheduler *sched);
+
+/**
+ * @brief Cria um grupo de tarefas vazio
+ * @return Ponteiro para o grupo ou NULL em caso de erro
+ */
+TaskGroup *createTaskGroup(void);
+
+/**
+ * @brief Liberta um grupo de tarefas (sem tarefas pendentes)
+ * @param group Ponteiro para o grupo
+ * @return NULL após a libertação
+ */
+TaskGroup *freeTaskGroup(TaskGroup *group);
+
+/**
+ * @brief Submete uma tarefa (numa thread de trabalho, é a próxima que essa thread executa)
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a que a tarefa pertence
+ * @param fn Função da tarefa
+ * @param arg Argumento passado a fn
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int submitTask(TaskScheduler *sched, TaskGroup *group, TaskFunction fn, void *arg);
+
+/**
+ * @brief Submete uma tarefa para depois das que já estão na fila da thread atual
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a que a tarefa pertence
+ * @param fn Função da tarefa
+ * @param arg Argumento passado a fn
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int deferTask(TaskScheduler *sched, TaskGroup *group, TaskFunction fn, void *arg);
+
+/**
+ * @brief Espera pelo fim das tarefas de um grupo, executando as que ainda estejam em fila
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a esperar
+ */
+void waitTaskGroup(TaskScheduler *sched, TaskGroup *group);
+
+/**
+ * @brief Executa fn sobre as linhas [0, height) em faixas paralelas e espera pelo fim
+ *
+ * As faixas têm de poder ser calculadas em qualquer ordem. Sem escalonador,
+ * ou com menos de 2 * minRows linhas, chama fn(arg, 0, height).
+ *
+ * @param sched Ponteiro para o escalonador (NULL = sequencial)
+ * @param height Número de linhas
+ * @param minRows Linhas mínimas de cada faixa
+ * @param fn Função que processa as linhas [y0, y1)
+ * @param arg Argumento passado a fn
+ */
+void parallelRows(TaskScheduler *sched, int height, int minRows, RowFunction fn, void *arg);
+
+// Funções de rastreamento e gestão de moedas
+/**
+ * @brief Cria um rastreador de moedas vazio
+ * @param width Largura dos frames da sequência
+ * @param height Altura dos frames da sequência
+ * @return Ponteiro para o rastreador ou NULL em caso de erro
+ */
+CoinTracker *createTracker(int width, int height);
+
+/**
+ * @brief Liberta um rastreador de moedas
+ * @param tracker Ponteiro para o rastreador
+ * @return NULL após a libertação
+ */
+CoinTracker *freeTracker(CoinTracker *tracker);
+
+int trackCoin(CoinTracker *tracker, int x, int y, int coinType, int countIt);
+
+/**
+ * @brief Coloca uma deteção na fila do frame atual
+ * @param tracker Ponteiro para o rastreador
+ * @param detection Deteção a copiar
+ */
+void addDetection(CoinTracker *tracker, const CoinDetection *detection);
+
+/**
+ * @brief Associa as deteções do frame às moedas rastreadas e conta as novas
+ * @param tracker Ponteiro para o rastreador
+ * @param counters Contadores por tipo de moeda
+ * @return Número de moedas cuja denominação foi confirmada e contabilizada
+ */
+int commitDetections(CoinTracker *tracker, int *counters);
+
+/**
+ * @brief Denominação de uma moeda já contada e estável junto a (x, y)
+ *
+ * Os blobs destas moedas não precisam de ser reclassificados: basta
+ * atualizar a posição com uma deteção de peso 0.
+ *
+ * @param tracker Ponteiro para o rastreador
+ * @param x Coordenada X do blob
+ * @param y Coordenada Y do blob
+ * @return Tipo de moeda (1 a 8), ou 0 se não houver nenhuma
+ */
+int stableCoinType(CoinTracker *tracker, int x, int y);
+
+/**
+ * @brief Atualiza a posição prevista de todas as moedas para o frame atual
+ * @param tracker Ponteiro para o rastreador
+ */
+void predictTracks(CoinTracker *tracker);
+
+/**
+ * @brief Calcula as ROIs em torno da posição prevista de todas as moedas seguidas
+ * @param tracker Ponteiro para o rastreador
+ * @param margin Margem além do raio e do deslocamento previsto da moeda
+ * @param regions Array onde escrever as ROIs (não recortadas ao frame)
+ * @param maxRegions Tamanho de regions
+ * @return Número de ROIs escritas
+ */
+int trackedRegions(CoinTracker *tracker, int margin, ImageRegion *regions, int maxRegions);
+int excludeCoin(CoinTracker *tracker, int xc, int yc, int option);
+
+/**
+ * @brief Remove as entradas expiradas e compacta as tabelas do rastreador
+ *
+ * É chamada por advanceClock() a cada VC_TRACKER_SWEEP_INTERVAL frames.
+ * @param tracker Ponteiro para o rastreador
+ */
+void maintainTracker(CoinTracker *tracker);
+
+/**
+ * @brief Verifica se há um ponto de exclusão a menos de params.exclusionRadius pixels de (xc, yc)
+ * @return true se a posição já foi analisada
+ */
+bool isExcludedCoin(CoinTracker *tracker, int xc, int yc);
+void frameCounter(CoinTracker *tracker, int reset);
+
+/**
+ * @brief Avança o relógio do rastreador um frame
+ * @param tracker Ponteiro para o rastreador
+ * @param timestampMs Tempo de captura do frame em ms (negativo = derivar de nominalFps)
+ */
+void advanceClock(CoinTracker *tracker, long long timestampMs);
+
+/**
+ * @brief Mantém as moedas seguidas onde foram vistas, num frame sem movimento
+ *
+ * Chamada depois de advanceClock() nos frames saltados pelo detetor de
+ * movimento: anula a velocidade e passa a última observação para o frame
+ * atual, para que as previsões não se afastem de moedas paradas.
+ * @param tracker Ponteiro para o rastreador
+ */
+void holdTracks(CoinTracker *tracker);
+
+/**
+ * @brief Define as janelas de memória do rastreador
+ * @param tracker Ponteiro para o rastreador
+ * @param unit VC_WINDOW_FRAMES ou VC_WINDOW_MS
+ * @param coinWindow Memória das moedas de cêntimo
+ * @param euroWindow Memória das moedas de Euro
+ * @param excludeWindow Memória dos pontos de exclusão
+ */
+void setTrackerWindows(CoinTracker *tracker, int unit, long long coinWindow,
+                       long long euroWindow, long long excludeWindow);
+
+long long getFrameCount(CoinTracker *tracker);
+long long getTimestampMs(CoinTracker *tracker);
+int getCoinTypeAtLocation(CoinTracker *tracker, int x, int y);
+
+// Especificação das moedas
+/**
+ * @brief Preenche uma tabela com as moedas de Euro de referência
+ * @param table Tabela a preencher
+ */
+void defaultCoinSpecs(CoinSpecTable *table);
+
+/**
+ * @brief Lê a especificação das moedas de um ficheiro de texto
+ *
+ * Cada linha não vazia que não comece por '#' define uma denominação:
+ * nome valor diâmetro diâmetro_mm classe tolerância circularidade margem
+ * texto, em que classe é copper, gold ou euro e texto vai até ao fim da linha.
+ * Os diâmetros e margens em pixels são os da resolução de referência (ver
+ * setCoinSpecs()). A tabela só é alterada se o ficheiro for válido.
+ *
+ * @param table Tabela a preencher
+ * @param filename Caminho do ficheiro
+ * @return Número de denominações lidas, ou 0 em caso de erro
+ */
+int loadCoinSpecs(CoinSpecTable *table, const char *filename);
+
+/**
+ * @brief Reconstrói os índices por classe de cor depois de alterar table->specs
+ * @param table Tabela de denominações
+ */
+void indexCoinSpecs(CoinSpecTable *table);
+
+/**
+ * @brief Especificação de um tipo de moeda
+ * @param table Tabela de denominações
+ * @param coinType Tipo de moeda (1 a table->nSpecs)
+ * @return Ponteiro para a especificação, ou NULL se o tipo não existir
+ */
+const CoinSpec *getCoinSpec(const CoinSpecTable *table, int coinType);
+
+/**
+ * @brief Classifica uma moeda pelo diâmetro dentro de uma classe de cor
+ * @param table Tabela de denominações
+ * @param colorClass Classe de cor (VC_MASK_COPPER, VC_MASK_GOLD ou VC_MASK_EURO)
+ * @param diameter Diâmetro medido
+ * @param toleranceScale Fator aplicado às tolerâncias (1 = nominais)
+ * @param nearest Se diferente de 0, devolve a denominação mais próxima mesmo fora da tolerância
+ * @return Tipo de moeda, ou 0 se nenhuma denominação corresponder
+ */
+int classifyCoin(const CoinSpecTable *table, int colorClass, float diameter, float toleranceScale, int nearest);
+
+/**
+ * @brief Escala (px/mm) implícita nos diâmetros atuais da tabela
+ * @param table Tabela de denominações
+ * @return Mediana de diâmetro / diâmetro real, ou 0 se nenhuma denominação tiver diâmetro real
+ */
+float coinSpecScale(const CoinSpecTable *table);
+
+/**
+ * @brief Recalcula os diâmetros e as margens de borda para uma nova escala
+ * @param table Tabela de denominações
+ * @param pxPerMm Nova escala em pixels por mm
+ */
+void scaleCoinSpecs(CoinSpecTable *table, float pxPerMm);
+
+/**
+ * @brief Ajusta a escala (px/mm) que melhor explica os diâmetros observados
+ * @param table Tabela de denominações (com diâmetros reais)
+ * @param diameters Diâmetros observados em pixels
+ * @param classes Classe de cor de cada amostra
+ * @param n Número de amostras
+ * @return Escala em px/mm, ou 0 se as amostras não forem suficientes
+ */
+float fitPixelScale(const CoinSpecTable *table, const float *diameters, const int *classes, int n);
+
+/**
+ * @brief Multiplica todos os diâmetros e margens de borda da tabela por factor
+ * @param table Tabela de denominações
+ * @param factor Fator de escala linear
+ */
+void resizeCoinSpecs(CoinSpecTable *table, float factor);
+
+// Parâmetros espaciais
+/**
+ * @brief Deriva os parâmetros espaciais para um fator de escala
+ * @param params Parâmetros a preencher
+ * @param scale Fator linear em relação à montagem de referência
+ */
+void derivePipelineParams(PipelineParams *params, float scale);
+
+/**
+ * @brief Recalcula tracker->params (e tracker->maxSpeed) a partir da escala da tabela
+ *
+ * Deve ser chamada sempre que os diâmetros de tracker->specs mudam.
+ *
+ * @param tracker Rastreador de moedas
+ */
+void updatePipelineParams(CoinTracker *tracker);
+
+/**
+ * @brief Usa uma tabela de denominações definida à resolução de referência
+ *
+ * Copia a tabela, converte os diâmetros e margens para a altura dos frames
+ * do rastreador e atualiza os parâmetros espaciais.
+ *
+ * @param tracker Rastreador de moedas
+ * @param table Tabela com diâmetros para frames de VC_REFERENCE_HEIGHT linhas
+ */
+void setCoinSpecs(CoinTracker *tracker, const CoinSpecTable *table);
 
 // Funções de análise de moedas
 float getCircularity(OVC *blob);
 float getDiameter(OVC *blob);
-float adaptTolerance(int xc, int yc, int frameWidth, int frameHeight);
+float adaptTolerance(int xc, int yc, int frameWidth, int frameHeight, int edgeMargin);
 
 // Função de desenho de moedas
-void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
+void drawCoins(CoinTracker *tracker, IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
               int nGoldBlobs, int nCopperBlobs, int nEuroBlobs);
 
 // Funções de utilidade para visão computacional
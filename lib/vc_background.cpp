@@ -0,0 +1,299 @@
+/**
+ * @file vc_background.cpp
+ * @brief Modelo de fundo e regiões alteradas de uma câmara fixa.
+ *
+ * O fundo é a média móvel de cada amostra (pixel e canal) de uma versão
+ * reduzida dos frames. Cada frame é comparado com o modelo antes de o
+ * atualizar: as amostras que diferem mais do que o limiar são primeiro
+ * plano e aprendem com uma taxa muito menor, para que uma moeda a passar
+ * não se funda no fundo, mas um objeto que fique parado (ou o tapete
+ * descoberto por uma moeda que estava no primeiro frame) acabe por ser
+ * absorvido. As caixas dos componentes da máscara de primeiro plano, à
+ * resolução dos frames e com uma margem, são as regiões a segmentar.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vc.h"
+#include "vc_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Garante espaço para n regiões
+static int reserveRegions(BackgroundModel *bg, int n) {
+    if (n <= bg->regionCapacity) return 1;
+
+    const int capacity = VC_MAX(n, 2 * bg->regionCapacity);
+    ImageRegion *regions = (ImageRegion *)realloc(bg->regions, capacity * sizeof(ImageRegion));
+    if (regions == NULL) return 0;
+
+    bg->regions = regions;
+    bg->regionCapacity = capacity;
+    return 1;
+}
+
+// Funde as regiões que se sobrepõem ou tocam (cada moeda fica numa só região)
+static int mergeRegions(ImageRegion *regions, int n) {
+    int i, j, merged = 1;
+
+    while (merged) {
+        merged = 0;
+        for (i = 0; i < n; i++) {
+            for (j = i + 1; j < n; j++) {
+                ImageRegion *a = &regions[i];
+                const ImageRegion *b = &regions[j];
+                if (a->x > b->x + b->width || b->x > a->x + a->width ||
+                    a->y > b->y + b->height || b->y > a->y + a->height)
+                    continue;
+
+                const int x1 = VC_MAX(a->x + a->width, b->x + b->width);
+                const int y1 = VC_MAX(a->y + a->height, b->y + b->height);
+                a->x = VC_MIN(a->x, b->x);
+                a->y = VC_MIN(a->y, b->y);
+                a->width = x1 - a->x;
+                a->height = y1 - a->y;
+
+                regions[j--] = regions[--n];
+                merged = 1;
+            }
+        }
+    }
+
+    return n;
+}
+
+/**
+ * @brief Cria um modelo de fundo para frames com as dimensões dadas
+ *
+ * O modelo usa o nível VC_BG_LEVEL da pirâmide (ou o mais fino possível
+ * em frames pequenos), as taxas de aprendizagem VC_BG_LEARNING_RATE e
+ * VC_BG_FOREGROUND_RATE e o limiar VC_BG_THRESHOLD. Fica vazio até ao
+ * primeiro frame.
+ *
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param channels Canais dos frames
+ * @return Ponteiro para o modelo ou NULL em caso de erro
+ */
+BackgroundModel *createBackgroundModel(int width, int height, int channels) {
+    BackgroundModel *bg;
+    int level = VC_BG_LEVEL;
+
+    if (width <= 0 || height <= 0 || channels <= 0) return NULL;
+
+    while (level > 0 && ((width >> level) < 8 || (height >> level) < 8)) level--;
+
+    bg = (BackgroundModel *)calloc(1, sizeof(BackgroundModel));
+    if (bg == NULL) return NULL;
+
+    const int w = width >> level, h = height >> level;
+
+    bg->width = width;
+    bg->height = height;
+    bg->level = level;
+    bg->learningRate = VC_BG_LEARNING_RATE;
+    bg->foregroundRate = VC_BG_FOREGROUND_RATE;
+    bg->threshold = VC_BG_THRESHOLD;
+    bg->pyramid = createPyramid(width, height, channels, level + 1);
+    bg->mean = (float *)malloc((size_t)w * h * channels * sizeof(float));
+    bg->changed = (unsigned char *)malloc((size_t)w * h * channels + 16);
+    bg->mask = createImage(w, h, 1, 255);
+    bg->labels = createImage(w, h, 1, 255);
+
+    if (!bg->pyramid || !bg->mean || !bg->changed || !bg->mask || !bg->labels)
+        return freeBackgroundModel(bg);
+
+    return bg;
+}
+
+/**
+ * @brief Liberta um modelo de fundo
+ * @param bg Ponteiro para o modelo
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+BackgroundModel *freeBackgroundModel(BackgroundModel *bg) {
+    if (bg != NULL) {
+        if (bg->pyramid) freePyramid(bg->pyramid);
+        if (bg->mean) free(bg->mean);
+        if (bg->changed) free(bg->changed);
+        if (bg->mask) freeImage(bg->mask);
+        if (bg->labels) freeImage(bg->labels);
+        if (bg->regions) free(bg->regions);
+        free(bg);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Compara um frame com o modelo de fundo e atualiza o modelo
+ *
+ * Reduz o frame e, para cada amostra, marca-a como alterada se
+ * |amostra - média| > bg->threshold e atualiza a média com
+ * média += taxa * (amostra - média), com bg->foregroundRate nas amostras
+ * alteradas e bg->learningRate nas restantes. Um pixel é primeiro plano
+ * (255 em bg->mask) se algum dos seus canais foi alterado; bg->coverage é
+ * a fração de pixels de primeiro plano. A comparação e a atualização usam
+ * SSE2 em blocos de 16 amostras. O primeiro frame só inicializa o modelo.
+ *
+ * @param bg Modelo de fundo
+ * @param frame Frame com as dimensões do modelo
+ * @return 1 se bg->mask é válida para este frame, 0 se o modelo foi inicializado ou em caso de erro
+ */
+int updateBackground(BackgroundModel *bg, IVC *frame) {
+    IVC *small;
+    int i, x, y, c;
+
+    if (bg == NULL || frame == NULL) return 0;
+    if (frame->width != bg->width || frame->height != bg->height) return 0;
+    if (!buildPyramid(frame, bg->pyramid)) return 0;
+
+    small = bg->pyramid->levels[bg->level];
+    const int channels = small->channels;
+    const int samples = small->width * small->height * channels;
+    const unsigned char *data = small->data;
+    float *mean = bg->mean;
+
+    bg->coverage = 0.0f;
+    bg->nRegions = 0;
+    bg->regionPixels = 0;
+
+    if (!bg->initialised) {
+        for (i = 0; i < samples; i++) mean[i] = (float)data[i];
+        memset(bg->mask->data, 0, bg->mask->bytesperline * bg->mask->height);
+        bg->initialised = 1;
+        return 0;
+    }
+
+    i = 0;
+#ifdef VC_SIMD_SSE2
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 threshold = _mm_set1_ps((float)bg->threshold);
+        const __m128 bgRate = _mm_set1_ps(bg->learningRate);
+        const __m128 fgRate = _mm_set1_ps(bg->foregroundRate);
+
+        for (; i + 16 <= samples; i += 16) {
+            const __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+            const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+            const __m128i ints[4] = {
+                _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+            };
+            __m128i fg[4];
+
+            for (int k = 0; k < 4; k++) {
+                const __m128 value = _mm_cvtepi32_ps(ints[k]);
+                const __m128 m = _mm_loadu_ps(mean + i + 4 * k);
+                const __m128 diff = _mm_sub_ps(value, m);
+                const __m128 changed = _mm_cmpgt_ps(_mm_and_ps(diff, absMask), threshold);
+                const __m128 rate = _mm_or_ps(_mm_and_ps(changed, fgRate), _mm_andnot_ps(changed, bgRate));
+                _mm_storeu_ps(mean + i + 4 * k, _mm_add_ps(m, _mm_mul_ps(rate, diff)));
+                fg[k] = _mm_castps_si128(changed);
+            }
+
+            // Máscaras de 32 bits (0 ou -1) reduzidas a um byte por amostra
+            const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(fg[0], fg[1]), _mm_packs_epi32(fg[2], fg[3]));
+            _mm_storeu_si128((__m128i *)(bg->changed + i), packed);
+        }
+    }
+#endif
+    for (; i < samples; i++) {
+        const float diff = (float)data[i] - mean[i];
+        const int changed = (diff > (float)bg->threshold || -diff > (float)bg->threshold);
+        mean[i] += (changed ? bg->foregroundRate : bg->learningRate) * diff;
+        bg->changed[i] = changed ? 0xff : 0;
+    }
+
+    // Um pixel é primeiro plano se algum canal foi alterado
+    long int foreground = 0;
+    for (y = 0; y < small->height; y++) {
+        const unsigned char *src = bg->changed + (long int)y * small->width * channels;
+        unsigned char *dst = bg->mask->data + (long int)y * bg->mask->bytesperline;
+        for (x = 0; x < small->width; x++) {
+            unsigned char any = 0;
+            for (c = 0; c < channels; c++) any |= src[x * channels + c];
+            dst[x] = any ? 255 : 0;
+            foreground += (any != 0);
+        }
+    }
+    bg->coverage = (float)foreground / (float)(small->width * small->height);
+
+    return 1;
+}
+
+/**
+ * @brief Calcula as regiões alteradas do último frame à resolução dos frames
+ *
+ * Dilata a máscara de primeiro plano (3x3), etiqueta-a e, para cada
+ * componente com pelo menos VC_BG_MIN_AREA pixels do nível reduzido,
+ * escala a caixa para a resolução dos frames e junta-lhe margin pixels de
+ * cada lado. As regiões são recortadas ao frame e as que se sobrepõem são
+ * fundidas. O resultado fica em bg->regions e bg->nRegions, e a soma das
+ * suas áreas em bg->regionPixels.
+ *
+ * @param bg Modelo de fundo (depois de updateBackground())
+ * @param margin Margem em pixels à resolução dos frames
+ * @return Número de regiões, ou -1 em caso de erro
+ */
+int changeRegions(BackgroundModel *bg, int margin) {
+    OVC *blobs;
+    int nblobs = 0, n = 0, i;
+
+    if (bg == NULL || !bg->initialised) return -1;
+
+    const int scale = 1 << bg->level;
+    bg->nRegions = 0;
+    bg->regionPixels = 0;
+
+    // A dilatação junta os fragmentos da mesma moeda antes da etiquetagem
+    if (!binaryDilate(bg->mask, bg->labels, 3, 0, bg->mask->height)) return -1;
+
+    blobs = blobLabel(bg->labels, bg->labels, &nblobs);
+    if (blobs == NULL || nblobs <= 0) {
+        if (blobs) free(blobs);
+        return 0;
+    }
+    blobInfo(bg->labels, blobs, nblobs);
+
+    if (!reserveRegions(bg, nblobs)) {
+        free(blobs);
+        return -1;
+    }
+
+    for (i = 0; i < nblobs; i++) {
+        if (blobs[i].area < VC_BG_MIN_AREA) continue;
+
+        const int x0 = VC_MAX(0, blobs[i].x * scale - margin);
+        const int y0 = VC_MAX(0, blobs[i].y * scale - margin);
+        const int x1 = VC_MIN(bg->width, (blobs[i].x + blobs[i].width) * scale + margin);
+        const int y1 = VC_MIN(bg->height, (blobs[i].y + blobs[i].height) * scale + margin);
+        if (x1 - x0 < 3 || y1 - y0 < 3) continue;
+
+        bg->regions[n].x = x0;
+        bg->regions[n].y = y0;
+        bg->regions[n].width = x1 - x0;
+        bg->regions[n].height = y1 - y0;
+        n++;
+    }
+    free(blobs);
+
+    bg->nRegions = mergeRegions(bg->regions, n);
+    for (i = 0; i < bg->nRegions; i++)
+        bg->regionPixels += (long long)bg->regions[i].width * bg->regions[i].height;
+
+    return bg->nRegions;
+}
+
+#ifdef __cplusplus
+}
+#endif
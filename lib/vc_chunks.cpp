@@ -0,0 +1,285 @@
+/**
+ * @file vc_chunks.cpp
+ * @brief Processamento de um vídeo gravado em blocos de frames paralelos.
+ *
+ * O vídeo é dividido em blocos consecutivos e cada bloco é uma tarefa do
+ * escalonador com roubo de trabalho (vc_scheduler.cpp), com a sua leitura,
+ * o seu processador e o seu rastreador. O escalonador tem uma thread por
+ * bloco e os processadores dos blocos dividem a segmentação em faixas de
+ * linhas no mesmo escalonador: as threads dos blocos que terminam primeiro
+ * (menos moedas, menos segmentação de cor) roubam faixas dos restantes.
+ * Para que as moedas que atravessam a fronteira entre dois blocos sejam
+ * contadas uma única vez, cada bloco começa uma janela de sobreposição
+ * antes do seu primeiro frame: nesses frames o rastreador reconstrói as
+ * moedas em trânsito (e conta as que o bloco anterior já contou), mas só
+ * as alterações das contagens feitas a partir do primeiro frame do bloco
+ * entram no total. Os relógios do rastreador seguem o índice global dos
+ * frames e frame2 é atualizado nos mesmos frames que no modo sequencial,
+ * pelo que, com uma sobreposição maior do que o tempo que uma moeda fica
+ * à vista, cada bloco conta o mesmo que a execução sequencial nos seus
+ * frames. Não é assim com o limiar de Otsu, cujo calendário de cálculo
+ * recomeçaria em cada bloco (e que por isso é recusado com mais de um
+ * bloco), nem exatamente com o detetor de movimento: o frame de
+ * referência e a cadeia de frames saltados também recomeçam no início da
+ * sobreposição de cada bloco.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "vc.h"
+
+typedef std::chrono::steady_clock ChunkClock;
+
+// Tarefa de um bloco no escalonador
+typedef struct {
+    const FrameProcessor *config;
+    const ChunkCallbacks *callbacks;
+    TaskScheduler *sched;
+    long long readStart;
+    ChunkResult *result;
+} ChunkTask;
+
+// Lê frames a partir de readStart e processa os de [start, result->endFrame)
+static void runChunk(void *arg) {
+    const ChunkTask *task = (const ChunkTask *)arg;
+    const FrameProcessor *config = task->config;
+    const ChunkCallbacks *callbacks = task->callbacks;
+    const long long readStart = task->readStart;
+    ChunkResult *result = task->result;
+    const ChunkClock::time_point begin = ChunkClock::now();
+    const long long start = result->firstFrame - result->leadIn;
+    int counts[VC_MAX_COIN_TYPES] = {0}, base[VC_MAX_COIN_TYPES] = {0};
+    long long skippedBase = 0;
+    void *stream = NULL;
+    long long k;
+
+    FrameProcessor *proc = cloneFrameProcessor(config);
+    IVC *frame = proc ? createImage(proc->width, proc->height, 3, 255) : NULL;
+    IVC *frame2 = proc ? createImage(proc->width, proc->height, 3, 255) : NULL;
+    if (proc && frame && frame2)
+        stream = callbacks->open(callbacks->user, readStart);
+
+    if (stream != NULL) {
+        // As faixas da segmentação entram no escalonador dos blocos
+        proc->scheduler = task->sched;
+        // Os registos de várias threads misturar-se-iam
+        proc->tracker->verbose = 0;
+        // O frame k avança o relógio para k + 1, como na execução sequencial
+        proc->tracker->frameIndex = start;
+
+        for (k = readStart; result->endFrame < 0 || k < result->endFrame; k++) {
+            long long timestampMs = -1;
+            if (!callbacks->read(stream, frame, &timestampMs)) break;
+
+            // frame2 é atualizado nos mesmos frames que no modo sequencial
+            if (k % VC_FRAME2_INTERVAL == 0)
+                memcpy(frame2->data, frame->data, frame->bytesperline * frame->height);
+            if (k < start) continue;
+
+            if (k == result->firstFrame) {
+                memcpy(base, counts, sizeof(counts));
+                if (proc->motion) skippedBase = proc->motion->skippedFrames;
+            }
+            processFrameAt(proc, frame, frame2, counts, timestampMs);
+            result->frames++;
+        }
+
+        // Um bloco que termina antes do seu primeiro frame não contribui
+        if (k > result->firstFrame) {
+            for (int i = 0; i < VC_MAX_COIN_TYPES; i++)
+                result->counts[i] = counts[i] - base[i];
+            if (proc->motion) result->skipped = proc->motion->skippedFrames - skippedBase;
+        }
+
+        callbacks->close(stream);
+        result->ok = 1;
+    }
+
+    if (frame) freeImage(frame);
+    if (frame2) freeImage(frame2);
+    freeFrameProcessor(proc);
+    result->seconds = std::chrono::duration<double>(ChunkClock::now() - begin).count();
+}
+
+// Faz em sequência, no processador de referência, a calibração em curso; devolve o primeiro frame a contar
+static long long calibrateChunks(FrameProcessor *proc, const ChunkCallbacks *callbacks, int *coinCounts) {
+    long long k = 0;
+
+    if (proc->calibration.frames <= 0) return 0;
+
+    void *stream = callbacks->open(callbacks->user, 0);
+    IVC *frame = createImage(proc->width, proc->height, 3, 255);
+    IVC *frame2 = createImage(proc->width, proc->height, 3, 255);
+
+    if (stream && frame && frame2) {
+        while (proc->calibration.frames > 0) {
+            long long timestampMs = -1;
+            if (!callbacks->read(stream, frame, &timestampMs)) break;
+
+            if (k % VC_FRAME2_INTERVAL == 0)
+                memcpy(frame2->data, frame->data, frame->bytesperline * frame->height);
+            processFrameAt(proc, frame, frame2, coinCounts, timestampMs);
+            k++;
+        }
+    }
+
+    // Vídeo mais curto do que a calibração (ou sem leitura): ajusta com o que houver
+    if (proc->calibration.frames > 0) finishCalibration(proc);
+
+    if (stream) callbacks->close(stream);
+    if (frame) freeImage(frame);
+    if (frame2) freeImage(frame2);
+
+    return k;
+}
+
+// Maior janela de memória do rastreador, em frames (as janelas em ms são convertidas pela cadência nominal)
+static long long trackerMemoryFrames(const CoinTracker *tracker) {
+    long long window = VC_MAX(VC_MAX(tracker->coinWindow, tracker->euroWindow), tracker->excludeWindow);
+
+    if (tracker->windowUnit == VC_WINDOW_MS) {
+        const double fps = (tracker->nominalFps > 0.0) ? tracker->nominalFps : 30.0;
+        window = (long long)(window * fps / 1000.0 + 0.999);
+    }
+    return window;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Processa um vídeo dividido em blocos de frames, em paralelo
+ *
+ * Os frames a contar (a seguir aos de uma calibração em curso) são
+ * divididos em chunks blocos de tamanho igual; o último vai até ao fim do
+ * vídeo, mesmo que totalFrames seja uma estimativa por defeito. Cada bloco
+ * processa min(overlap, frames anteriores) frames antes do seu início, com
+ * o rastreador a contar normalmente, e entra no total só com a variação
+ * das contagens a partir do seu primeiro frame; as revisões de
+ * denominação de moedas contadas na sobreposição entram assim no bloco em
+ * que acontecem. Os blocos não registam as moedas nem os resumos
+ * periódicos.
+ *
+ * Uma sobreposição menor do que a maior janela de memória do rastreador
+ * deixaria o bloco seguinte voltar a contar as moedas que o anterior
+ * contou perto da fronteira, pelo que é aumentada para essa janela (com
+ * um aviso). Com mais de um bloco, uma máscara com VC_THRESH_OTSU é
+ * recusada: cada bloco recomeçaria o calendário de cálculo do limiar na
+ * sua sobreposição, e o limiar no primeiro frame do bloco viria de outro
+ * histograma que não o da execução sequencial. O detetor de movimento
+ * também recomeça em cada bloco, pelo que os frames saltados logo a
+ * seguir a uma fronteira podem não ser os da execução sequencial.
+ *
+ * Os blocos são tarefas de um escalonador com uma thread por bloco; se
+ * não for possível criar as threads, a thread que chamou a função
+ * processa os blocos que ficarem em fila.
+ *
+ * @param proc Processador com a configuração; recebe os totais em tracker->countedByType
+ * @param callbacks Acesso ao vídeo
+ * @param totalFrames Número de frames do vídeo (<= 0 = desconhecido, um só bloco)
+ * @param chunks Número de blocos (1 a VC_MAX_CHUNKS)
+ * @param overlap Frames de sobreposição (< 0 = VC_CHUNK_OVERLAP; no mínimo a memória do rastreador)
+ * @param coinCounts Array com contadores para cada tipo de moeda
+ * @param results Resultado de cada bloco (chunks elementos, pode ser NULL)
+ * @return Número de blocos processados, ou 0 em caso de erro (incluindo VC_THRESH_OTSU com chunks > 1)
+ */
+int processChunks(FrameProcessor *proc, const ChunkCallbacks *callbacks, long long totalFrames,
+                  int chunks, int overlap, int *coinCounts, ChunkResult *results) {
+    ChunkResult *chunk;
+    ChunkTask *tasks;
+    TaskScheduler *sched, *saved;
+    TaskGroup *group;
+    long long first, length;
+    const int requested = chunks;
+    int i, t, done = 0;
+
+    if (!proc || !callbacks || !callbacks->open || !callbacks->read || !callbacks->close || !coinCounts)
+        return 0;
+    if (chunks < 1 || chunks > VC_MAX_CHUNKS) return 0;
+    for (i = 0; chunks > 1 && i < VC_NUM_MASKS; i++) {
+        if (proc->thresholds[i].mode == VC_THRESH_OTSU) {
+            fprintf(stderr, "Erro: o limiar de Otsu (máscara %d) não é determinístico com %d blocos\n", i, chunks);
+            return 0;
+        }
+    }
+    if (overlap < 0) overlap = VC_CHUNK_OVERLAP;
+    const long long memory = trackerMemoryFrames(proc->tracker);
+    if (chunks > 1 && overlap < memory) {
+        fprintf(stderr, "Aviso: sobreposição de %d frames menor do que a memória do rastreador; usados %lld frames\n",
+                overlap, memory);
+        overlap = (int)memory;
+    }
+
+    chunk = (ChunkResult *)calloc(chunks, sizeof(ChunkResult));
+    tasks = (ChunkTask *)calloc(chunks, sizeof(ChunkTask));
+    sched = createScheduler(chunks);
+    group = createTaskGroup();
+    if (!chunk || !tasks || !sched || !group) {
+        free(chunk);
+        free(tasks);
+        freeScheduler(sched);
+        freeTaskGroup(group);
+        return 0;
+    }
+
+    // A calibração também divide a segmentação em faixas no escalonador
+    saved = proc->scheduler;
+    proc->scheduler = sched;
+    first = calibrateChunks(proc, callbacks, coinCounts);
+    proc->scheduler = saved;
+
+    // Sem o número de frames não há fronteiras: um só bloco até ao fim
+    if (totalFrames <= first) chunks = 1;
+    length = (chunks > 1) ? (totalFrames - first + chunks - 1) / chunks : 0;
+
+    for (i = 0; i < chunks; i++) {
+        chunk[i].firstFrame = first + i * length;
+        chunk[i].endFrame = (i == chunks - 1) ? -1 : chunk[i].firstFrame + length;
+        chunk[i].leadIn = VC_MIN((long long)overlap, chunk[i].firstFrame - first);
+    }
+
+    // O início da leitura é alinhado ao intervalo de frame2 (os frames anteriores a leadIn só são lidos)
+    for (i = 0; i < chunks; i++) {
+        const long long start = chunk[i].firstFrame - chunk[i].leadIn;
+        ChunkTask task = { proc, callbacks, sched, start - start % VC_FRAME2_INTERVAL, &chunk[i] };
+        tasks[i] = task;
+        submitTask(sched, group, runChunk, &tasks[i]);
+    }
+    waitTaskGroup(sched, group);
+
+    for (i = 0; i < chunks; i++) {
+        if (!chunk[i].ok) {
+            fprintf(stderr, "Erro: não foi possível processar o bloco %d (frame %lld)\n", i, chunk[i].firstFrame);
+            continue;
+        }
+
+        for (t = 0; t < VC_MAX_COIN_TYPES; t++) {
+            coinCounts[t] += chunk[i].counts[t];
+            proc->tracker->countedByType[t] += chunk[i].counts[t];
+        }
+        done++;
+    }
+
+    if (results) {
+        memset(results, 0, requested * sizeof(ChunkResult));
+        memcpy(results, chunk, chunks * sizeof(ChunkResult));
+    }
+    free(chunk);
+    free(tasks);
+    freeScheduler(sched);
+    freeTaskGroup(group);
+
+    return done;
+}
+
+#ifdef __cplusplus
+}
+#endif
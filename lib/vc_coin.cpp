@@ -18,40 +18,303 @@
 extern "C" {
 #endif
 
-// Constants for coin diameters (in pixels) - renamed for consistency
-const float DIAM_1CENT = 122.0f;
-const float DIAM_2CENT = 135.0f;
-const float DIAM_5CENT = 152.0f;
-const float DIAM_10CENT = 143.0f;
-const float DIAM_20CENT = 160.0f;
-const float DIAM_50CENT = 174.0f;
-const float DIAM_1EURO = 185.0f;
-const float DIAM_2EURO = 195.0f;
+// Reference diameter tolerance; adaptTolerance() widens it near the edges
 const float BASE_TOLERANCE = 0.08f;
 
-// Global variables for coin tracking
-static int frameCountValue = 0;  // Renamed to avoid conflict
-int MAX_TRACKED_COINS = 150;
-int detectedCoins[150][5] = {{0}}; // [x, y, coinType, frameDetected, counted]
+// Whether a coin type belongs to a colour class of the tracker's specs
+static inline bool typeInClass(const CoinTracker *tracker, int coinType, int colorClass) {
+    const CoinSpec *spec = getCoinSpec(&tracker->specs, coinType);
+    return spec != NULL && spec->colorClass == colorClass;
+}
+
+static inline bool isEuroType(const CoinTracker *tracker, int coinType) {
+    return typeInClass(tracker, coinType, VC_MASK_EURO);
+}
+
+// How long a tracked coin is remembered without being seen again
+static inline long long coinMemory(const CoinTracker *tracker, int coinType) {
+    return isEuroType(tracker, coinType) ? tracker->euroWindow : tracker->coinWindow;
+}
+
+// Time since an entry was last seen, in the unit of the tracker windows.
+// The clock is monotonic, so this is never negative.
+static inline long long entryAge(const CoinTracker *tracker, long long frame, long long timeMs) {
+    return (tracker->windowUnit == VC_WINDOW_MS) ? tracker->timestampMs - timeMs
+                                                 : tracker->frameIndex - frame;
+}
+
+// A coin is active while it is alive and within its memory window
+static inline bool coinIsActive(const CoinTracker *tracker, const TrackedCoin *coin) {
+    return coin->alive &&
+           entryAge(tracker, coin->lastFrame, coin->lastTimeMs) < coinMemory(tracker, coin->type);
+}
+
+static inline bool exclusionIsActive(const CoinTracker *tracker, const ExclusionPoint *point) {
+    return point->alive &&
+           entryAge(tracker, point->lastFrame, point->lastTimeMs) < tracker->excludeWindow;
+}
+
+// Make room for at least `needed` entries in the candidate buffer
+static int reserveCandidates(CoinTracker *tracker, int needed) {
+    if (needed <= tracker->candidateCapacity) return 1;
+
+    int *buffer = (int *)realloc(tracker->candidates, needed * sizeof(int));
+    if (buffer == NULL) return 0;
+
+    tracker->candidates = buffer;
+    tracker->candidateCapacity = needed;
+    return 1;
+}
+
+// Resize the coin table (and its grid) to `capacity` entries
+static int resizeCoins(CoinTracker *tracker, int capacity) {
+    TrackedCoin *coins = (TrackedCoin *)realloc(tracker->coins, capacity * sizeof(TrackedCoin));
+    if (coins == NULL) return 0;
+
+    tracker->coins = coins;
+    tracker->coinCapacity = capacity;
+    return gridReserve(tracker->coinGrid, capacity) && reserveCandidates(tracker, capacity);
+}
+
+static int resizeExcluded(CoinTracker *tracker, int capacity) {
+    ExclusionPoint *points = (ExclusionPoint *)realloc(tracker->excluded, capacity * sizeof(ExclusionPoint));
+    if (points == NULL) return 0;
+
+    tracker->excluded = points;
+    tracker->excludedCapacity = capacity;
+    return gridReserve(tracker->excludeGrid, capacity) && reserveCandidates(tracker, capacity);
+}
+
+/**
+ * @brief Create an empty coin tracker
+ *
+ * @details Each video stream needs its own tracker; nothing is shared
+ * between trackers, so several can be used in the same process. Tracked
+ * coins and exclusion points are indexed in uniform grids covering the
+ * frame, with cells as large as the widest match radius, so every
+ * proximity query only visits the 3x3 cells around the query point.
+ * Both tables start small and grow on demand.
+ */
+CoinTracker *createTracker(int width, int height) {
+    CoinTracker *tracker = (CoinTracker *)calloc(1, sizeof(CoinTracker));
+    if (tracker == NULL) return NULL;
+
+    tracker->coinGrid = createGrid(width, height, VC_GRID_CELL_SIZE, VC_TRACKER_INITIAL_CAPACITY);
+    tracker->excludeGrid = createGrid(width, height, VC_GRID_CELL_SIZE, VC_TRACKER_INITIAL_CAPACITY);
+
+    if (!tracker->coinGrid || !tracker->excludeGrid ||
+        !resizeCoins(tracker, VC_TRACKER_INITIAL_CAPACITY) ||
+        !resizeExcluded(tracker, VC_TRACKER_INITIAL_CAPACITY))
+        return freeTracker(tracker);
+
+    tracker->width = width;
+    tracker->height = height;
+    tracker->nominalFps = 30.0;
+    tracker->verbose = 1;
+
+    // Built-in Euro table at the frame resolution (also sets params and maxSpeed)
+    CoinSpecTable specs;
+    defaultCoinSpecs(&specs);
+    setCoinSpecs(tracker, &specs);
+    setTrackerWindows(tracker, VC_WINDOW_FRAMES, 60, 120, VC_EXCLUDE_MEMORY);
+
+    return tracker;
+}
+
+/**
+ * @brief Free a coin tracker
+ */
+CoinTracker *freeTracker(CoinTracker *tracker) {
+    if (tracker != NULL) {
+        if (tracker->coins) free(tracker->coins);
+        if (tracker->excluded) free(tracker->excluded);
+        if (tracker->candidates) free(tracker->candidates);
+        if (tracker->pending) free(tracker->pending);
+        if (tracker->pairs) free(tracker->pairs);
+        if (tracker->coinGrid) freeGrid(tracker->coinGrid);
+        if (tracker->excludeGrid) freeGrid(tracker->excludeGrid);
+        free(tracker);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Set how long tracked coins and exclusion points are remembered
+ *
+ * @details Windows are measured in frames (VC_WINDOW_FRAMES) or in
+ * milliseconds of capture time (VC_WINDOW_MS). Millisecond windows keep
+ * the same behaviour when the frame rate changes or frames are dropped.
+ */
+void setTrackerWindows(CoinTracker *tracker, int unit, long long coinWindow,
+                       long long euroWindow, long long excludeWindow) {
+    tracker->windowUnit = unit;
+    tracker->coinWindow = coinWindow;
+    tracker->euroWindow = euroWindow;
+    tracker->excludeWindow = excludeWindow;
+}
+
+/**
+ * @brief Expire stale entries and compact the tracker tables
+ *
+ * @details Coins older than their memory window and exclusion points not
+ * seen within the exclusion window are dropped. Once at least a quarter
+ * of a table is dead it is compacted in place (keeping the order of the
+ * live entries), its grid is rebuilt, and oversized tables are shrunk, so
+ * memory follows the number of coins in view rather than the length of
+ * the video. Called periodically by advanceClock().
+ */
+void maintainTracker(CoinTracker *tracker) {
+    int i, n;
+
+    for (i = 0; i < tracker->nCoins; i++) {
+        if (tracker->coins[i].alive && !coinIsActive(tracker, &tracker->coins[i])) {
+            tracker->coins[i].alive = false;
+            tracker->nAliveCoins--;
+            gridRemove(tracker->coinGrid, i);
+        }
+    }
+
+    for (i = 0; i < tracker->nExcluded; i++) {
+        if (tracker->excluded[i].alive && !exclusionIsActive(tracker, &tracker->excluded[i])) {
+            tracker->excluded[i].alive = false;
+            tracker->nAliveExcluded--;
+            gridRemove(tracker->excludeGrid, i);
+        }
+    }
+
+    if ((tracker->nCoins - tracker->nAliveCoins) * 4 >= tracker->nCoins && tracker->nCoins > 0) {
+        gridClear(tracker->coinGrid);
+        for (i = 0, n = 0; i < tracker->nCoins; i++) {
+            if (!tracker->coins[i].alive) continue;
+            tracker->coins[n] = tracker->coins[i];
+            gridInsert(tracker->coinGrid, n, tracker->coins[n].px, tracker->coins[n].py);
+            n++;
+        }
+        tracker->nCoins = n;
+
+        if (tracker->coinCapacity > VC_TRACKER_INITIAL_CAPACITY && n * 4 < tracker->coinCapacity)
+            resizeCoins(tracker, VC_MAX(tracker->coinCapacity / 2, VC_TRACKER_INITIAL_CAPACITY));
+    }
+
+    if ((tracker->nExcluded - tracker->nAliveExcluded) * 4 >= tracker->nExcluded && tracker->nExcluded > 0) {
+        gridClear(tracker->excludeGrid);
+        for (i = 0, n = 0; i < tracker->nExcluded; i++) {
+            if (!tracker->excluded[i].alive) continue;
+            tracker->excluded[n] = tracker->excluded[i];
+            gridInsert(tracker->excludeGrid, n, tracker->excluded[n].x, tracker->excluded[n].y);
+            n++;
+        }
+        tracker->nExcluded = n;
+
+        if (tracker->excludedCapacity > VC_TRACKER_INITIAL_CAPACITY && n * 4 < tracker->excludedCapacity)
+            resizeExcluded(tracker, VC_MAX(tracker->excludedCapacity / 2, VC_TRACKER_INITIAL_CAPACITY));
+    }
+}
+
+/**
+ * @brief Predict where every live coin is in the current frame
+ *
+ * @details Constant-velocity model: the predicted position is the last
+ * observed position plus the velocity times the frames elapsed since then.
+ * The grid indexes predicted positions, so all proximity queries made
+ * during the frame compare detections against where the coins should be.
+ */
+void predictTracks(CoinTracker *tracker) {
+    for (int i = 0; i < tracker->nCoins; i++) {
+        TrackedCoin *coin = &tracker->coins[i];
+        if (!coin->alive) continue;
+
+        const float dt = (float)(tracker->frameIndex - coin->lastFrame);
+        coin->px = coin->x + (int)lroundf(coin->vx * dt);
+        coin->py = coin->y + (int)lroundf(coin->vy * dt);
+        gridInsert(tracker->coinGrid, i, coin->px, coin->py);
+    }
+}
+
+/**
+ * @brief Advance the tracker clock by one frame
+ *
+ * @details The frame index is 64-bit and never wraps. timestampMs is the
+ * capture time of the frame; pass a negative value when it is unknown and
+ * it is derived from the frame index at tracker->nominalFps. Timestamps
+ * that go backwards (seeks, camera glitches) are clamped so the clock
+ * stays monotonic.
+ */
+void advanceClock(CoinTracker *tracker, long long timestampMs) {
+    tracker->frameIndex++;
+
+    if (timestampMs < 0)
+        timestampMs = (long long)(tracker->frameIndex * 1000.0 / tracker->nominalFps);
+
+    if (timestampMs > tracker->timestampMs)
+        tracker->timestampMs = timestampMs;
+
+    if (tracker->frameIndex % VC_TRACKER_SWEEP_INTERVAL == 0)
+        maintainTracker(tracker);
+
+    predictTracks(tracker);
+}
+
+/**
+ * @brief Hold every live track where it was last seen in the current frame
+ *
+ * @details For frames that are not analysed because nothing moved (see
+ * setMotionGate()): the clock has advanced, but the scene is the last
+ * processed one, so extrapolating the tracks would move the predictions
+ * away from coins that have stopped. Each live track is re-dated to the
+ * current frame with zero velocity and its prediction is its last
+ * position, which also keeps stopped coins inside their memory window.
+ */
+void holdTracks(CoinTracker *tracker) {
+    for (int i = 0; i < tracker->nCoins; i++) {
+        TrackedCoin *coin = &tracker->coins[i];
+        if (!coin->alive) continue;
+
+        coin->vx = coin->vy = 0.0f;
+        coin->px = coin->x;
+        coin->py = coin->y;
+        coin->lastFrame = tracker->frameIndex;
+        coin->lastTimeMs = tracker->timestampMs;
+        gridInsert(tracker->coinGrid, i, coin->px, coin->py);
+    }
+}
 
 /**
  * @brief Increment or reset the frame counter
+ *
+ * @details A reset starts a new sequence: the clock goes back to zero and
+ * every tracked coin and exclusion point is forgotten (the counted totals
+ * are kept).
  */
-void frameCounter(int reset) {
+void frameCounter(CoinTracker *tracker, int reset) {
     if (reset) {
-        frameCountValue = 0;
+        for (int i = 0; i < tracker->nCoins; i++) tracker->coins[i].alive = false;
+        for (int i = 0; i < tracker->nExcluded; i++) tracker->excluded[i].alive = false;
+        tracker->nCoins = tracker->nAliveCoins = 0;
+        tracker->nExcluded = tracker->nAliveExcluded = 0;
+        gridClear(tracker->coinGrid);
+        gridClear(tracker->excludeGrid);
+
+        tracker->frameIndex = 0;
+        tracker->timestampMs = 0;
     } else {
-        frameCountValue++;
-        // Reset at 1000 to avoid overflow
-        if (frameCountValue > 1000) frameCountValue = 0;
+        advanceClock(tracker, -1);
     }
 }
 
 /**
- * @brief Get the current frame count
+ * @brief Get the current frame index
+ */
+long long getFrameCount(CoinTracker *tracker) {
+    return tracker->frameIndex;
+}
+
+/**
+ * @brief Get the capture time of the current frame in milliseconds
  */
-int getFrameCount() {
-    return frameCountValue;
+long long getTimestampMs(CoinTracker *tracker) {
+    return tracker->timestampMs;
 }
 
 /**
@@ -82,9 +345,10 @@ float getDiameter(OVC *blob) {
 /**
  * @brief Calculate adaptive tolerance based on proximity to frame edge
  */
-float adaptTolerance(int xc, int yc, int frameWidth, int frameHeight) {
+float adaptTolerance(int xc, int yc, int frameWidth, int frameHeight, int edgeMargin) {
     float tolerance = BASE_TOLERANCE;
-    const int edgeMargin = 50;
+    
+    if (edgeMargin <= 0) return tolerance;
     
     // Find minimum distance to any edge
     float minDist = fminf(fminf((float)xc, (float)(frameWidth - xc)), 
@@ -97,150 +361,596 @@ float adaptTolerance(int xc, int yc, int frameWidth, int frameHeight) {
     return tolerance;
 }
 
+// Association gate for a detection of the given type (pixels, from the
+// tracker params): Euro coins are larger and move their centroid more
+static inline int coinGate(const CoinTracker *tracker, int coinType) {
+    return isEuroType(tracker, coinType) ? tracker->params.euroGate : tracker->params.coinGate;
+}
+
+// A track seen only once has no velocity yet, so its gate also covers the
+// distance a coin can travel at tracker->maxSpeed in the frames since then
+static inline int trackGate(const CoinTracker *tracker, const TrackedCoin *coin, int coinType) {
+    if (coin->hits >= 2) return coinGate(tracker, coinType);
+
+    const long long dt = VC_MIN(tracker->frameIndex - coin->lastFrame, (long long)VC_TRACK_YOUNG_FRAMES);
+    return coinGate(tracker, coinType) + (int)(tracker->maxSpeed * dt);
+}
+
+// Radius that covers the gate of every track for a detection of coinType
+static inline int searchRadius(const CoinTracker *tracker, int coinType) {
+    return coinGate(tracker, coinType) + (int)(tracker->maxSpeed * VC_TRACK_YOUNG_FRAMES);
+}
+
+// Move a track to a new observation and refresh its velocity estimate
+static void updateTrack(CoinTracker *tracker, int i, int x, int y) {
+    TrackedCoin *coin = &tracker->coins[i];
+    const long long dt = tracker->frameIndex - coin->lastFrame;
+
+    if (dt > 0) {
+        const float mvx = (float)(x - coin->x) / (float)dt;
+        const float mvy = (float)(y - coin->y) / (float)dt;
+
+        // The first measurement initialises the velocity, later ones are smoothed
+        if (coin->hits == 1) {
+            coin->vx = mvx;
+            coin->vy = mvy;
+        } else {
+            coin->vx += VC_TRACK_VELOCITY_GAIN * (mvx - coin->vx);
+            coin->vy += VC_TRACK_VELOCITY_GAIN * (mvy - coin->vy);
+        }
+    }
+
+    coin->x = coin->px = x;
+    coin->y = coin->py = y;
+    coin->lastFrame = tracker->frameIndex;
+    coin->lastTimeMs = tracker->timestampMs;
+    coin->hits++;
+    gridInsert(tracker->coinGrid, i, x, y);
+}
+
+// Append a new, not yet counted track; returns its index or -1 if the table cannot grow
+static int newTrack(CoinTracker *tracker, int x, int y, int coinType) {
+    if (tracker->nCoins == tracker->coinCapacity &&
+        !resizeCoins(tracker, tracker->coinCapacity * 2))
+        return -1;
+
+    const int i = tracker->nCoins;
+    TrackedCoin *coin = &tracker->coins[i];
+    memset(coin, 0, sizeof(TrackedCoin));
+    coin->x = coin->px = x;
+    coin->y = coin->py = y;
+    coin->type = coinType;
+    coin->lastFrame = tracker->frameIndex;
+    coin->lastTimeMs = tracker->timestampMs;
+    coin->hits = 1;
+    coin->assignedFrame = tracker->frameIndex;
+    coin->alive = true;
+    gridInsert(tracker->coinGrid, i, x, y);
+    tracker->nCoins++;
+    tracker->nAliveCoins++;
+
+    return i;
+}
+
+// Count a track under its current denomination
+static void countTrack(CoinTracker *tracker, TrackedCoin *coin, int *counters) {
+    coin->counted = 1;
+    tracker->countedByType[coin->type - 1]++;
+    if (counters != NULL)
+        counters[coin->type - 1]++;
+}
+
+// Median of n values (n >= 1)
+static float medianOf(const float *values, int n) {
+    float sorted[VC_EVIDENCE_SAMPLES];
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        const float v = values[i];
+        for (j = i; j > 0 && sorted[j - 1] > v; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+
+    return (n % 2) ? sorted[n / 2] : 0.5f * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+// Votes of a track for the denominations of a colour class
+static float classEvidence(const CoinTracker *tracker, const TrackedCoin *coin, int colorClass) {
+    float votes = 0.0f;
+
+    for (int k = 0; k < tracker->specs.nSpecs; k++) {
+        if (tracker->specs.specs[k].colorClass == colorClass) votes += coin->evidence[k];
+    }
+
+    return votes;
+}
+
+// Colour class with the most votes (ties keep the class of the current denomination)
+static int votedClass(const CoinTracker *tracker, const TrackedCoin *coin) {
+    const CoinSpec *current = getCoinSpec(&tracker->specs, coin->type);
+    int best = (current != NULL) ? current->colorClass : -1;
+    float bestVotes = (best >= 0) ? classEvidence(tracker, coin, best) : 0.0f;
+
+    for (int c = 0; c < VC_NUM_MASKS; c++) {
+        const float votes = classEvidence(tracker, coin, c);
+        if (best < 0 || votes > bestVotes) {
+            best = c;
+            bestVotes = votes;
+        }
+    }
+
+    return best;
+}
+
+// Denomination of a track within a colour class: the one nearest to the
+// median diameter of the track's complete detections of that class, or the
+// most voted of the class if it has none. *circularity gets the median
+// circularity of those detections (-1 if there are none)
+static int classDenomination(const CoinTracker *tracker, const TrackedCoin *coin, int colorClass,
+                             float *circularity) {
+    float diameters[VC_EVIDENCE_SAMPLES], circularities[VC_EVIDENCE_SAMPLES];
+    const int stored = VC_MIN(coin->nSamples, VC_EVIDENCE_SAMPLES);
+    int n = 0, best = -1, k;
+
+    for (k = 0; k < stored; k++) {
+        if (coin->sampleClasses[k] != colorClass) continue;
+        diameters[n] = coin->diameters[k];
+        circularities[n] = coin->circularities[k];
+        n++;
+    }
+
+    *circularity = -1.0f;
+    if (n > 0) {
+        const int type = classifyCoin(&tracker->specs, colorClass, medianOf(diameters, n), 1.0f, 1);
+        if (type > 0) {
+            *circularity = medianOf(circularities, n);
+            return type;
+        }
+    }
+
+    for (k = 0; k < tracker->specs.nSpecs; k++) {
+        if (tracker->specs.specs[k].colorClass != colorClass) continue;
+        if (best < 0 || coin->evidence[k] > coin->evidence[best]) best = k;
+    }
+
+    return best + 1;
+}
+
+// Add a detection's vote to a track's evidence. Complete detections also
+// add their diameter and circularity to the track's samples. The votes
+// decide the colour class and the medians of the samples the denomination
+// within it, so per-frame diameter jitter between neighbouring
+// denominations does not split the votes. An uncounted track is counted
+// once it has enough detections, its class has a clear majority and the
+// median circularity passes the denomination's minimum; a counted track
+// only changes class when the evidence against it is overwhelming, moving
+// the count with it. Returns 1 if the track was counted by this call.
+static int addEvidence(CoinTracker *tracker, int i, const CoinDetection *d, int *counters) {
+    TrackedCoin *coin = &tracker->coins[i];
+    const CoinSpec *spec = getCoinSpec(&tracker->specs, d->type);
+    float circularity;
+
+    if (d->blobDiameter > coin->blobDiameter)
+        coin->blobDiameter = d->blobDiameter;
+
+    if (d->weight <= 0.0f || spec == NULL)
+        return 0;
+
+    // Edge and partial detections vote with less weight, but their blobs are cut
+    if (d->weight >= 1.0f && d->diameter > 0.0f) {
+        const int s = coin->nSamples % VC_EVIDENCE_SAMPLES;
+        coin->diameters[s] = d->diameter;
+        coin->circularities[s] = d->circularity;
+        coin->sampleClasses[s] = spec->colorClass;
+        coin->nSamples++;
+        coin->diameter = medianOf(coin->diameters, VC_MIN(coin->nSamples, VC_EVIDENCE_SAMPLES));
+    }
+
+    coin->evidence[d->type - 1] += d->weight;
+    coin->evidenceTotal += d->weight;
+
+    const int colorClass = votedClass(tracker, coin);
+    const CoinSpec *current = getCoinSpec(&tracker->specs, coin->type);
+
+    if (!coin->counted) {
+        coin->type = classDenomination(tracker, coin, colorClass, &circularity);
+        coin->label = tracker->specs.specs[coin->type - 1].label;
+
+        if (coin->hits < VC_EVIDENCE_MIN_HITS ||
+            classEvidence(tracker, coin, colorClass) < VC_EVIDENCE_CONFIDENCE * coin->evidenceTotal ||
+            (circularity >= 0.0f && circularity <= tracker->specs.specs[coin->type - 1].minCircularity))
+            return 0;
+
+        countTrack(tracker, coin, counters);
+        if (tracker->verbose) {
+            printf("[MOEDA] %s | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
+                   coin->label, coin->diameter, d->area, d->circularity);
+        }
+        return 1;
+    }
+
+    if (current != NULL && colorClass != current->colorClass &&
+        classEvidence(tracker, coin, colorClass) >=
+            VC_EVIDENCE_REVISE_RATIO * classEvidence(tracker, coin, current->colorClass)) {
+        tracker->countedByType[coin->type - 1]--;
+        if (counters != NULL && counters[coin->type - 1] > 0)
+            counters[coin->type - 1]--;
+
+        coin->type = classDenomination(tracker, coin, colorClass, &circularity);
+        coin->label = tracker->specs.specs[coin->type - 1].label;
+        countTrack(tracker, coin, counters);
+    }
+
+    return 0;
+}
+
+// Squared distance to a track's predicted position if it is a valid match
+// for a detection of coinType at (x, y), or -1 otherwise
+static int gatedDistance(const CoinTracker *tracker, int i, int x, int y, int coinType) {
+    const TrackedCoin *coin = &tracker->coins[i];
+    const int gate = trackGate(tracker, coin, coinType);
+    const int dx = coin->px - x;
+    const int dy = coin->py - y;
+    const int distSq = dx*dx + dy*dy;
+
+    // The window of the incoming type decides, as it always has
+    if (distSq > gate * gate ||
+        entryAge(tracker, coin->lastFrame, coin->lastTimeMs) >= coinMemory(tracker, coinType))
+        return -1;
+
+    return distSq;
+}
+
 /**
  * @brief Track if a coin has been detected already
+ *
+ * @details Associates a single detection immediately with the nearest
+ * gated track and adds it to the track's evidence. Use
+ * addDetection()/commitDetections() to associate all of a frame's
+ * detections at once. With countIt the coin is counted straight away under
+ * its most voted denomination instead of waiting for enough evidence.
+ *
+ * @return 1 if the coin had already been counted, 0 otherwise (including
+ * when this call counts it for the first time)
  */
-int trackCoin(int x, int y, int coinType, int countIt) {
-    const int distThreshold = (coinType >= 7) ? 75 : 50;
-    const int distThresholdSq = distThreshold * distThreshold;
-    const int frameMemory = (coinType >= 7) ? 120 : 60;
-    const int currentFrame = getFrameCount();
-    
+int trackCoin(CoinTracker *tracker, int x, int y, int coinType, int countIt) {
+    CoinDetection detection;
     int existingIndex = -1;
-    int emptyIndex = -1;
+    int bestDistSq = INT_MAX;
     
-    // Handle Euro coins replacing gold coins
-    if (coinType >= 7) {
-        for (int i = 0; i < MAX_TRACKED_COINS; i++) {
-            if (detectedCoins[i][0] == 0 && detectedCoins[i][1] == 0)
-                continue;
-                
-            if (detectedCoins[i][2] >= 4 && detectedCoins[i][2] <= 6) {
-                const int dx = detectedCoins[i][0] - x;
-                const int dy = detectedCoins[i][1] - y;
-                const int distSq = dx*dx + dy*dy;
-                
-                if (distSq <= 85*85) {
-                    memset(&detectedCoins[i][0], 0, 5 * sizeof(int));
-                    break;
-                }
-            }
+    const int n = gridQuery(tracker->coinGrid, x, y, searchRadius(tracker, coinType),
+                            tracker->candidates, tracker->candidateCapacity);
+    for (int k = 0; k < n; k++) {
+        const int i = tracker->candidates[k];
+        const int distSq = gatedDistance(tracker, i, x, y, coinType);
+        
+        if (distSq >= 0 && (distSq < bestDistSq || (distSq == bestDistSq && i < existingIndex))) {
+            bestDistSq = distSq;
+            existingIndex = i;
         }
     }
     
-    // Find existing or empty slot
-    for (int i = 0; i < MAX_TRACKED_COINS; i++) {
-        if (detectedCoins[i][0] == 0 && detectedCoins[i][1] == 0) {
-            if (emptyIndex == -1) emptyIndex = i;
+    if (existingIndex < 0) {
+        existingIndex = newTrack(tracker, x, y, coinType);
+        if (existingIndex < 0) return 0;
+    } else {
+        updateTrack(tracker, existingIndex, x, y);
+    }
+    
+    TrackedCoin *coin = &tracker->coins[existingIndex];
+    const int wasCounted = coin->counted;
+    
+    memset(&detection, 0, sizeof(CoinDetection));
+    detection.x = x;
+    detection.y = y;
+    detection.type = coinType;
+    detection.weight = 1.0f;
+    detection.track = existingIndex;
+    addEvidence(tracker, existingIndex, &detection, NULL);
+    
+    if (countIt && !coin->counted && getCoinSpec(&tracker->specs, coin->type) != NULL)
+        countTrack(tracker, coin, NULL);
+    
+    return wasCounted;
+}
+
+/**
+ * @brief Queue a coin detection for association at the end of the frame
+ *
+ * @details The detect*Coins functions classify blobs and queue what they
+ * find; commitDetections() then associates all of the frame's detections
+ * with the tracks in one pass.
+ */
+void addDetection(CoinTracker *tracker, const CoinDetection *detection) {
+    if (tracker->nPending == tracker->pendingCapacity) {
+        const int capacity = VC_MAX(2 * tracker->pendingCapacity, 16);
+        CoinDetection *pending = (CoinDetection *)realloc(tracker->pending, capacity * sizeof(CoinDetection));
+        if (pending == NULL) return;
+
+        tracker->pending = pending;
+        tracker->pendingCapacity = capacity;
+    }
+
+    tracker->pending[tracker->nPending++] = *detection;
+}
+
+// Whether a track matched or created in the current frame lies within radius of (x, y)
+static bool matchedThisFrame(CoinTracker *tracker, int x, int y, int radius) {
+    const int m = gridQuery(tracker->coinGrid, x, y, radius, tracker->candidates, tracker->candidateCapacity);
+
+    for (int k = 0; k < m; k++) {
+        const TrackedCoin *coin = &tracker->coins[tracker->candidates[k]];
+        if (coin->assignedFrame != tracker->frameIndex && coin->lastFrame != tracker->frameIndex)
+            continue;
+
+        const int dx = coin->px - x;
+        const int dy = coin->py - y;
+        if (dx*dx + dy*dy <= radius*radius)
+            return true;
+    }
+
+    return false;
+}
+
+static int comparePairs(const void *a, const void *b) {
+    const TrackPair *pa = (const TrackPair *)a;
+    const TrackPair *pb = (const TrackPair *)b;
+
+    if (pa->distSq != pb->distSq) return (pa->distSq < pb->distSq) ? -1 : 1;
+    if (pa->detection != pb->detection) return pa->detection - pb->detection;
+    return pa->track - pb->track;
+}
+
+static void addPair(CoinTracker *tracker, int detection, int track, int distSq) {
+    if (tracker->nPairs == tracker->pairCapacity) {
+        const int capacity = VC_MAX(2 * tracker->pairCapacity, 64);
+        TrackPair *pairs = (TrackPair *)realloc(tracker->pairs, capacity * sizeof(TrackPair));
+        if (pairs == NULL) return;
+
+        tracker->pairs = pairs;
+        tracker->pairCapacity = capacity;
+    }
+
+    tracker->pairs[tracker->nPairs].detection = detection;
+    tracker->pairs[tracker->nPairs].track = track;
+    tracker->pairs[tracker->nPairs].distSq = distSq;
+    tracker->nPairs++;
+}
+
+/**
+ * @brief Associate the frame's queued detections with the tracks and count confirmed coins
+ *
+ * @details Gated global assignment: every (detection, track) pair whose
+ * distance to the track's predicted position is inside the detection's
+ * gate is a candidate, found through the grid, so building the list is
+ * roughly linear in the number of detections. Pairs are taken greedily
+ * in order of distance, each detection and each track at most once.
+ * Matched tracks get the new position and an updated velocity.
+ * Unmatched detections start new tracks, unless they fall inside the gate
+ * of a track matched or created in this frame, in which case they are a
+ * second blob of the same coin. Every associated detection votes for its
+ * denomination; a track is counted once the evidence is conclusive (see
+ * VC_EVIDENCE_MIN_HITS and VC_EVIDENCE_CONFIDENCE), so a coin first seen
+ * as gold and then as a Euro is counted once, as a Euro.
+ *
+ * @param tracker Coin tracker
+ * @param counters Per-type counters, updated when a coin is counted or revised
+ * @return Number of coins counted in this frame
+ */
+int commitDetections(CoinTracker *tracker, int *counters) {
+    const int n = tracker->nPending;
+    int i, k, counted = 0;
+
+    if (n == 0) return 0;
+
+    // Candidate pairs inside each detection's gate
+    tracker->nPairs = 0;
+    for (i = 0; i < n; i++) {
+        CoinDetection *d = &tracker->pending[i];
+        const int m = gridQuery(tracker->coinGrid, d->x, d->y, searchRadius(tracker, d->type),
+                                tracker->candidates, tracker->candidateCapacity);
+
+        for (k = 0; k < m; k++) {
+            const int distSq = gatedDistance(tracker, tracker->candidates[k], d->x, d->y, d->type);
+            if (distSq >= 0)
+                addPair(tracker, i, tracker->candidates[k], distSq);
+        }
+        tracker->pending[i].track = -1;
+    }
+
+    // Greedy assignment, nearest pairs first
+    if (tracker->nPairs > 1)
+        qsort(tracker->pairs, tracker->nPairs, sizeof(TrackPair), comparePairs);
+    for (k = 0; k < tracker->nPairs; k++) {
+        CoinDetection *d = &tracker->pending[tracker->pairs[k].detection];
+        TrackedCoin *coin = &tracker->coins[tracker->pairs[k].track];
+
+        if (d->track >= 0 || coin->assignedFrame == tracker->frameIndex)
             continue;
+
+        d->track = tracker->pairs[k].track;
+        coin->assignedFrame = tracker->frameIndex;
+    }
+
+    // Apply in detection order, so logs follow the order of the blobs
+    for (i = 0; i < n; i++) {
+        const CoinDetection *d = &tracker->pending[i];
+        int track = d->track;
+
+        if (track >= 0) {
+            updateTrack(tracker, track, d->x, d->y);
         }
-        
-        const int dx = detectedCoins[i][0] - x;
-        const int dy = detectedCoins[i][1] - y;
-        const int distSq = dx*dx + dy*dy;
-        
-        if (distSq <= distThresholdSq) {
-            // Valid frame window
-            if ((currentFrame - detectedCoins[i][3] < frameMemory) || 
-                detectedCoins[i][3] > currentFrame) {
-                
-                existingIndex = i;
-                
-                // Handle Euro replacing gold
-                if (coinType >= 7 && detectedCoins[i][2] >= 4 && detectedCoins[i][2] <= 6) {
-                    detectedCoins[i][2] = coinType;
-                }
-                
-                break;
-            }
+        else {
+            // A second blob of a coin already matched or created in this frame
+            if (matchedThisFrame(tracker, d->x, d->y, coinGate(tracker, d->type)))
+                continue;
+
+            if ((track = newTrack(tracker, d->x, d->y, d->type)) < 0)
+                continue;
         }
+
+        counted += addEvidence(tracker, track, d, counters);
     }
-    
-    // Update existing or add new entry
-    if (existingIndex >= 0) {
-        // Update position and timestamp
-        detectedCoins[existingIndex][0] = x;
-        detectedCoins[existingIndex][1] = y;
-        detectedCoins[existingIndex][3] = currentFrame;
-        
-        // Handle counting
-        if (countIt && detectedCoins[existingIndex][4] == 0) {
-            detectedCoins[existingIndex][4] = 1;
-            return 0;
+
+    tracker->nPending = 0;
+    return counted;
+}
+
+/**
+ * @brief Denomination of a counted coin near (x, y) whose evidence is settled
+ *
+ * @details A coin is stable once it has at least twice
+ * VC_EVIDENCE_MIN_HITS detections and VC_EVIDENCE_STABLE of its votes go
+ * to the colour class of its denomination. Its blobs need no further classification; a
+ * zero-weight detection is enough to keep the track moving.
+ *
+ * @return Coin type (1 to 8), or 0 if there is no stable coin nearby
+ */
+int stableCoinType(CoinTracker *tracker, int x, int y) {
+    int best = -1, bestDistSq = INT_MAX;
+
+    // The Euro gate is the widest one
+    const int radius = tracker->params.euroGate + (int)(tracker->maxSpeed * VC_TRACK_YOUNG_FRAMES);
+    const int n = gridQuery(tracker->coinGrid, x, y, radius,
+                            tracker->candidates, tracker->candidateCapacity);
+    for (int k = 0; k < n; k++) {
+        const int i = tracker->candidates[k];
+        const TrackedCoin *coin = &tracker->coins[i];
+        if (!coin->counted || !coinIsActive(tracker, coin))
+            continue;
+
+        const int distSq = gatedDistance(tracker, i, x, y, coin->type);
+        if (distSq >= 0 && distSq < bestDistSq) {
+            best = i;
+            bestDistSq = distSq;
         }
-        
-        return detectedCoins[existingIndex][4];
     }
-    
-    // Add new entry if possible
-    if (emptyIndex >= 0) {
-        detectedCoins[emptyIndex][0] = x;
-        detectedCoins[emptyIndex][1] = y;
-        detectedCoins[emptyIndex][2] = coinType;
-        detectedCoins[emptyIndex][3] = currentFrame;
-        detectedCoins[emptyIndex][4] = countIt ? 1 : 0;
+
+    if (best < 0) return 0;
+
+    const TrackedCoin *coin = &tracker->coins[best];
+    const CoinSpec *spec = getCoinSpec(&tracker->specs, coin->type);
+    if (spec == NULL || coin->hits < 2 * VC_EVIDENCE_MIN_HITS ||
+        classEvidence(tracker, coin, spec->colorClass) < VC_EVIDENCE_STABLE * coin->evidenceTotal)
+        return 0;
+
+    return coin->type;
+}
+
+/**
+ * @brief Regions around the predicted position of the live tracks
+ *
+ * @details Every live track gets a region, tentative ones included: a coin
+ * that is not counted yet needs its next detections to be counted at all.
+ * Each region is a square centred on the predicted position, with the
+ * coin's diameter plus margin on every side and the prediction error
+ * allowed by the association gate: one frame at the current velocity, or
+ * maxSpeed over the frames since the last match for coins without a
+ * velocity yet. The diameter is the larger of the median measured
+ * diameter and the largest main blob seen (params.roiDefaultDiameter if
+ * neither was measured): a Euro coin's colour blob is only its inner
+ * disc, and a region sized from it would cut the main blob, which is then
+ * dropped.
+ * Regions are not clipped to the frame.
+ *
+ * @return Number of regions written (at most maxRegions)
+ */
+int trackedRegions(CoinTracker *tracker, int margin, ImageRegion *regions, int maxRegions) {
+    int n = 0;
+
+    for (int i = 0; i < tracker->nCoins && n < maxRegions; i++) {
+        const TrackedCoin *coin = &tracker->coins[i];
+        if (!coinIsActive(tracker, coin))
+            continue;
+
+        const float measured = VC_MAX(coin->diameter, coin->blobDiameter);
+        const float diameter = (measured > 0.0f) ? measured : tracker->params.roiDefaultDiameter;
+        float drift = VC_MAX(fabsf(coin->vx), fabsf(coin->vy));
+        if (coin->hits < 2) {
+            const long long dt = VC_MIN(tracker->frameIndex - coin->lastFrame, (long long)VC_TRACK_YOUNG_FRAMES);
+            drift = tracker->maxSpeed * (float)VC_MAX(dt, 1LL);
+        }
+        const int half = (int)ceilf(diameter / 2.0f + drift) + margin;
+
+        regions[n].x = coin->px - half;
+        regions[n].y = coin->py - half;
+        regions[n].width = regions[n].height = 2 * half + 1;
+        n++;
     }
-    
-    return 0;
+
+    return n;
 }
 
 /**
  * @brief Get last detected coin type at a location
  */
-int getCoinTypeAtLocation(int x, int y) {
-    const int distThresholdSq = 50*50;
-    int nearestType = 0;
+int getCoinTypeAtLocation(CoinTracker *tracker, int x, int y) {
+    const int distThreshold = tracker->params.locationRadius;
+    int nearestIndex = -1;
     int nearestDistSq = INT_MAX;
     
-    for (int i = 0; i < MAX_TRACKED_COINS; i++) {
-        if (detectedCoins[i][0] == 0 && detectedCoins[i][1] == 0)
+    const int n = gridQuery(tracker->coinGrid, x, y, distThreshold, tracker->candidates, tracker->candidateCapacity);
+    for (int k = 0; k < n; k++) {
+        const int i = tracker->candidates[k];
+        const TrackedCoin *coin = &tracker->coins[i];
+        if (!coinIsActive(tracker, coin))
             continue;
         
-        int dx = detectedCoins[i][0] - x;
-        int dy = detectedCoins[i][1] - y;
+        int dx = coin->px - x;
+        int dy = coin->py - y;
         int distSq = dx*dx + dy*dy;
         
-        if (distSq < nearestDistSq && distSq <= distThresholdSq) {
+        // Ties go to the lowest index, as in a scan of the whole table
+        if (distSq <= distThreshold * distThreshold &&
+            (distSq < nearestDistSq || (distSq == nearestDistSq && i < nearestIndex))) {
             nearestDistSq = distSq;
-            nearestType = detectedCoins[i][2];
+            nearestIndex = i;
         }
     }
     
-    return nearestType;
+    return (nearestIndex >= 0) ? tracker->coins[nearestIndex].type : 0;
 }
 
 /**
  * @brief Add or remove a coin from exclusion list
  */
-int excludeCoin(int *excludeList, int xc, int yc, int option) {
-    if (!excludeList) return 0;
+int excludeCoin(CoinTracker *tracker, int xc, int yc, int option) {
+    if (!tracker) return 0;
     
-    const int PROXIMITY_THRESHOLD_SQ = 30 * 30;
+    const int PROXIMITY_THRESHOLD = tracker->params.exclusionRadius;
     
     if (option == 0) {
-        // Add to exclusion list
-        for (int i = 0; i < MAX_COINS; i++) {
-            if (excludeList[i * 2] == 0 && excludeList[i * 2 + 1] == 0) {
-                excludeList[i * 2] = xc;
-                excludeList[i * 2 + 1] = yc;
-                break;
-            }
-        }
+        // Add to exclusion list, growing it if needed
+        if (tracker->nExcluded == tracker->excludedCapacity &&
+            !resizeExcluded(tracker, tracker->excludedCapacity * 2))
+            return 0;
+        
+        ExclusionPoint *point = &tracker->excluded[tracker->nExcluded];
+        point->x = xc;
+        point->y = yc;
+        point->lastFrame = tracker->frameIndex;
+        point->lastTimeMs = tracker->timestampMs;
+        point->alive = true;
+        gridInsert(tracker->excludeGrid, tracker->nExcluded, xc, yc);
+        tracker->nExcluded++;
+        tracker->nAliveExcluded++;
     }
     else if (option == 1) {
         // Remove from exclusion list
-        for (int i = 0; i < MAX_COINS; i++) {
-            if (excludeList[i * 2] == 0 && excludeList[i * 2 + 1] == 0) {
-                continue;
-            }
-            
-            int dx = excludeList[i * 2] - xc;
-            int dy = excludeList[i * 2 + 1] - yc;
+        const int n = gridQuery(tracker->excludeGrid, xc, yc, PROXIMITY_THRESHOLD,
+                                tracker->candidates, tracker->candidateCapacity);
+        
+        for (int k = 0; k < n; k++) {
+            const int i = tracker->candidates[k];
+            int dx = tracker->excluded[i].x - xc;
+            int dy = tracker->excluded[i].y - yc;
             int distSq = dx*dx + dy*dy;
             
-            if (distSq <= PROXIMITY_THRESHOLD_SQ) {
-                excludeList[i * 2] = 0;
-                excludeList[i * 2 + 1] = 0;
+            if (distSq <= PROXIMITY_THRESHOLD * PROXIMITY_THRESHOLD) {
+                tracker->excluded[i].alive = false;
+                tracker->nAliveExcluded--;
+                gridRemove(tracker->excludeGrid, i);
             }
         }
     }
@@ -249,44 +959,45 @@ int excludeCoin(int *excludeList, int xc, int yc, int option) {
 }
 
 /**
- * @brief Correct misidentified gold coins when Euro coins are detected
+ * @brief Check whether a position lies within params.exclusionRadius of an active exclusion point
+ *
+ * @details A hit refreshes the point, so a coin that stays in place stays
+ * excluded for as long as it is seen.
  */
-void correctGoldCoins(int x, int y, int *counters) {
-    const int distThresholdSq = 80*80;
+bool isExcludedCoin(CoinTracker *tracker, int xc, int yc) {
+    const int PROXIMITY_THRESHOLD = tracker->params.exclusionRadius;
     
-    for (int i = 0; i < MAX_TRACKED_COINS; i++) {
-        if (detectedCoins[i][0] == 0 && detectedCoins[i][1] == 0) 
+    const int n = gridQuery(tracker->excludeGrid, xc, yc, PROXIMITY_THRESHOLD,
+                            tracker->candidates, tracker->candidateCapacity);
+    for (int k = 0; k < n; k++) {
+        ExclusionPoint *point = &tracker->excluded[tracker->candidates[k]];
+        if (!exclusionIsActive(tracker, point))
             continue;
-            
-        const int dx = detectedCoins[i][0] - x;
-        const int dy = detectedCoins[i][1] - y;
-        const int distSq = dx*dx + dy*dy;
         
-        if (distSq <= distThresholdSq && detectedCoins[i][2] >= 4 && detectedCoins[i][2] <= 6) {
-            const int goldType = detectedCoins[i][2];
-            const int goldCounterIdx = goldType - 1;
-            
-            // Decrease counter if necessary
-            if (counters[goldCounterIdx] > 0)
-                counters[goldCounterIdx]--;
-                
-            // Clear entry
-            memset(&detectedCoins[i][0], 0, 5 * sizeof(int));
-            break;
+        const int dx = point->x - xc;
+        const int dy = point->y - yc;
+        
+        if (dx*dx + dy*dy <= PROXIMITY_THRESHOLD * PROXIMITY_THRESHOLD) {
+            point->lastFrame = tracker->frameIndex;
+            point->lastTimeMs = tracker->timestampMs;
+            return true;
         }
     }
+    
+    return false;
 }
 
 /**
  * @brief Draw coins with labels on the frame
  */
-void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
+void drawCoins(CoinTracker *tracker, IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
               int nGoldBlobs, int nCopperBlobs, int nEuroBlobs) {
     unsigned char *data = (unsigned char*)frame->data;
     const int bytesperline = frame->bytesperline;
     const int channels = frame->channels;
     const int width = frame->width;
     const int height = frame->height;
+    const CoinSpecTable *specs = &tracker->specs;
 
     // Draw Euro coins first (they have priority)
     if (euroBlobs && nEuroBlobs > 0) {
@@ -297,9 +1008,9 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
         float bestCircularity = 0.0f;
         int bestArea = 0;
         
-        // Constants
-        const int MAX_VALID_AREA = 100000;
-        const int MIN_VALID_AREA = 12000;
+        // Area limits at the sequence scale
+        const int MAX_VALID_AREA = tracker->params.euroMaxArea;
+        const int MIN_VALID_AREA = tracker->params.drawEuroMinArea;
         
         // Find complete Euro coins first
         for (int i = 0; i < nEuroBlobs; i++) {
@@ -310,10 +1021,11 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
             const float circularity = getCircularity(&euroBlobs[i]);
             
             // Complete Euro detection
-            if (diameter >= 175.0f && diameter <= 210.0f && circularity >= 0.75f) {
+            if (circularity >= specs->minCircularity[VC_MASK_EURO] &&
+                classifyCoin(specs, VC_MASK_EURO, diameter, 1.0f, 0) > 0) {
                 // Skip if this is a gold coin position
-                const int lastType = getCoinTypeAtLocation(euroBlobs[i].xc, euroBlobs[i].yc);
-                if (lastType >= 4 && lastType <= 6)
+                const int lastType = getCoinTypeAtLocation(tracker, euroBlobs[i].xc, euroBlobs[i].yc);
+                if (typeInClass(tracker, lastType, VC_MASK_GOLD))
                     continue;
                     
                 memcpy(&bestEuro, &euroBlobs[i], sizeof(OVC));
@@ -331,13 +1043,14 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
                     
                 const float circularity = getCircularity(&euroBlobs[i]);
                 
-                if (circularity >= 0.65f && 
-                    euroBlobs[i].width >= 130 && euroBlobs[i].height >= 130 &&
+                if (circularity >= tracker->params.euroPartialMinCircularity && 
+                    euroBlobs[i].width >= tracker->params.euroPartialMinSize &&
+                    euroBlobs[i].height >= tracker->params.euroPartialMinSize &&
                     euroBlobs[i].area > bestArea) {
                     
                     // Skip if this is a gold coin position
-                    const int lastType = getCoinTypeAtLocation(euroBlobs[i].xc, euroBlobs[i].yc);
-                    if (lastType >= 4 && lastType <= 6)
+                    const int lastType = getCoinTypeAtLocation(tracker, euroBlobs[i].xc, euroBlobs[i].yc);
+                    if (typeInClass(tracker, lastType, VC_MASK_GOLD))
                         continue;
                         
                     memcpy(&bestEuro, &euroBlobs[i], sizeof(OVC));
@@ -378,7 +1091,8 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
             }
             
             // Draw center dot and labels
-            bool is2Euro = (diameter >= 185.0f || bestEuro.area >= 14000);
+            const CoinSpec *spec = getCoinSpec(specs, classifyCoin(specs, VC_MASK_EURO, diameter, 1.0f, 1));
+            const int textWidth = spec ? 5 * (int)strlen(spec->name) : 10;
             
             // Draw a simple center dot
             const int dotRadius = 3;
@@ -411,7 +1125,7 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
                 
                 // Draw white text (simplified version)
                 for (int y = textY - 5; y <= textY + 5; y++) {
-                    for (int x = textX; x <= textX + (is2Euro ? 15 : 10); x++) {
+                    for (int x = textX; x <= textX + textWidth; x++) {
                         if (x >= 0 && x < width && y >= 0 && y < height) {
                             int pos = y * bytesperline + x * channels;
                             data[pos] = 255;
@@ -427,7 +1141,7 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
     // Draw copper coins
     if (copperBlobs && nCopperBlobs > 0) {
         for (int i = 0; i < nCopperBlobs; i++) {
-            if (copperBlobs[i].area < 7000 || copperBlobs[i].label == 0)
+            if (copperBlobs[i].area < tracker->params.drawMinArea || copperBlobs[i].label == 0)
                 continue;
             
             const float diameter = getDiameter(&copperBlobs[i]);
@@ -471,17 +1185,17 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
                 }
             }
             
-            // Add a simplified label
-            const char *label = (diameter < 130) ? "1c" : 
-                              (diameter < 145) ? "2c" : "5c";
+            // Add a simplified label, sized to the denomination name
+            const CoinSpec *spec = getCoinSpec(specs, classifyCoin(specs, VC_MASK_COPPER, diameter, 1.0f, 1));
+            const int textWidth = spec ? 5 * (int)strlen(spec->name) : 10;
             
             // Very basic text rendering at the center
             int textX = centerX - 5;
             int textY = centerY + 20;
-            if (textX >= 0 && textX < width - 10 && textY >= 0 && textY < height) {
+            if (textX >= 0 && textX < width - textWidth && textY >= 0 && textY < height) {
                 // Create a small black background
                 for (int dy = -5; dy <= 5; dy++) {
-                    for (int dx = -5; dx <= 10; dx++) {
+                    for (int dx = -5; dx <= textWidth; dx++) {
                         int x = textX + dx;
                         int y = textY + dy;
                         if (x >= 0 && x < width && y >= 0 && y < height) {
@@ -495,10 +1209,10 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
                 
                 // Draw white text (very simplified)
                 for (int dy = -4; dy <= 4; dy++) {
-                    for (int dx = -4; dx <= 9; dx++) {
+                    for (int dx = -4; dx < textWidth; dx++) {
                         int x = textX + dx;
                         int y = textY + dy;
-                        if ((dx == -4 || dx == 9 || dy == -4 || dy == 4) && 
+                        if ((dx == -4 || dx == textWidth - 1 || dy == -4 || dy == 4) && 
                             x >= 0 && x < width && y >= 0 && y < height) {
                             int pos = y * bytesperline + x * channels;
                             data[pos] = 255;     // B
@@ -514,7 +1228,7 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
     // Draw gold coins
     if (goldBlobs && nGoldBlobs > 0) {
         for (int i = 0; i < nGoldBlobs; i++) {
-            if (goldBlobs[i].area < 7000 || goldBlobs[i].label == 0)
+            if (goldBlobs[i].area < tracker->params.drawMinArea || goldBlobs[i].label == 0)
                 continue;
             
             const float diameter = getDiameter(&goldBlobs[i]);
@@ -558,16 +1272,16 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
             }
             
             // Simple label based on size
-            const char *label = (diameter < 150) ? "10c" : 
-                              (diameter < 170) ? "20c" : "50c";
+            const CoinSpec *spec = getCoinSpec(specs, classifyCoin(specs, VC_MASK_GOLD, diameter, 1.0f, 1));
+            const int textWidth = spec ? 5 * (int)strlen(spec->name) : 15;
             
             // Very basic text rendering
             int textX = centerX - 8;
             int textY = centerY + 20;
-            if (textX >= 0 && textX < width - 15 && textY >= 0 && textY < height) {
+            if (textX >= 0 && textX < width - textWidth && textY >= 0 && textY < height) {
                 // Black background
                 for (int dy = -5; dy <= 5; dy++) {
-                    for (int dx = -5; dx <= 15; dx++) {
+                    for (int dx = -5; dx <= textWidth; dx++) {
                         int x = textX + dx;
                         int y = textY + dy;
                         if (x >= 0 && x < width && y >= 0 && y < height) {
@@ -581,10 +1295,10 @@ void drawCoins(IVC *frame, OVC *goldBlobs, OVC *copperBlobs, OVC *euroBlobs,
                 
                 // White text outline
                 for (int dy = -4; dy <= 4; dy++) {
-                    for (int dx = -4; dx <= 14; dx++) {
+                    for (int dx = -4; dx < textWidth; dx++) {
                         int x = textX + dx;
                         int y = textY + dy;
-                        if ((dx == -4 || dx == 14 || dy == -4 || dy == 4) &&
+                        if ((dx == -4 || dx == textWidth - 1 || dy == -4 || dy == 4) &&
                             x >= 0 && x < width && y >= 0 && y < height) {
                             int pos = y * bytesperline + x * channels;
                             data[pos] = 255;
@@ -19,286 +19,154 @@
 extern "C" {
 #endif
 
-// Constantes externas de vc_coin.cpp - diâmetros de referência para cada moeda
-extern const float DIAM_1CENT;
-extern const float DIAM_2CENT;
-extern const float DIAM_5CENT;
-extern const float DIAM_10CENT;
-extern const float DIAM_20CENT;
-extern const float DIAM_50CENT;
-extern const float DIAM_1EURO;
-extern const float DIAM_2EURO;
+// Tolerância de referência de vc_coin.cpp (adaptTolerance() devolve-a escalada)
+extern const float BASE_TOLERANCE;
 
-// Declarações de funções externas necessárias para este ficheiro
-int getCoinTypeAtLocation(int x, int y);
-void correctGoldCoins(int x, int y, int *counters);
+// Coloca a moeda encontrada (blob da classe de cor dentro de mainBlob) na fila
+// de deteções do frame. As deteções sem texto (junto às bordas) pesam menos na
+// evidência da denominação
+static void queueCoin(CoinTracker *tracker, const OVC *blob, OVC *mainBlob, int coinType,
+                      float diameter, float circularity, const char *label) {
+    CoinDetection detection;
+
+    detection.x = blob->xc;
+    detection.y = blob->yc;
+    detection.type = coinType;
+    detection.diameter = diameter;
+    detection.circularity = circularity;
+    detection.area = blob->area;
+    detection.label = label;
+    detection.weight = (label != NULL) ? 1.0f : VC_EVIDENCE_EDGE_WEIGHT;
+    detection.track = -1;
+    detection.blobDiameter = getDiameter(mainBlob);
+
+    addDetection(tracker, &detection);
+}
 
 /**
- * @brief Deteta moedas de cobre (1, 2, 5 cêntimos)
+ * @brief Deteta moedas de uma classe de cor pelo diâmetro
  *
- * Esta função analisa os blobs identificados para encontrar moedas de cobre,
- * comparando o seu diâmetro com os valores de referência. Incorpora mecanismos
- * para lidar com moedas parcialmente visíveis nas bordas da imagem.
+ * Procura, entre os blobs da máscara da classe, o primeiro próximo do blob
+ * principal com área e circularidade suficientes e classifica-o com a
+ * tabela de denominações do rastreador. Junto às bordas, onde a moeda pode
+ * estar cortada, mantém o tipo já associado a essa posição ou escolhe a
+ * denominação mais próxima, com uma deteção de menor peso.
  *
- * @param blob Ponteiro para o blob atual em análise
- * @param copperBlobs Array de blobs candidatos a moedas de cobre
- * @param ncopperBlobs Número de blobs candidatos a moedas de cobre
- * @param excludeList Lista de moedas já excluídas da análise
- * @param counters Array de contadores para cada tipo de moeda
+ * @param tracker Rastreador de moedas da sequência de vídeo
+ * @param blob Blob principal em análise
+ * @param classBlobs Blobs da máscara da classe
+ * @param nclassBlobs Número de blobs da máscara da classe
  * @param distThresholdSq Limiar de distância ao quadrado para associação entre blobs
- * @return true se uma moeda de cobre for identificada, false caso contrário
+ * @param colorClass Classe de cor (VC_MASK_COPPER ou VC_MASK_GOLD)
+ * @param yOffset Fração do diâmetro somada a yc no ponto de exclusão
+ * @return true se uma moeda for identificada, false caso contrário
  */
-bool detectCopperCoins(OVC *blob, OVC *copperBlobs, int ncopperBlobs, 
-                     int *excludeList, int *counters, int distThresholdSq) {
-    if (!blob || !copperBlobs || ncopperBlobs <= 0)
-        return false;
+static bool detectClassCoins(CoinTracker *tracker, OVC *blob, OVC *classBlobs, int nclassBlobs,
+                             int distThresholdSq, int colorClass, float yOffset) {
+    const CoinSpecTable *specs = &tracker->specs;
+    const int frameWidth = tracker->width;
+    const int frameHeight = tracker->height;
+    const int edgeMargin = specs->edgeMargin[colorClass];
+    const float MIN_VALID_AREA = tracker->params.minClassArea;
     
-    const int frameWidth = 640;
-    const int frameHeight = 480;
-    const int EDGE_MARGIN = 80;
-    
-    const float MIN_VALID_AREA = 6000;
-    const float MIN_VALID_CIRCULARITY = 0.70f;
+    if (!blob || !classBlobs || nclassBlobs <= 0 || specs->nOrder[colorClass] == 0)
+        return false;
     
-    for (int i = 0; i < ncopperBlobs; i++) {
+    for (int i = 0; i < nclassBlobs; i++) {
         // Ignora blobs inválidos
-        if (copperBlobs[i].label == 0 || copperBlobs[i].area < MIN_VALID_AREA)
+        if (classBlobs[i].label == 0 || classBlobs[i].area < MIN_VALID_AREA)
             continue;
             
         // Verifica a distância entre os centros dos blobs
-        const int dx = copperBlobs[i].xc - blob->xc;
-        const int dy = copperBlobs[i].yc - blob->yc;
-        const int distSq = dx*dx + dy*dy;
+        const int dx = classBlobs[i].xc - blob->xc;
+        const int dy = classBlobs[i].yc - blob->yc;
         
-        if (distSq <= distThresholdSq) {
-            const float diameter = getDiameter(&copperBlobs[i]);
-            const float circularity = getCircularity(&copperBlobs[i]);
-            
-            // Ignora objetos com baixa circularidade
-            if (circularity < MIN_VALID_CIRCULARITY)
-                continue;
-            
-            const int correctedYC = copperBlobs[i].yc + (int)(diameter * 0.05f);
-            const float tolerance = adaptTolerance(copperBlobs[i].xc, 
-                                              copperBlobs[i].yc, 
-                                              frameWidth, frameHeight);
-            
-            // Verifica se a moeda está próxima à borda da imagem
-            const bool isNearEdge = (copperBlobs[i].xc < EDGE_MARGIN || 
-                                   copperBlobs[i].yc < EDGE_MARGIN || 
-                                   copperBlobs[i].xc > frameWidth - EDGE_MARGIN || 
-                                   copperBlobs[i].yc > frameHeight - EDGE_MARGIN);
-            
-            if (isNearEdge) {
-                // Obtém o último tipo de moeda nesta localização
-                const int coinType = getCoinTypeAtLocation(copperBlobs[i].xc, copperBlobs[i].yc);
-                
-                if (coinType >= 1 && coinType <= 3) {
-                    // Evita contagem duplicada se a moeda já foi detetada
-                    if (!trackCoin(copperBlobs[i].xc, copperBlobs[i].yc, coinType, 1))
-                        counters[coinType - 1]++;
-                        
-                    excludeCoin(excludeList, copperBlobs[i].xc, correctedYC, 0);
-                    return true;
-                }
-                
-                // Calcula a melhor correspondência com base na razão de tamanho
-                const float size1Ratio = diameter / DIAM_1CENT;
-                const float size2Ratio = diameter / DIAM_2CENT; 
-                const float size5Ratio = diameter / DIAM_5CENT;
-                
-                const float diff1 = fabsf(size1Ratio - 1.0f);
-                const float diff2 = fabsf(size2Ratio - 1.0f);
-                const float diff5 = fabsf(size5Ratio - 1.0f);
-                
-                // Determina o tipo de moeda mais provável
-                int bestType = (diff1 < diff2 && diff1 < diff5) ? 0 : 
-                              (diff2 < diff1 && diff2 < diff5) ? 1 : 2;
-                
-                if (!trackCoin(copperBlobs[i].xc, copperBlobs[i].yc, bestType + 1, 1))
-                    counters[bestType]++;
-                    
-                excludeCoin(excludeList, copperBlobs[i].xc, correctedYC, 0);
-                return true;
-            }
-            
-            // Calcula os intervalos de comparação para cada tipo de moeda
-            const float d1Lower = DIAM_1CENT * (1.0f - tolerance);
-            const float d1Upper = DIAM_1CENT * (1.0f + tolerance);
-            const float d2Lower = DIAM_2CENT * (1.0f - tolerance);
-            const float d2Upper = DIAM_2CENT * (1.0f + tolerance);
-            const float d5Lower = DIAM_5CENT * (1.0f - tolerance);
-            const float d5Upper = DIAM_5CENT * (1.0f + tolerance);
+        if (dx*dx + dy*dy > distThresholdSq)
+            continue;
+        
+        const float diameter = getDiameter(&classBlobs[i]);
+        const float circularity = getCircularity(&classBlobs[i]);
+        
+        // Ignora objetos com baixa circularidade
+        if (circularity < specs->minCircularity[colorClass])
+            continue;
+        
+        const int excludeY = classBlobs[i].yc + (int)(diameter * yOffset);
+        
+        // Verifica se a moeda está próxima à borda da imagem
+        const bool isNearEdge = (classBlobs[i].xc < edgeMargin || 
+                                 classBlobs[i].yc < edgeMargin || 
+                                 classBlobs[i].xc > frameWidth - edgeMargin || 
+                                 classBlobs[i].yc > frameHeight - edgeMargin);
+        
+        if (isNearEdge) {
+            // O último tipo nesta localização, ou a denominação mais próxima
+            int coinType = getCoinTypeAtLocation(tracker, classBlobs[i].xc, classBlobs[i].yc);
+            const CoinSpec *spec = getCoinSpec(specs, coinType);
+            if (spec == NULL || spec->colorClass != colorClass)
+                coinType = classifyCoin(specs, colorClass, diameter, 1.0f, 1);
             
-            // Verifica correspondência para cada tipo de moeda de cobre
-            if (diameter >= d1Lower && diameter <= d1Upper) {
-                if (!trackCoin(copperBlobs[i].xc, copperBlobs[i].yc, 1, 1)) {
-                    counters[0]++;
-                    printf("[MOEDA] 1 cêntimo | €0.01 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, copperBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, copperBlobs[i].xc, correctedYC, 0);
-                return true;
-            }
-            else if (diameter >= d2Lower && diameter <= d2Upper) {
-                if (!trackCoin(copperBlobs[i].xc, copperBlobs[i].yc, 2, 1)) {
-                    counters[1]++;
-                    printf("[MOEDA] 2 cêntimos | €0.02 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, copperBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, copperBlobs[i].xc, correctedYC, 0);
-                return true;
-            }
-            else if (diameter >= d5Lower && diameter <= d5Upper) {
-                if (!trackCoin(copperBlobs[i].xc, copperBlobs[i].yc, 3, 1)) {
-                    counters[2]++;
-                    printf("[MOEDA] 5 cêntimos | €0.05 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, copperBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, copperBlobs[i].xc, correctedYC, 0);
-                return true;
-            }
+            queueCoin(tracker, &classBlobs[i], blob, coinType, diameter, circularity, NULL);
+            excludeCoin(tracker, classBlobs[i].xc, excludeY, 0);
+            return true;
+        }
+        
+        // Intervalos da tabela, alargados perto das bordas
+        const float tolerance = adaptTolerance(classBlobs[i].xc, classBlobs[i].yc, frameWidth, frameHeight,
+                                               tracker->params.toleranceMargin);
+        const int coinType = classifyCoin(specs, colorClass, diameter, tolerance / BASE_TOLERANCE, 0);
+        const CoinSpec *spec = getCoinSpec(specs, coinType);
+        
+        if (spec != NULL && circularity >= spec->minCircularity) {
+            queueCoin(tracker, &classBlobs[i], blob, coinType, diameter, circularity, spec->label);
+            excludeCoin(tracker, classBlobs[i].xc, excludeY, 0);
+            return true;
         }
     }
     
     return false;
 }
 
+/**
+ * @brief Deteta moedas de cobre (1, 2, 5 cêntimos)
+ *
+ * Esta função analisa os blobs identificados para encontrar moedas de cobre,
+ * comparando o seu diâmetro com as denominações de cobre da tabela do
+ * rastreador. Incorpora mecanismos para lidar com moedas parcialmente
+ * visíveis nas bordas da imagem.
+ *
+ * @param tracker Rastreador de moedas da sequência de vídeo
+ * @param blob Ponteiro para o blob atual em análise
+ * @param copperBlobs Array de blobs candidatos a moedas de cobre
+ * @param ncopperBlobs Número de blobs candidatos a moedas de cobre
+ * @param distThresholdSq Limiar de distância ao quadrado para associação entre blobs
+ * @return true se uma moeda de cobre for identificada, false caso contrário
+ */
+bool detectCopperCoins(CoinTracker *tracker, OVC *blob, OVC *copperBlobs, int ncopperBlobs, 
+                     int distThresholdSq) {
+    // O centro das moedas de cobre (segmentadas em frame2) é corrigido para baixo
+    return detectClassCoins(tracker, blob, copperBlobs, ncopperBlobs, distThresholdSq,
+                            VC_MASK_COPPER, 0.05f);
+}
+
 /**
  * @brief Deteta moedas douradas (10, 20, 50 cêntimos)
  *
  * Esta função processa blobs para identificar moedas douradas, classificando-as
- * com base no seu diâmetro. Utiliza limiares específicos para moedas douradas e
- * implementa estratégias para lidar com moedas próximas às bordas da imagem.
+ * com base no seu diâmetro e nas denominações douradas da tabela do
+ * rastreador, com a circularidade e a margem de borda dessas denominações.
  * 
+ * @param tracker Rastreador de moedas da sequência de vídeo
  * @param blob Ponteiro para o blob atual em análise
  * @param goldBlobs Array de blobs candidatos a moedas douradas
  * @param ngoldBlobs Número de blobs candidatos a moedas douradas
- * @param excludeList Lista de moedas já excluídas da análise
- * @param counters Array de contadores para cada tipo de moeda
  * @param distThresholdSq Limiar de distância ao quadrado para associação entre blobs
  * @return true se uma moeda dourada for identificada, false caso contrário
  */
-bool detectGoldCoins(OVC *blob, OVC *goldBlobs, int ngoldBlobs, 
-                   int *excludeList, int *counters, int distThresholdSq) {
-    if (!blob || !goldBlobs || ngoldBlobs <= 0)
-        return false;
-    
-    const int frameWidth = 640;
-    const int frameHeight = 480;
-    const int EDGE_MARGIN = 90; // Margem maior para moedas douradas
-    
-    // Pré-calcula intervalos de diâmetro para comparação eficiente
-    const float MIN_VALID_AREA = 6000;
-    const float MIN_VALID_CIRCULARITY = 0.75f; // Circularidade maior para moedas douradas
-    
-    for (int i = 0; i < ngoldBlobs; i++) {
-        // Ignora blobs inválidos rapidamente
-        if (goldBlobs[i].label == 0 || goldBlobs[i].area < MIN_VALID_AREA)
-            continue;
-            
-        // Verifica distância com menos operações
-        const int dx = goldBlobs[i].xc - blob->xc;
-        const int dy = goldBlobs[i].yc - blob->yc;
-        const int distSq = dx*dx + dy*dy;
-        
-        if (distSq <= distThresholdSq) {
-            const float diameter = getDiameter(&goldBlobs[i]);
-            const float circularity = getCircularity(&goldBlobs[i]);
-            
-            // Ignora objetos não circulares
-            if (circularity < MIN_VALID_CIRCULARITY)
-                continue;
-            
-            const float tolerance = adaptTolerance(goldBlobs[i].xc, 
-                                              goldBlobs[i].yc, 
-                                              frameWidth, frameHeight);
-            
-            // Verifica se a moeda está próxima à borda da imagem
-            const bool isNearEdge = (goldBlobs[i].xc < EDGE_MARGIN || 
-                                   goldBlobs[i].yc < EDGE_MARGIN || 
-                                   goldBlobs[i].xc > frameWidth - EDGE_MARGIN || 
-                                   goldBlobs[i].yc > frameHeight - EDGE_MARGIN);
-            
-            if (isNearEdge) {
-                // Obtém o último tipo de moeda nesta localização
-                const int coinType = getCoinTypeAtLocation(goldBlobs[i].xc, goldBlobs[i].yc);
-                
-                if (coinType >= 4 && coinType <= 6) {
-                    // Evita contagem duplicada se a moeda já foi detetada
-                    if (!trackCoin(goldBlobs[i].xc, goldBlobs[i].yc, coinType, 1))
-                        counters[coinType - 1]++;
-                        
-                    excludeCoin(excludeList, goldBlobs[i].xc, goldBlobs[i].yc, 0);
-                    return true;
-                }
-                
-                // Calcula a melhor correspondência com base na razão de tamanho
-                const float size10Ratio = diameter / DIAM_10CENT;
-                const float size20Ratio = diameter / DIAM_20CENT; 
-                const float size50Ratio = diameter / DIAM_50CENT;
-                
-                const float diff10 = fabsf(size10Ratio - 1.0f);
-                const float diff20 = fabsf(size20Ratio - 1.0f);
-                const float diff50 = fabsf(size50Ratio - 1.0f);
-                
-                // Índice com offset para moedas douradas (3 = 10c, 4 = 20c, 5 = 50c)
-                int bestType = (diff10 < diff20 && diff10 < diff50) ? 3 : 
-                              (diff20 < diff10 && diff20 < diff50) ? 4 : 5;
-                
-                if (!trackCoin(goldBlobs[i].xc, goldBlobs[i].yc, bestType + 1, 1))
-                    counters[bestType]++;
-                    
-                excludeCoin(excludeList, goldBlobs[i].xc, goldBlobs[i].yc, 0);
-                return true;
-            }
-            
-            // Utiliza intervalos pré-calculados para comparação rápida
-            const float d10Lower = DIAM_10CENT * (1.0f - tolerance);
-            const float d10Upper = DIAM_10CENT * (1.0f + tolerance);
-            const float d20Lower = DIAM_20CENT * (1.0f - tolerance);
-            const float d20Upper = DIAM_20CENT * (1.0f + tolerance);
-            const float d50Lower = DIAM_50CENT * (1.0f - tolerance);
-            const float d50Upper = DIAM_50CENT * (1.0f + tolerance);
-            
-            // Condições otimizadas com lógica mais simples
-            if (diameter >= d10Lower && diameter <= d10Upper) {
-                if (!trackCoin(goldBlobs[i].xc, goldBlobs[i].yc, 4, 1)) {
-                    counters[3]++;
-                    printf("[MOEDA] 10 cêntimos | €0.10 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, goldBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, goldBlobs[i].xc, goldBlobs[i].yc, 0);
-                return true;
-            }
-            else if (diameter >= d20Lower && diameter <= d20Upper) {
-                if (!trackCoin(goldBlobs[i].xc, goldBlobs[i].yc, 5, 1)) {
-                    counters[4]++;
-                    printf("[MOEDA] 20 cêntimos | €0.20 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, goldBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, goldBlobs[i].xc, goldBlobs[i].yc, 0);
-                return true;
-            }
-            else if (diameter >= d50Lower && diameter <= d50Upper) {
-                if (!trackCoin(goldBlobs[i].xc, goldBlobs[i].yc, 6, 1)) {
-                    counters[5]++;
-                    printf("[MOEDA] 50 cêntimos | €0.50 | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
-                          diameter, goldBlobs[i].area, circularity);
-                }
-                
-                excludeCoin(excludeList, goldBlobs[i].xc, goldBlobs[i].yc, 0);
-                return true;
-            }
-        }
-    }
-    
-    return false;
+bool detectGoldCoins(CoinTracker *tracker, OVC *blob, OVC *goldBlobs, int ngoldBlobs, 
+                   int distThresholdSq) {
+    return detectClassCoins(tracker, blob, goldBlobs, ngoldBlobs, distThresholdSq,
+                            VC_MASK_GOLD, 0.0f);
 }
 
 /**
@@ -309,25 +177,27 @@ bool detectGoldCoins(OVC *blob, OVC *goldBlobs, int ngoldBlobs,
  * com boa circularidade, depois procura moedas parciais que podem estar parcialmente
  * visíveis na imagem.
  * 
+ * @param tracker Rastreador de moedas da sequência de vídeo
  * @param blob Ponteiro para o blob atual em análise
  * @param euroBlobs Array de blobs candidatos a moedas de Euro
  * @param neuroBlobs Número de blobs candidatos a moedas de Euro
- * @param excludeList Lista de moedas já excluídas da análise
- * @param counters Array de contadores para cada tipo de moeda
  * @param distThresholdSq Limiar de distância ao quadrado para associação entre blobs
  * @return true se uma moeda de Euro for identificada, false caso contrário
  */
-bool detectEuroCoins(OVC *blob, OVC *euroBlobs, int neuroBlobs, 
-                   int *excludeList, int *counters, int distThresholdSq) {
-    if (!blob || !euroBlobs || neuroBlobs <= 0)
+bool detectEuroCoins(CoinTracker *tracker, OVC *blob, OVC *euroBlobs, int neuroBlobs, 
+                   int distThresholdSq) {
+    const CoinSpecTable *specs = &tracker->specs;
+    
+    if (!blob || !euroBlobs || neuroBlobs <= 0 || specs->nOrder[VC_MASK_EURO] == 0)
         return false;
     
-    // Constantes
-    const int MAX_VALID_AREA = 100000;  
-    const int MIN_VALID_AREA = 6000;
+    // Limites de área (à escala da sequência)
+    const int MAX_VALID_AREA = tracker->params.euroMaxArea;
+    const int MIN_VALID_AREA = tracker->params.minClassArea;
     
     // Rastreia os melhores candidatos
     int bestCompleteIndex = -1;
+    int bestCompleteType = 0;
     float bestCompleteDiameter = 0.0f;
     float bestCompleteCircularity = 0.0f;
     
@@ -344,16 +214,20 @@ bool detectEuroCoins(OVC *blob, OVC *euroBlobs, int neuroBlobs,
         const float diameter = getDiameter(&euroBlobs[i]);
         const float circularity = getCircularity(&euroBlobs[i]);
         
-        // Moedas de Euro completas
-        if (diameter >= 175.0f && diameter <= 210.0f && circularity > 0.75f) {
+        // Moedas de Euro completas (diâmetro dentro de uma denominação de Euro)
+        const int coinType = classifyCoin(specs, VC_MASK_EURO, diameter, 1.0f, 0);
+        const CoinSpec *spec = getCoinSpec(specs, coinType);
+        if (spec != NULL && circularity > spec->minCircularity) {
             if (bestCompleteIndex == -1 || circularity > bestCompleteCircularity) {
                 bestCompleteIndex = i;
+                bestCompleteType = coinType;
                 bestCompleteDiameter = diameter;
                 bestCompleteCircularity = circularity;
             }
         }
         // Moedas de Euro parciais
-        else if (circularity > 0.65f && euroBlobs[i].width >= 130 && euroBlobs[i].height >= 130) {
+        else if (circularity > tracker->params.euroPartialMinCircularity && euroBlobs[i].width >= tracker->params.euroPartialMinSize &&
+                 euroBlobs[i].height >= tracker->params.euroPartialMinSize) {
             if (bestPartialIndex == -1 || euroBlobs[i].area > bestPartialArea) {
                 bestPartialIndex = i;
                 bestPartialDiameter = diameter;
@@ -364,64 +238,28 @@ bool detectEuroCoins(OVC *blob, OVC *euroBlobs, int neuroBlobs,
     
     // Processa primeiro a moeda de Euro completa
     if (bestCompleteIndex >= 0) {
-        // Determina o tipo de Euro
-        const bool is2Euro = (bestCompleteDiameter >= 185.0f);
-        const int coinType = is2Euro ? 8 : 7;
-        const int counterIdx = is2Euro ? 7 : 6;
+        // Contabilizada quando a evidência for conclusiva (uma moeda dourada
+        // identificada incorretamente no mesmo sítio passa a contar como Euro)
+        queueCoin(tracker, &euroBlobs[bestCompleteIndex], blob, bestCompleteType,
+                  bestCompleteDiameter, bestCompleteCircularity,
+                  specs->specs[bestCompleteType - 1].label);
         
-        // Corrige moedas douradas identificadas incorretamente
-        correctGoldCoins(euroBlobs[bestCompleteIndex].xc, 
-                        euroBlobs[bestCompleteIndex].yc, 
-                        counters);
-        
-        // Contabiliza se ainda não foi contada
-        if (!trackCoin(euroBlobs[bestCompleteIndex].xc, 
-                     euroBlobs[bestCompleteIndex].yc, 
-                     coinType, 1)) {
-            counters[counterIdx]++;
-            
-            // Regista informações detalhadas da moeda
-            const float diameter = bestCompleteDiameter;
-            const float circularity = bestCompleteCircularity;
-            const int area = euroBlobs[bestCompleteIndex].area;
-            
-            if (is2Euro) {
-                printf("[MOEDA] 2 Euros | €2.00 | Diâm: %.1f | Área: %d | Circ: %.2f\n",
-                      diameter, area, circularity);
-            } else {
-                printf("[MOEDA] 1 Euro | €1.00 | Diâm: %.1f | Área: %d | Circ: %.2f\n",
-                      diameter, area, circularity);
-            }
-        }
-        
-        excludeCoin(excludeList, euroBlobs[bestCompleteIndex].xc, 
+        excludeCoin(tracker, euroBlobs[bestCompleteIndex].xc, 
                   euroBlobs[bestCompleteIndex].yc, 0);
         return true;
     }
     
     // Processa moeda de Euro parcial se for significativa
-    else if (bestPartialIndex >= 0 && bestPartialArea >= 14000) {
-        const int coinType = 8;  
-        const int counterIdx = 7;
-        
-        // Corrige moedas douradas identificadas incorretamente
-        correctGoldCoins(euroBlobs[bestPartialIndex].xc, 
-                       euroBlobs[bestPartialIndex].yc, 
-                       counters);
+    else if (bestPartialIndex >= 0 && bestPartialArea >= tracker->params.euroPartialMinArea) {
+        // Uma parte tão grande só pode ser da maior moeda de Euro
+        const int largest = specs->order[VC_MASK_EURO][specs->nOrder[VC_MASK_EURO] - 1];
         
-        // Contabiliza se ainda não foi contada
-        if (!trackCoin(euroBlobs[bestPartialIndex].xc, 
-                     euroBlobs[bestPartialIndex].yc, 
-                     coinType, 1)) {
-            counters[counterIdx]++;
-            
-            // Regista informações detalhadas da moeda
-            printf("[MOEDA] 2 Euros (parcial) | €2.00 | Diâm: %.1f | Área: %d | Circ: %.2f\n",
-                  bestPartialDiameter, bestPartialArea, 
-                  getCircularity(&euroBlobs[bestPartialIndex]));
-        }
+        // Contabilizada quando a evidência for conclusiva
+        queueCoin(tracker, &euroBlobs[bestPartialIndex], blob, largest + 1,
+                  bestPartialDiameter, getCircularity(&euroBlobs[bestPartialIndex]),
+                  specs->specs[largest].label);
         
-        excludeCoin(excludeList, euroBlobs[bestPartialIndex].xc, 
+        excludeCoin(tracker, euroBlobs[bestPartialIndex].xc, 
                   euroBlobs[bestPartialIndex].yc, 0);
         return true;
     }
@@ -0,0 +1,351 @@
+/**
+ * @file vc_coin_spec.cpp
+ * @brief Tabela de denominações e classificação de moedas pelo diâmetro.
+ *
+ * Este ficheiro define as moedas de Euro de referência, a leitura de uma
+ * especificação alternativa a partir de um ficheiro de texto (outras
+ * moedas ou outra lente) e o classificador único usado pela deteção e pela
+ * visualização: uma pesquisa binária nas denominações da classe de cor,
+ * ordenadas por diâmetro.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Moedas de Euro de referência (diâmetros em pixels na montagem original e
+// diâmetros reais em mm)
+static const CoinSpec DEFAULT_SPECS[] = {
+    { "1c",  "1 cêntimo | €0.01",   0.01f, 122.0f, 16.25f, VC_MASK_COPPER, 0.08f,  0.70f, 80 },
+    { "2c",  "2 cêntimos | €0.02",  0.02f, 135.0f, 18.75f, VC_MASK_COPPER, 0.08f,  0.70f, 80 },
+    { "5c",  "5 cêntimos | €0.05",  0.05f, 152.0f, 21.25f, VC_MASK_COPPER, 0.08f,  0.70f, 80 },
+    { "10c", "10 cêntimos | €0.10", 0.10f, 143.0f, 19.75f, VC_MASK_GOLD,   0.08f,  0.75f, 90 },
+    { "20c", "20 cêntimos | €0.20", 0.20f, 160.0f, 22.25f, VC_MASK_GOLD,   0.08f,  0.75f, 90 },
+    { "50c", "50 cêntimos | €0.50", 0.50f, 174.0f, 24.25f, VC_MASK_GOLD,   0.08f,  0.75f, 90 },
+    { "1€",  "1 Euro | €1.00",      1.00f, 185.0f, 23.25f, VC_MASK_EURO,   0.055f, 0.75f, 0 },
+    { "2€",  "2 Euros | €2.00",     2.00f, 195.0f, 25.75f, VC_MASK_EURO,   0.077f, 0.75f, 0 },
+};
+
+/**
+ * @brief Preenche uma tabela com as moedas de Euro de referência
+ */
+void defaultCoinSpecs(CoinSpecTable *table) {
+    memset(table, 0, sizeof(CoinSpecTable));
+    memcpy(table->specs, DEFAULT_SPECS, sizeof(DEFAULT_SPECS));
+    table->nSpecs = sizeof(DEFAULT_SPECS) / sizeof(DEFAULT_SPECS[0]);
+    indexCoinSpecs(table);
+}
+
+/**
+ * @brief Reconstrói os índices por classe de cor
+ *
+ * Ordena as denominações de cada classe por diâmetro (inserção, no máximo
+ * VC_MAX_COIN_TYPES entradas) e calcula os limites comuns da classe.
+ */
+void indexCoinSpecs(CoinSpecTable *table) {
+    int c, i, j;
+
+    for (c = 0; c < VC_NUM_MASKS; c++) {
+        table->nOrder[c] = 0;
+        table->minCircularity[c] = 1.0f;
+        table->edgeMargin[c] = 0;
+    }
+
+    for (i = 0; i < table->nSpecs; i++) {
+        const CoinSpec *spec = &table->specs[i];
+        const int c = spec->colorClass;
+        int *order = table->order[c];
+
+        for (j = table->nOrder[c]; j > 0 && table->specs[order[j - 1]].diameter > spec->diameter; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+        table->nOrder[c]++;
+
+        table->minCircularity[c] = VC_MIN(table->minCircularity[c], spec->minCircularity);
+        table->edgeMargin[c] = VC_MAX(table->edgeMargin[c], spec->edgeMargin);
+    }
+}
+
+// Classe de cor a partir do nome usado no ficheiro de especificação
+static int parseColorClass(const char *name) {
+    if (strcmp(name, "copper") == 0) return VC_MASK_COPPER;
+    if (strcmp(name, "gold") == 0) return VC_MASK_GOLD;
+    if (strcmp(name, "euro") == 0) return VC_MASK_EURO;
+    return -1;
+}
+
+/**
+ * @brief Lê a especificação das moedas de um ficheiro de texto
+ *
+ * Exemplo de linha (as moedas são numeradas pela ordem do ficheiro):
+ * @code
+ * 1c 0.01 122 16.25 copper 0.08 0.70 80 1 cêntimo | €0.01
+ * @endcode
+ */
+int loadCoinSpecs(CoinSpecTable *table, const char *filename) {
+    CoinSpecTable loaded;
+    char line[256], className[16];
+    int lineNumber = 0, consumed;
+    FILE *file;
+
+    if (table == NULL || filename == NULL) return 0;
+    if ((file = fopen(filename, "r")) == NULL) return 0;
+
+    memset(&loaded, 0, sizeof(CoinSpecTable));
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *text = line;
+        lineNumber++;
+
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0')
+            continue;
+
+        if (loaded.nSpecs == VC_MAX_COIN_TYPES) {
+            fprintf(stderr, "%s:%d: mais de %d moedas\n", filename, lineNumber, VC_MAX_COIN_TYPES);
+            fclose(file);
+            return 0;
+        }
+
+        CoinSpec *spec = &loaded.specs[loaded.nSpecs];
+        consumed = 0;
+        if (sscanf(text, "%7s %f %f %f %15s %f %f %d %n", spec->name, &spec->value, &spec->diameter,
+                   &spec->diameterMm, className, &spec->tolerance, &spec->minCircularity,
+                   &spec->edgeMargin, &consumed) < 8 ||
+            (spec->colorClass = parseColorClass(className)) < 0 ||
+            spec->diameter <= 0.0f || spec->diameterMm < 0.0f || spec->tolerance < 0.0f) {
+            fprintf(stderr, "%s:%d: linha inválida\n", filename, lineNumber);
+            fclose(file);
+            return 0;
+        }
+
+        // O texto é o resto da linha, sem a mudança de linha
+        strncpy(spec->label, text + consumed, sizeof(spec->label) - 1);
+        spec->label[strcspn(spec->label, "\r\n")] = '\0';
+        if (spec->label[0] == '\0')
+            strcpy(spec->label, spec->name);
+
+        loaded.nSpecs++;
+    }
+
+    fclose(file);
+    if (loaded.nSpecs == 0) return 0;
+
+    indexCoinSpecs(&loaded);
+    *table = loaded;
+
+    return table->nSpecs;
+}
+
+/**
+ * @brief Especificação de um tipo de moeda (NULL se o tipo não existir)
+ */
+const CoinSpec *getCoinSpec(const CoinSpecTable *table, int coinType) {
+    if (table == NULL || coinType < 1 || coinType > table->nSpecs) return NULL;
+    return &table->specs[coinType - 1];
+}
+
+/**
+ * @brief Classifica uma moeda pelo diâmetro dentro de uma classe de cor
+ *
+ * Procura por bisseção a primeira denominação da classe com diâmetro
+ * nominal >= diameter; só essa e a anterior podem ser as mais próximas.
+ * Das duas, escolhe a mais próxima cujo intervalo
+ * [diâmetro * (1 - tol), diâmetro * (1 + tol)] contém a medida.
+ */
+int classifyCoin(const CoinSpecTable *table, int colorClass, float diameter, float toleranceScale, int nearest) {
+    int lo = 0, hi, k, best = -1;
+    float bestDiff = 0.0f;
+
+    if (table == NULL || colorClass < 0 || colorClass >= VC_NUM_MASKS) return 0;
+
+    const int *order = table->order[colorClass];
+    hi = table->nOrder[colorClass];
+
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (table->specs[order[mid]].diameter < diameter) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (k = lo - 1; k <= lo; k++) {
+        if (k < 0 || k >= table->nOrder[colorClass]) continue;
+
+        const CoinSpec *spec = &table->specs[order[k]];
+        const float diff = fabsf(diameter - spec->diameter);
+        if (!nearest && diff > spec->diameter * spec->tolerance * toleranceScale)
+            continue;
+
+        if (best < 0 || diff < bestDiff) {
+            best = order[k];
+            bestDiff = diff;
+        }
+    }
+
+    return best + 1;
+}
+
+/**
+ * @brief Escala (px/mm) implícita nos diâmetros atuais da tabela
+ *
+ * Mediana de diameter / diameterMm das denominações com diâmetro real.
+ */
+float coinSpecScale(const CoinSpecTable *table) {
+    float ratios[VC_MAX_COIN_TYPES];
+    int n = 0, i, j;
+
+    for (i = 0; i < table->nSpecs; i++) {
+        const CoinSpec *spec = &table->specs[i];
+        if (spec->diameterMm <= 0.0f) continue;
+
+        const float r = spec->diameter / spec->diameterMm;
+        for (j = n; j > 0 && ratios[j - 1] > r; j--)
+            ratios[j] = ratios[j - 1];
+        ratios[j] = r;
+        n++;
+    }
+
+    if (n == 0) return 0.0f;
+    return (n % 2) ? ratios[n / 2] : 0.5f * (ratios[n / 2 - 1] + ratios[n / 2]);
+}
+
+/**
+ * @brief Multiplica todos os diâmetros e margens de borda da tabela por factor
+ *
+ * As tolerâncias são relativas e não mudam.
+ */
+void resizeCoinSpecs(CoinSpecTable *table, float factor) {
+    int i;
+
+    if (factor <= 0.0f) return;
+
+    for (i = 0; i < table->nSpecs; i++) {
+        CoinSpec *spec = &table->specs[i];
+        spec->diameter *= factor;
+        spec->edgeMargin = (int)lroundf(spec->edgeMargin * factor);
+    }
+
+    indexCoinSpecs(table);
+}
+
+/**
+ * @brief Muda a escala da tabela para pxPerMm
+ *
+ * Todos os diâmetros e margens de borda são multiplicados por
+ * pxPerMm / coinSpecScale(). Assim o desvio de cada denominação em relação
+ * ao diâmetro real (a segmentação de cada máscara não apanha exatamente o
+ * bordo da moeda) mantém-se.
+ */
+void scaleCoinSpecs(CoinSpecTable *table, float pxPerMm) {
+    const float current = coinSpecScale(table);
+
+    if (pxPerMm <= 0.0f || current <= 0.0f) return;
+
+    resizeCoinSpecs(table, pxPerMm / current);
+}
+
+// Razão diâmetro observado / diâmetro nominal da denominação da classe que
+// melhor explica a amostra ao fator de escala factor (0 se nenhuma explicar)
+static float explainedRatio(const CoinSpecTable *table, float diameter, int colorClass,
+                            float factor, float *error) {
+    float best = -1.0f, ratio = 0.0f;
+    int k;
+
+    for (k = 0; k < table->nOrder[colorClass]; k++) {
+        const CoinSpec *spec = &table->specs[table->order[colorClass][k]];
+        const float rel = fabsf(diameter / (spec->diameter * factor) - 1.0f);
+
+        if (rel <= spec->tolerance && (best < 0.0f || rel < best)) {
+            best = rel;
+            ratio = diameter / spec->diameter;
+        }
+    }
+
+    if (best >= 0.0f && error != NULL) *error += best * best;
+    return ratio;
+}
+
+/**
+ * @brief Ajusta a escala (px/mm) que melhor explica os diâmetros observados
+ *
+ * Procura o fator f tal que os diâmetros da tabela multiplicados por f
+ * explicam o maior número de amostras dentro da tolerância da denominação
+ * mais próxima da mesma classe de cor. Cada par (amostra, denominação)
+ * propõe um fator; em caso de empate fica o de menor erro e depois o mais
+ * próximo de 1. O fator final é a mediana das razões das amostras
+ * explicadas, e a escala devolvida é coinSpecScale() * f.
+ *
+ * @param table Tabela de denominações (com diâmetros reais)
+ * @param diameters Diâmetros observados em pixels
+ * @param classes Classe de cor de cada amostra
+ * @param n Número de amostras
+ * @return Escala em px/mm, ou 0 se a escala explicar menos de
+ *         VC_CALIBRATION_MIN_SAMPLES amostras ou menos de um terço delas
+ */
+float fitPixelScale(const CoinSpecTable *table, const float *diameters, const int *classes, int n) {
+    const float current = coinSpecScale(table);
+    float bestFactor = 0.0f, bestError = 0.0f;
+    int bestInliers = 0, i, j, k, m;
+
+    if (current <= 0.0f || n <= 0) return 0.0f;
+
+    for (i = 0; i < n; i++) {
+        const int c = classes[i];
+        if (c < 0 || c >= VC_NUM_MASKS) return 0.0f;
+
+        for (k = 0; k < table->nOrder[c]; k++) {
+            const float factor = diameters[i] / table->specs[table->order[c][k]].diameter;
+            float error = 0.0f;
+            int inliers = 0;
+
+            for (j = 0; j < n; j++) {
+                if (explainedRatio(table, diameters[j], classes[j], factor, &error) > 0.0f)
+                    inliers++;
+            }
+
+            if (inliers > bestInliers ||
+                (inliers == bestInliers && inliers > 0 &&
+                 (error < bestError ||
+                  (error == bestError && fabsf(factor - 1.0f) < fabsf(bestFactor - 1.0f))))) {
+                bestFactor = factor;
+                bestError = error;
+                bestInliers = inliers;
+            }
+        }
+    }
+
+    if (bestInliers < VC_CALIBRATION_MIN_SAMPLES || 3 * bestInliers < n) return 0.0f;
+
+    // Refina com a mediana das razões das amostras explicadas
+    float *ratios = (float *)malloc(bestInliers * sizeof(float));
+    if (ratios == NULL) return current * bestFactor;
+
+    for (i = 0, m = 0; i < n && m < bestInliers; i++) {
+        const float ratio = explainedRatio(table, diameters[i], classes[i], bestFactor, NULL);
+        if (ratio <= 0.0f) continue;
+
+        for (j = m; j > 0 && ratios[j - 1] > ratio; j--)
+            ratios[j] = ratios[j - 1];
+        ratios[j] = ratio;
+        m++;
+    }
+
+    const float factor = (m % 2) ? ratios[m / 2] : 0.5f * (ratios[m / 2 - 1] + ratios[m / 2]);
+    free(ratios);
+
+    return current * factor;
+}
+
+#ifdef __cplusplus
+}
+#endif
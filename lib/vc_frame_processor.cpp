@@ -22,237 +22,1289 @@
 extern "C" {
 #endif
 
-// Referência externa ao array de moedas rastreadas
-extern int MAX_TRACKED_COINS;
-extern int detectedCoins[150][5]; // [x, y, tipoMoeda, frameDetectado, contabilizada]
+// Parâmetros de segmentação de cada máscara (os kernels morfológicos
+// dependem da escala e estão em CoinTracker::params)
+typedef struct {
+    int segmentType;  // Tipo de segmentação HSV (-1 = só luminância)
+    int threshold;    // Limiar fixo inicial da máscara
+    int useFrame2;    // Segmenta frame2 em vez de frame
+} MaskParams;
+
+static const MaskParams MASK_PARAMS[VC_NUM_MASKS] = {
+    { -1, 150, 0 }, // VC_MASK_MAIN
+    {  0, 110, 0 }, // VC_MASK_GOLD
+    {  1,  80, 1 }, // VC_MASK_COPPER
+    {  2,  90, 0 }, // VC_MASK_EURO
+};
 
 /**
- * @brief Processa um frame para detetar e classificar moedas
+ * @brief Cria o estado de processamento de frames
  *
- * Esta função implementa o fluxo completo de processamento para deteção de moedas
- * num frame de vídeo. O processo inclui:
- * - Conversão de espaços de cor (BGR para RGB, RGB para HSV)
- * - Segmentação das imagens para diferentes tipos de moedas (douradas, cobre, euro)
- * - Deteção e análise de blobs
- * - Classificação das moedas detetadas
- * - Visualização dos resultados no frame original
- * - Contabilização das moedas por tipo e valor
+ * Aloca de uma só vez todas as imagens de trabalho usadas por
+ * processFrame(), as pirâmides do modo grosseiro e o rastreador de moedas
+ * da sequência. Por omissão usa o modo de deteção à resolução total e, no
+ * modo grosseiro, o nível 2 da pirâmide (1/4). A re-deteção nas ROIs
+ * previstas (roiTracking) começa desligada e sem faixa de entrada, e a
+ * segmentação é sequencial (sem escalonador).
  *
- * A função utiliza várias imagens temporárias para processar diferentes características
- * das moedas, explorando propriedades de cor e forma para a classificação.
- * 
- * @param frame Frame principal para análise (entrada e saída para visualização)
- * @param frame2 Frame secundário para análise complementar
- * @param excludeList Lista de coordenadas de moedas a excluir da análise
- * @param coinCounts Array com contadores para cada tipo de moeda
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @return Ponteiro para o processador criado, ou NULL em caso de erro
  */
-void processFrame(IVC *frame, IVC *frame2, int *excludeList, int *coinCounts) {
-    // Incrementa o contador de frames
-    frameCounter(0);
-    
-    // Validação básica dos parâmetros
-    if (!frame || !frame2 || !excludeList || !coinCounts) 
+FrameProcessor *createFrameProcessor(int width, int height) {
+    FrameProcessor *proc;
+
+    if (width <= 0 || height <= 0) return NULL;
+
+    proc = (FrameProcessor *)calloc(1, sizeof(FrameProcessor));
+    if (proc == NULL) return NULL;
+
+    proc->width = width;
+    proc->height = height;
+    proc->detectMode = VC_DETECT_FULL;
+    proc->coarseLevel = 2;
+    proc->roiTracking = 0;
+    proc->fullFrameInterval = VC_ROI_FULL_INTERVAL;
+    proc->tracker = createTracker(width, height);
+
+    proc->rgbImage = createImage(width, height, 3, 255);
+    proc->rgbImage2 = createImage(width, height, 3, 255);
+    proc->hsvImage = createImage(width, height, 3, 255);
+    proc->binaryImage = createImage(width, height, 1, 255);
+    proc->labelImage = createImage(width, height, 1, 255);
+    proc->grayImage = createImage(width, height, 1, 255);
+    proc->roiImage = createImage(width, height, 3, 255);
+    proc->integral = createIntegral(width, height, VC_INTEGRAL_32);
+    proc->pyramid = createPyramid(width, height, 3, proc->coarseLevel + 1);
+    proc->pyramid2 = createPyramid(width, height, 3, proc->coarseLevel + 1);
+
+    if (!proc->tracker || !proc->rgbImage || !proc->rgbImage2 || !proc->hsvImage ||
+        !proc->binaryImage || !proc->labelImage || !proc->grayImage || !proc->roiImage || !proc->integral ||
+        !proc->pyramid || !proc->pyramid2) {
+        return freeFrameProcessor(proc);
+    }
+
+    // Todas as máscaras começam com os limiares fixos de referência
+    for (int i = 0; i < VC_NUM_MASKS; i++) {
+        initThreshold(&proc->thresholds[i], VC_THRESH_FIXED, MASK_PARAMS[i].threshold);
+    }
+
+    return proc;
+}
+
+/**
+ * @brief Liberta o estado de processamento de frames
+ * @param proc Ponteiro para o processador
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+FrameProcessor *freeFrameProcessor(FrameProcessor *proc) {
+    if (proc != NULL) {
+        if (proc->tracker) freeTracker(proc->tracker);
+        if (proc->rgbImage) freeImage(proc->rgbImage);
+        if (proc->rgbImage2) freeImage(proc->rgbImage2);
+        if (proc->hsvImage) freeImage(proc->hsvImage);
+        if (proc->binaryImage) freeImage(proc->binaryImage);
+        if (proc->labelImage) freeImage(proc->labelImage);
+        if (proc->grayImage) freeImage(proc->grayImage);
+        if (proc->roiImage) freeImage(proc->roiImage);
+        if (proc->regions) free(proc->regions);
+        if (proc->calibration.diameters) free(proc->calibration.diameters);
+        if (proc->calibration.classes) free(proc->calibration.classes);
+        if (proc->integral) freeIntegral(proc->integral);
+        if (proc->pyramid) freePyramid(proc->pyramid);
+        if (proc->pyramid2) freePyramid(proc->pyramid2);
+        if (proc->motion) freeMotionGate(proc->motion);
+        if (proc->background) freeBackgroundModel(proc->background);
+        if (proc->tripwire) freeTripwire(proc->tripwire);
+        free(proc);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Cria um processador com a mesma configuração de outro
+ *
+ * Copia o modo de deteção, o seguimento por ROIs, os limiares, o
+ * escalonador, os parâmetros do detetor de movimento, do modelo de fundo
+ * e da linha de contagem e, no rastreador, as denominações já à escala dos
+ * frames, os parâmetros derivados, a cadência nominal e as janelas de
+ * memória. Os buffers são novos, o rastreador, o detetor de movimento, o
+ * modelo de fundo e as pistas da linha começam vazios e uma calibração em
+ * curso não é copiada (apenas a escala já ajustada). Serve para processar
+ * várias sequências, ou vários troços da mesma, com a configuração de proc.
+ *
+ * @param proc Processador de referência
+ * @return Ponteiro para o novo processador, ou NULL em caso de erro
+ */
+FrameProcessor *cloneFrameProcessor(const FrameProcessor *proc) {
+    FrameProcessor *copy;
+
+    if (proc == NULL) return NULL;
+
+    copy = createFrameProcessor(proc->width, proc->height);
+    if (copy == NULL) return NULL;
+
+    // A pirâmide tem de chegar ao nível do modo grosseiro
+    if (proc->coarseLevel != copy->coarseLevel) {
+        freePyramid(copy->pyramid);
+        freePyramid(copy->pyramid2);
+        copy->coarseLevel = proc->coarseLevel;
+        copy->pyramid = createPyramid(proc->width, proc->height, 3, copy->coarseLevel + 1);
+        copy->pyramid2 = createPyramid(proc->width, proc->height, 3, copy->coarseLevel + 1);
+        if (!copy->pyramid || !copy->pyramid2) return freeFrameProcessor(copy);
+    }
+
+    copy->detectMode = proc->detectMode;
+    copy->roiTracking = proc->roiTracking;
+    copy->fullFrameInterval = proc->fullFrameInterval;
+    copy->entryBand = proc->entryBand;
+    memcpy(copy->thresholds, proc->thresholds, sizeof(proc->thresholds));
+    copy->calibration.pxPerMm = proc->calibration.pxPerMm;
+    copy->scheduler = proc->scheduler;
+    if (proc->motion && !setMotionGate(copy, proc->motion->threshold, proc->motion->maxSkip))
+        return freeFrameProcessor(copy);
+    if (proc->background && !setBackgroundModel(copy, proc->background->learningRate, proc->background->threshold))
+        return freeFrameProcessor(copy);
+    if (proc->tripwire && !setTripwire(copy, proc->tripwire->y, proc->tripwire->halfBand, proc->tripwire->debounce))
+        return freeFrameProcessor(copy);
+
+    CoinTracker *tracker = copy->tracker;
+    const CoinTracker *source = proc->tracker;
+    tracker->specs = source->specs;
+    tracker->params = source->params;
+    tracker->maxSpeed = source->maxSpeed;
+    tracker->nominalFps = source->nominalFps;
+    tracker->verbose = source->verbose;
+    setTrackerWindows(tracker, source->windowUnit, source->coinWindow, source->euroWindow,
+                      source->excludeWindow);
+
+    return copy;
+}
+
+/**
+ * @brief Binariza uma imagem RGB com o limiar configurado para a máscara
+ *
+ * No modo fixo usa rgb2binary() diretamente. Nos modos automáticos calcula
+ * a luminância em gray; com update != 0 o seletor de Otsu é atualizado
+ * (uma vez por frame), caso contrário usa o limiar em vigor. O modo local
+ * calcula a integral nas tabelas da integral dada (de frame completo),
+ * através de uma vista com as dimensões de source quando esta é um nível
+ * da pirâmide ou uma região, sem alocar memória, e usa uma janela escalada
+ * para o nível da pirâmide (level) a que source pertence.
+ */
+static void binarizeImage(FrameProcessor *proc, ThresholdSelector *sel, IntegralImage *integral,
+                          IVC *source, IVC *gray, IVC *binary, int level, int update) {
+    if (sel->mode == VC_THRESH_FIXED) {
+        rgb2binary(source, binary, sel->value);
         return;
+    }
 
-    // Obtém dimensões do frame
-    const int width = frame->width;
-    const int height = frame->height;
-    const int channels = frame->channels;
-    const int size = width * height * channels;
-    
-    // Aloca buffers para imagens temporárias
-    IVC *rgbImage = createImage(width, height, channels, 255);
-    IVC *hsvImage = createImage(width, height, channels, 255);
-    IVC *hsvImage2 = createImage(width, height, channels, 255);
-    IVC *hsvImage3 = createImage(width, height, channels, 255);
-    
-    IVC *grayImage = createImage(width, height, 1, 255);
-    IVC *grayImage2 = createImage(width, height, 1, 255);
-    IVC *grayImage3 = createImage(width, height, 1, 255);
-    IVC *grayImage4 = createImage(width, height, 1, 255);
-    
-    IVC *binaryImage = createImage(width, height, 1, 255);
-    IVC *binaryImage2 = createImage(width, height, 1, 255);
-    IVC *binaryImage3 = createImage(width, height, 1, 255);
-    IVC *binaryImage4 = createImage(width, height, 1, 255);
-    
-    // Verifica falhas na alocação
-    if (!rgbImage || !hsvImage || !hsvImage2 || !hsvImage3 ||
-        !grayImage || !grayImage2 || !grayImage3 || !grayImage4 ||
-        !binaryImage || !binaryImage2 || !binaryImage3 || !binaryImage4) {
-        
-        // Liberta imagens alocadas
-        if (rgbImage) freeImage(rgbImage);
-        if (hsvImage) freeImage(hsvImage);
-        if (hsvImage2) freeImage(hsvImage2);
-        if (hsvImage3) freeImage(hsvImage3);
-        if (grayImage) freeImage(grayImage);
-        if (grayImage2) freeImage(grayImage2);
-        if (grayImage3) freeImage(grayImage3);
-        if (grayImage4) freeImage(grayImage4);
-        if (binaryImage) freeImage(binaryImage);
-        if (binaryImage2) freeImage(binaryImage2);
-        if (binaryImage3) freeImage(binaryImage3);
-        if (binaryImage4) freeImage(binaryImage4);
-        
+    rgb2gray(source, gray);
+
+    if (sel->mode == VC_THRESH_OTSU) {
+        if (update) updateThreshold(sel, gray);
+        gray2binary(gray, binary, sel->value);
         return;
     }
 
-    // Converte BGR para RGB de forma eficiente
-    bgr2rgb(frame, rgbImage);
-    
-    // Processa moedas douradas (10c, 20c, 50c)
-    memcpy(hsvImage->data, rgbImage->data, size);
-    rgb2hsv(hsvImage, 0);  
-    rgb2gray(hsvImage, grayImage2);
-    gray2binary(grayImage2, binaryImage2, 110);
-    binaryOpen(binaryImage2, grayImage2, 7);
-
-    // Processa moedas de cobre (1c, 2c, 5c)
-    bgr2rgb(frame2, rgbImage);
-    memcpy(hsvImage2->data, rgbImage->data, size);
-    rgb2hsv(hsvImage2, 1);
-    rgb2gray(hsvImage2, grayImage3);
-    gray2binary(grayImage3, binaryImage3, 80);
-    binaryOpen(binaryImage3, grayImage3, 3);
-
-    // Processa moedas de Euro (1€, 2€)
-    bgr2rgb(frame, rgbImage);
-    memcpy(hsvImage3->data, rgbImage->data, size);
-    rgb2hsv(hsvImage3, 2);
-    rgb2gray(hsvImage3, grayImage4);
-    gray2binary(grayImage4, binaryImage4, 90);
-    binaryOpen(binaryImage4, grayImage4, 3);
-    
-    // Extrai imagem em níveis de cinzento para deteção geral de blobs
-    rgb2gray(rgbImage, grayImage);
-    gray2binary(grayImage, binaryImage, 150);
-    binaryOpen(binaryImage, binaryImage, 3);
-    binaryClose(binaryImage, binaryImage, 5);
+    // VC_THRESH_LOCAL (raio definido à resolução total e escalado para o nível)
+    const int baseRadius = (sel->localRadius > 0) ? sel->localRadius : VC_MAX(proc->width, proc->height) / 8;
+    const int radius = VC_MAX(1, baseRadius >> level);
+    IntegralImage view;
 
-    // Deteção de blobs
-    int nlabels = 0, nlabels2 = 0, nlabels3 = 0, nlabels4 = 0;
-    OVC *blobs = NULL, *blobs2 = NULL, *blobs3 = NULL, *blobs4 = NULL;
-    
-    // Só prossegue se conseguir extrair os blobs principais
-    blobs = blobLabel(binaryImage, binaryImage, &nlabels);
-    if (blobs && nlabels > 0) {
-        blobInfo(binaryImage, blobs, nlabels);
-        
-        // Processa blobs de moedas douradas
-        blobs2 = blobLabel(grayImage2, grayImage2, &nlabels2);
-        if (blobs2 && nlabels2 > 0) {
-            blobInfo(grayImage2, blobs2, nlabels2);
+    if (integralView(integral, gray->width, gray->height, &view)) {
+        computeIntegral(gray, &view);
+        adaptiveThreshold(gray, binary, &view, radius, sel->localOffset);
+    }
+}
+
+// Conversão para HSV de uma faixa de linhas (parallelRows)
+typedef struct {
+    const IVC *rgb;
+    IVC *hsv;
+    int segmentType;
+} HsvRows;
+
+static void hsvRows(void *arg, int y0, int y1) {
+    const HsvRows *job = (const HsvRows *)arg;
+    IVC rows = *job->hsv;
+
+    rows.data += y0 * rows.bytesperline;
+    rows.height = y1 - y0;
+    memcpy(rows.data, job->rgb->data + y0 * job->rgb->bytesperline, rows.bytesperline * rows.height);
+    rgb2hsv(&rows, job->segmentType);
+}
+
+// Erosão ou dilatação de uma faixa de linhas (parallelRows)
+typedef struct {
+    IVC *src, *dst;
+    int kernel;
+} MorphologyRows;
+
+static void erodeRows(void *arg, int y0, int y1) {
+    const MorphologyRows *job = (const MorphologyRows *)arg;
+    binaryErode(job->src, job->dst, job->kernel, y0, y1);
+}
+
+static void dilateRows(void *arg, int y0, int y1) {
+    const MorphologyRows *job = (const MorphologyRows *)arg;
+    binaryDilate(job->src, job->dst, job->kernel, y0, y1);
+}
+
+/**
+ * @brief Segmenta e limpa uma máscara de uma imagem RGB, sem a etiquetar
+ *
+ * Aplica a segmentação HSV (se existir), o limiar da máscara e a abertura
+ * e o fecho morfológicos com o seletor sel e a integral dados. O resultado
+ * (0/255) fica em out. A conversão HSV e cada passo da morfologia são
+ * divididos em faixas de linhas no escalonador do processador (se
+ * existir); gray e binary, já livres depois do limiar, guardam os
+ * resultados intermédios da morfologia.
+ */
+static void cleanMask(FrameProcessor *proc, IVC *rgb, int mask, ThresholdSelector *sel, IntegralImage *integral,
+                      IVC *hsv, IVC *gray, IVC *binary, IVC *out, int openKernel, int closeKernel,
+                      int level, int update) {
+    const MaskParams *mp = &MASK_PARAMS[mask];
+    IVC *source = rgb;
+
+    if (mp->segmentType >= 0) {
+        HsvRows job = { rgb, hsv, mp->segmentType };
+        parallelRows(proc->scheduler, rgb->height, VC_SCHED_MIN_ROWS, hsvRows, &job);
+        source = hsv;
+    }
+
+    binarizeImage(proc, sel, integral, source, gray, binary, level, update);
+
+    // Abertura: erosão para gray e dilatação para out
+    MorphologyRows open = { binary, gray, openKernel };
+    parallelRows(proc->scheduler, out->height, VC_SCHED_MIN_ROWS, erodeRows, &open);
+    open.src = gray;
+    open.dst = out;
+    parallelRows(proc->scheduler, out->height, VC_SCHED_MIN_ROWS, dilateRows, &open);
+
+    // Fecho: dilatação para binary e erosão de volta para out
+    if (closeKernel > 0) {
+        MorphologyRows close = { out, binary, closeKernel };
+        parallelRows(proc->scheduler, out->height, VC_SCHED_MIN_ROWS, dilateRows, &close);
+        close.src = binary;
+        close.dst = out;
+        parallelRows(proc->scheduler, out->height, VC_SCHED_MIN_ROWS, erodeRows, &close);
+    }
+}
+
+/**
+ * @brief Etiqueta uma máscara limpa no local e extrai as propriedades dos blobs
+ * @return Array de blobs (a libertar com free) ou NULL se não houver blobs
+ */
+static OVC *labelMask(IVC *labels, int *nblobs) {
+    OVC *blobs;
+
+    *nblobs = 0;
+    blobs = blobLabel(labels, labels, nblobs);
+    if (blobs && *nblobs > 0) {
+        blobInfo(labels, blobs, *nblobs);
+    }
+    else {
+        if (blobs) free(blobs);
+        blobs = NULL;
+        *nblobs = 0;
+    }
+
+    return blobs;
+}
+
+/**
+ * @brief Segmenta, limpa e etiqueta uma máscara de uma imagem RGB
+ *
+ * Aplica a segmentação HSV (se existir), o limiar da máscara, a abertura
+ * e o fecho morfológicos, e extrai os blobs com as suas propriedades. As
+ * imagens de trabalho têm de ter as mesmas dimensões que rgb.
+ *
+ * @param proc Estado de processamento (limiares da máscara)
+ * @param rgb Imagem RGB de origem (não é alterada)
+ * @param mask Máscara a segmentar (VC_MASK_*)
+ * @param hsv Imagem de trabalho RGB
+ * @param gray Imagem de trabalho de 1 canal (limiares automáticos)
+ * @param binary Imagem de trabalho binária
+ * @param labels Imagem onde fica a máscara etiquetada
+ * @param openKernel Kernel da abertura
+ * @param closeKernel Kernel do fecho (0 = sem fecho)
+ * @param level Nível da pirâmide de rgb (0 = resolução total)
+ * @param update Se o limiar automático pode ser atualizado nesta chamada
+ * @param nblobs Ponteiro para o número de blobs encontrados
+ * @return Array de blobs (a libertar com free) ou NULL se não houver blobs
+ */
+static OVC *segmentImage(FrameProcessor *proc, IVC *rgb, int mask, IVC *hsv, IVC *gray, IVC *binary,
+                         IVC *labels, int openKernel, int closeKernel, int level, int update, int *nblobs) {
+    cleanMask(proc, rgb, mask, &proc->thresholds[mask], proc->integral, hsv, gray, binary, labels,
+              openKernel, closeKernel, level, update);
+    return labelMask(labels, nblobs);
+}
+
+/**
+ * @brief Refina um blob grosseiro à resolução total dentro da sua ROI
+ *
+ * Recorta de rgb a caixa do blob (escalada para a resolução total e com uma
+ * margem), segmenta e etiqueta só essa região e escolhe o blob mais próximo
+ * do centróide grosseiro. As coordenadas do resultado são as do frame.
+ *
+ * @return 1 se o blob foi refinado, 0 caso contrário
+ */
+static int refineBlob(FrameProcessor *proc, IVC *rgb, int mask, const OVC *coarse, int level, OVC *refined) {
+    const PipelineParams *params = &proc->tracker->params;
+    const int scale = 1 << level;
+    const int margin = 2 * scale + VC_MAX(params->openKernel[mask], params->closeKernel[mask]);
+    const int x0 = VC_MAX(0, coarse->x * scale - margin);
+    const int y0 = VC_MAX(0, coarse->y * scale - margin);
+    const int x1 = VC_MIN(rgb->width, (coarse->x + coarse->width) * scale + margin);
+    const int y1 = VC_MIN(rgb->height, (coarse->y + coarse->height) * scale + margin);
+    const int cx = coarse->xc * scale + scale / 2 - x0;
+    const int cy = coarse->yc * scale + scale / 2 - y0;
+    int nblobs = 0, best = -1, bestDistSq = 0, i, ok = 0;
+
+    if (x1 - x0 < 3 || y1 - y0 < 3) return 0;
+
+    // Vistas do tamanho da ROI sobre os buffers do processador (os blobs
+    // grosseiros já foram extraídos, por isso os buffers estão livres)
+    IVC roi = *proc->roiImage, hsv = *proc->hsvImage, gray = *proc->grayImage;
+    IVC binary = *proc->binaryImage, labels = *proc->labelImage;
+    roi.width = hsv.width = gray.width = binary.width = labels.width = x1 - x0;
+    roi.height = hsv.height = gray.height = binary.height = labels.height = y1 - y0;
+    roi.bytesperline = hsv.bytesperline = (x1 - x0) * 3;
+    gray.bytesperline = binary.bytesperline = labels.bytesperline = x1 - x0;
+
+    if (extractRegion(rgb, &roi, x0, y0)) {
+        // O limiar automático já foi atualizado no nível grosseiro deste frame
+        OVC *blobs = segmentImage(proc, &roi, mask, &hsv, &gray, &binary, &labels,
+                                  params->openKernel[mask], params->closeKernel[mask], 0, 0, &nblobs);
+
+        for (i = 0; i < nblobs; i++) {
+            const int distSq = distanceSquared(blobs[i].xc, blobs[i].yc, cx, cy);
+            if (blobs[i].area > 0 && (best < 0 || distSq < bestDistSq)) {
+                best = i;
+                bestDistSq = distSq;
+            }
         }
-        
-        // Processa blobs de moedas de cobre
-        blobs3 = blobLabel(grayImage3, grayImage3, &nlabels3);
-        if (blobs3 && nlabels3 > 0) {
-            blobInfo(grayImage3, blobs3, nlabels3);
+
+        if (best >= 0) {
+            *refined = blobs[best];
+            refined->x += x0;
+            refined->y += y0;
+            refined->xc += x0;
+            refined->yc += y0;
+            ok = 1;
         }
-        
-        // Processa blobs de moedas de Euro
-        blobs4 = blobLabel(grayImage4, grayImage4, &nlabels4);
-        if (blobs4 && nlabels4 > 0) {
-            blobInfo(grayImage4, blobs4, nlabels4);
+
+        if (blobs) free(blobs);
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Deteta os blobs de uma máscara no modo grosseiro
+ *
+ * Segmenta e etiqueta o nível proc->coarseLevel da pirâmide e refina à
+ * resolução total apenas as ROIs dos blobs grosseiros com área suficiente.
+ * O custo passa a depender do número de moedas e não do número de pixels.
+ */
+static OVC *segmentMaskCoarse(FrameProcessor *proc, ImagePyramid *pyramid, int mask, int *nblobs) {
+    const PipelineParams *params = &proc->tracker->params;
+    const int level = VC_MIN(proc->coarseLevel, pyramid->nlevels - 1);
+    const int scale = 1 << level;
+    IVC *small = pyramid->levels[level];
+    int ncoarse = 0, i;
+
+    *nblobs = 0;
+
+    // Imagens de trabalho do tamanho do nível grosseiro (vistas sobre os buffers do processador)
+    IVC hsv = *proc->hsvImage, gray = *proc->grayImage, binary = *proc->binaryImage, labels = *proc->labelImage;
+    hsv.width = gray.width = binary.width = labels.width = small->width;
+    hsv.height = gray.height = binary.height = labels.height = small->height;
+    hsv.bytesperline = small->width * 3;
+    gray.bytesperline = binary.bytesperline = labels.bytesperline = small->width;
+
+    // Kernels escalados para o nível grosseiro
+    const int openKernel = VC_MAX(1, (params->openKernel[mask] + scale / 2) / scale);
+    const int closeKernel = (params->closeKernel[mask] > 0) ? VC_MAX(1, (params->closeKernel[mask] + scale / 2) / scale) : 0;
+
+    OVC *coarse = segmentImage(proc, small, mask, &hsv, &gray, &binary, &labels,
+                               openKernel, closeKernel, level, 1, &ncoarse);
+    if (coarse == NULL) return NULL;
+
+    OVC *blobs = (OVC *)calloc(ncoarse, sizeof(OVC));
+    if (blobs != NULL) {
+        for (i = 0; i < ncoarse; i++) {
+            if (coarse[i].area * scale * scale < params->coarseMinArea)
+                continue;
+
+            if (refineBlob(proc, pyramid->levels[0], mask, &coarse[i], level, &blobs[*nblobs])) {
+                blobs[*nblobs].label = *nblobs + 1;
+                (*nblobs)++;
+            }
+        }
+
+        if (*nblobs == 0) {
+            free(blobs);
+            blobs = NULL;
+        }
+    }
+
+    free(coarse);
+    return blobs;
+}
+
+/**
+ * @brief Prepara as ROIs de um frame sem passagem completa
+ *
+ * Junta as ROIs das moedas seguidas (à volta da posição prevista) e a
+ * faixa de entrada, recortadas aos limites do frame. Com o modelo de fundo
+ * as ROIs são as regiões alteradas do frame e com a linha de contagem só a
+ * banda à volta da linha.
+ */
+static void collectRegions(FrameProcessor *proc) {
+    CoinTracker *tracker = proc->tracker;
+    const BackgroundModel *bg = proc->background;
+    const int needed = proc->tripwire ? 1 : bg ? VC_MAX(bg->nRegions, 1) : tracker->nAliveCoins + 1;
+    int n, i, kept = 0;
+
+    proc->nRegions = 0;
+
+    if (needed > proc->regionCapacity) {
+        const int capacity = VC_MAX(needed, 2 * proc->regionCapacity);
+        ImageRegion *regions = (ImageRegion *)realloc(proc->regions, capacity * sizeof(ImageRegion));
+        if (regions == NULL) return;
+        proc->regions = regions;
+        proc->regionCapacity = capacity;
+    }
+
+    if (proc->tripwire != NULL) {
+        proc->regions[0] = tripwireBand(proc->tripwire, &tracker->specs);
+        n = 1;
+    }
+    else if (bg != NULL) {
+        n = bg->nRegions;
+        memcpy(proc->regions, bg->regions, n * sizeof(ImageRegion));
+    }
+    else {
+        n = trackedRegions(tracker, tracker->params.roiMargin, proc->regions, proc->regionCapacity - 1);
+        if (proc->entryBand.width > 0 && proc->entryBand.height > 0)
+            proc->regions[n++] = proc->entryBand;
+    }
+
+    for (i = 0; i < n; i++) {
+        ImageRegion r = proc->regions[i];
+        const int x1 = VC_MIN(r.x + r.width, proc->width);
+        const int y1 = VC_MIN(r.y + r.height, proc->height);
+        r.x = VC_MAX(r.x, 0);
+        r.y = VC_MAX(r.y, 0);
+        r.width = x1 - r.x;
+        r.height = y1 - r.y;
+
+        if (r.width >= 3 && r.height >= 3)
+            proc->regions[kept++] = r;
+    }
+
+    proc->nRegions = kept;
+}
+
+/**
+ * @brief Deteta os blobs de uma máscara apenas nas ROIs do frame atual
+ *
+ * Cada ROI é recortada do frame BGR de origem, convertida para RGB e
+ * segmentada e etiquetada à resolução total com o limiar em vigor (os
+ * limiares automáticos só são atualizados nas passagens completas). Os
+ * blobs cortados pelos lados da ROI são descartados, porque a sua área e
+ * diâmetro não são os da moeda, exceto os da máscara principal cortados
+ * pela banda da linha de contagem, que ainda dão a posição da moeda (ver
+ * tripwireCut()). As coordenadas dos blobs devolvidos são as do frame.
+ */
+static OVC *segmentMaskRegions(FrameProcessor *proc, IVC *source, int mask, int *nblobs) {
+    const PipelineParams *params = &proc->tracker->params;
+    const int keepCut = proc->tripwire != NULL && mask == VC_MASK_MAIN;
+    OVC *blobs = NULL;
+    int capacity = 0, n, i, k;
+
+    *nblobs = 0;
+
+    for (i = 0; i < proc->nRegions; i++) {
+        const ImageRegion *r = &proc->regions[i];
+
+        // Vistas do tamanho da ROI sobre os buffers do processador
+        IVC roi = *proc->roiImage, hsv = *proc->hsvImage, gray = *proc->grayImage;
+        IVC binary = *proc->binaryImage, labels = *proc->labelImage;
+        roi.width = hsv.width = gray.width = binary.width = labels.width = r->width;
+        roi.height = hsv.height = gray.height = binary.height = labels.height = r->height;
+        roi.bytesperline = hsv.bytesperline = r->width * 3;
+        gray.bytesperline = binary.bytesperline = labels.bytesperline = r->width;
+
+        // hsv serve de recorte BGR antes de ser usado pela segmentação
+        if (!extractRegion(source, &hsv, r->x, r->y) || !bgr2rgb(&hsv, &roi))
+            continue;
+
+        OVC *found = segmentImage(proc, &roi, mask, &hsv, &gray, &binary, &labels,
+                                  params->openKernel[mask], params->closeKernel[mask], 0, 0, &n);
+        if (found == NULL) continue;
+
+        if (*nblobs + n > capacity) {
+            const int grown = VC_MAX(*nblobs + n, 2 * capacity);
+            OVC *all = (OVC *)realloc(blobs, grown * sizeof(OVC));
+            if (all == NULL) {
+                free(found);
+                continue;
+            }
+            blobs = all;
+            capacity = grown;
         }
+
+        for (k = 0; k < n; k++) {
+            // Blobs cortados por um lado da ROI que não é borda do frame estão incompletos
+            if ((found[k].x <= 1 && r->x > 0) ||
+                (found[k].x + found[k].width >= r->width - 1 && r->x + r->width < proc->width))
+                continue;
+            if (!keepCut && ((found[k].y <= 1 && r->y > 0) ||
+                             (found[k].y + found[k].height >= r->height - 1 && r->y + r->height < proc->height)))
+                continue;
+
+            OVC *b = &blobs[*nblobs];
+            *b = found[k];
+            b->x += r->x;
+            b->y += r->y;
+            b->xc += r->x;
+            b->yc += r->y;
+            b->label = ++(*nblobs);
+        }
+
+        free(found);
+    }
+
+    if (*nblobs == 0 && blobs != NULL) {
+        free(blobs);
+        blobs = NULL;
+    }
+
+    return blobs;
+}
+
+/**
+ * @brief Deteta os blobs de uma das máscaras (VC_MASK_*) do frame atual
+ *
+ * Fora das passagens completas (fullPass == 0) só processa as ROIs
+ * preparadas por collectRegions(), a partir dos frames BGR de origem.
+ */
+static OVC *segmentMask(FrameProcessor *proc, IVC *frame, IVC *frame2, int mask, int fullPass, int *nblobs) {
+    const MaskParams *mp = &MASK_PARAMS[mask];
+    const PipelineParams *params = &proc->tracker->params;
+
+    if (!fullPass) {
+        return segmentMaskRegions(proc, mp->useFrame2 ? frame2 : frame, mask, nblobs);
+    }
+
+    if (proc->detectMode == VC_DETECT_COARSE) {
+        return segmentMaskCoarse(proc, mp->useFrame2 ? proc->pyramid2 : proc->pyramid, mask, nblobs);
+    }
+
+    return segmentImage(proc, mp->useFrame2 ? proc->rgbImage2 : proc->rgbImage, mask,
+                        proc->hsvImage, proc->grayImage, proc->binaryImage, proc->labelImage,
+                        params->openKernel[mask], params->closeKernel[mask], 0, 1, nblobs);
+}
+
+// Guarda uma amostra de calibração (ignorada quando o limite é atingido)
+static void addCalibrationSample(ScaleCalibration *cal, int colorClass, float diameter) {
+    if (cal->nSamples == cal->capacity) {
+        if (cal->capacity >= VC_CALIBRATION_MAX_SAMPLES) return;
+
+        const int capacity = VC_MIN(VC_MAX(64, 2 * cal->capacity), VC_CALIBRATION_MAX_SAMPLES);
+        float *diameters = (float *)realloc(cal->diameters, capacity * sizeof(float));
+        if (diameters == NULL) return;
+        cal->diameters = diameters;
+
+        int *classes = (int *)realloc(cal->classes, capacity * sizeof(int));
+        if (classes == NULL) return;
+        cal->classes = classes;
+
+        cal->capacity = capacity;
+    }
+
+    cal->diameters[cal->nSamples] = diameter;
+    cal->classes[cal->nSamples] = colorClass;
+    cal->nSamples++;
+}
+
+/**
+ * @brief Recolhe os diâmetros de calibração de uma máscara de cor
+ *
+ * Só servem blobs circulares da classe, com o centro dentro de um blob
+ * principal, inteiramente dentro do frame e com pelo menos 1/16 do lado
+ * menor do frame. Nenhum destes critérios depende da escala.
+ */
+static void sampleCalibration(FrameProcessor *proc, const OVC *blobs, int nblobs,
+                              OVC *classBlobs, int nclassBlobs, int colorClass) {
+    const CoinSpecTable *specs = &proc->tracker->specs;
+    const float minDiameter = VC_MIN(proc->width, proc->height) / 16.0f;
+    int i, k;
+
+    if (classBlobs == NULL || specs->nOrder[colorClass] == 0) return;
+
+    for (i = 0; i < nclassBlobs; i++) {
+        OVC *b = &classBlobs[i];
+
+        if (b->x <= 1 || b->y <= 1 || b->x + b->width >= proc->width - 1 ||
+            b->y + b->height >= proc->height - 1)
+            continue;
+        if (getDiameter(b) < minDiameter || getCircularity(b) < specs->minCircularity[colorClass])
+            continue;
+
+        for (k = 0; k < nblobs; k++) {
+            if (b->xc >= blobs[k].x && b->xc < blobs[k].x + blobs[k].width &&
+                b->yc >= blobs[k].y && b->yc < blobs[k].y + blobs[k].height)
+                break;
+        }
+
+        if (k < nblobs)
+            addCalibrationSample(&proc->calibration, colorClass, getDiameter(b));
+    }
+}
+
+// Amostras de calibração das três máscaras de cor de um frame
+static void sampleFrame(FrameProcessor *proc, OVC **blobs, const int *nblobs) {
+    if (blobs[VC_MASK_MAIN] == NULL) return;
+
+    sampleCalibration(proc, blobs[VC_MASK_MAIN], nblobs[VC_MASK_MAIN],
+                      blobs[VC_MASK_GOLD], nblobs[VC_MASK_GOLD], VC_MASK_GOLD);
+    sampleCalibration(proc, blobs[VC_MASK_MAIN], nblobs[VC_MASK_MAIN],
+                      blobs[VC_MASK_COPPER], nblobs[VC_MASK_COPPER], VC_MASK_COPPER);
+    sampleCalibration(proc, blobs[VC_MASK_MAIN], nblobs[VC_MASK_MAIN],
+                      blobs[VC_MASK_EURO], nblobs[VC_MASK_EURO], VC_MASK_EURO);
+}
+
+/**
+ * @brief Segmenta as quatro máscaras de um frame
+ *
+ * Nas passagens completas converte os frames para RGB (e constrói as
+ * pirâmides no modo grosseiro); nas restantes prepara as ROIs. As máscaras
+ * de cor só são segmentadas se a máscara principal tiver blobs.
+ */
+static void segmentFrame(FrameProcessor *proc, IVC *frame, IVC *frame2, int fullPass,
+                         OVC **blobs, int *nblobs) {
+    int m;
+
+    for (m = 0; m < VC_NUM_MASKS; m++) {
+        blobs[m] = NULL;
+        nblobs[m] = 0;
+    }
+
+    if (fullPass) {
+        // Converte BGR para RGB (frame2 só é usado pelas moedas de cobre)
+        bgr2rgb(frame, proc->rgbImage);
+        bgr2rgb(frame2, proc->rgbImage2);
+
+        if (proc->detectMode == VC_DETECT_COARSE) {
+            buildPyramid(proc->rgbImage, proc->pyramid);
+            buildPyramid(proc->rgbImage2, proc->pyramid2);
+        }
+    }
+    else {
+        collectRegions(proc);
+    }
+
+    blobs[VC_MASK_MAIN] = segmentMask(proc, frame, frame2, VC_MASK_MAIN, fullPass, &nblobs[VC_MASK_MAIN]);
+    if (blobs[VC_MASK_MAIN] == NULL) return;
+
+    for (m = 0; m < VC_NUM_MASKS; m++) {
+        if (m != VC_MASK_MAIN)
+            blobs[m] = segmentMask(proc, frame, frame2, m, fullPass, &nblobs[m]);
+    }
+}
+
+static void freeFrameBlobs(OVC **blobs) {
+    for (int m = 0; m < VC_NUM_MASKS; m++) {
+        if (blobs[m]) free(blobs[m]);
+        blobs[m] = NULL;
+    }
+}
+
+/**
+ * @brief Inicia a calibração automática da escala nos próximos frames
+ *
+ * As amostras de uma calibração anterior por terminar são descartadas.
+ */
+void startCalibration(FrameProcessor *proc, int frames) {
+    if (proc == NULL) return;
+
+    proc->calibration.nSamples = 0;
+    proc->calibration.framesDone = 0;
+    proc->calibration.frames = VC_MAX(frames, 0);
+}
+
+/**
+ * @brief Liga, ajusta ou desliga o salto dos frames sem movimento
+ *
+ * O detetor é criado na primeira chamada com threshold > 0; as chamadas
+ * seguintes só mudam os parâmetros e mantêm a referência e as estatísticas.
+ */
+int setMotionGate(FrameProcessor *proc, float threshold, int maxSkip) {
+    if (proc == NULL) return 0;
+
+    if (threshold <= 0.0f) {
+        proc->motion = freeMotionGate(proc->motion);
+        return 1;
+    }
+
+    if (proc->motion == NULL) {
+        proc->motion = createMotionGate(proc->width, proc->height, 3);
+        if (proc->motion == NULL) return 0;
+    }
+
+    proc->motion->threshold = threshold;
+    proc->motion->maxSkip = VC_MAX(maxSkip, 0);
+
+    return 1;
+}
+
+/**
+ * @brief Liga, ajusta ou desliga a segmentação restrita às regiões alteradas
+ *
+ * O modelo é criado na primeira chamada com learningRate > 0 e as chamadas
+ * seguintes só mudam os parâmetros (a média aprendida mantém-se). A taxa
+ * do primeiro plano é um décimo da do fundo.
+ */
+int setBackgroundModel(FrameProcessor *proc, float learningRate, int threshold) {
+    if (proc == NULL) return 0;
+
+    if (learningRate <= 0.0f) {
+        proc->background = freeBackgroundModel(proc->background);
+        return 1;
+    }
+
+    if (proc->background == NULL) {
+        proc->background = createBackgroundModel(proc->width, proc->height, 3);
+        if (proc->background == NULL) return 0;
+    }
+
+    proc->background->learningRate = VC_MIN(learningRate, 1.0f);
+    proc->background->foregroundRate = proc->background->learningRate / 10.0f;
+    proc->background->threshold = VC_MAX(threshold, 1);
+
+    return 1;
+}
+
+/**
+ * @brief Liga, ajusta ou desliga a contagem por passagem numa linha
+ *
+ * A linha é criada na primeira chamada com y >= 0; as chamadas seguintes
+ * mudam a linha e os parâmetros e mantêm as moedas das pistas.
+ */
+int setTripwire(FrameProcessor *proc, int y, int halfBand, int debounce) {
+    if (proc == NULL) return 0;
+
+    if (y < 0) {
+        proc->tripwire = freeTripwire(proc->tripwire);
+        return 1;
+    }
+    if (y >= proc->height) return 0;
+
+    if (proc->tripwire == NULL) {
+        proc->tripwire = createTripwire(proc->width, proc->height, y);
+        if (proc->tripwire == NULL) return 0;
+    }
+
+    proc->tripwire->y = y;
+    proc->tripwire->halfBand = VC_MAX(halfBand, 0);
+    proc->tripwire->debounce = VC_MAX(debounce, 0);
+
+    return 1;
+}
+
+/**
+ * @brief Ajusta a escala às amostras recolhidas e reescala as denominações
+ *
+ * Usa fitPixelScale() com a tabela do rastreador; se a escala for aceite,
+ * os diâmetros e margens de borda passam a corresponder a ela. A calibração
+ * termina em qualquer dos casos e as amostras são descartadas.
+ */
+float finishCalibration(FrameProcessor *proc) {
+    ScaleCalibration *cal;
+    float scale;
+
+    if (proc == NULL) return 0.0f;
+    cal = &proc->calibration;
+
+    scale = fitPixelScale(&proc->tracker->specs, cal->diameters, cal->classes, cal->nSamples);
+    if (scale > 0.0f) {
+        scaleCoinSpecs(&proc->tracker->specs, scale);
+        updatePipelineParams(proc->tracker);
+        cal->pxPerMm = scale;
+        printf("[CALIBRAÇÃO] %.3f px/mm (%d amostras)\n", scale, cal->nSamples);
+    }
+    else {
+        printf("[CALIBRAÇÃO] Sem amostras suficientes (%d), escala inalterada\n", cal->nSamples);
+    }
+
+    cal->nSamples = 0;
+    cal->frames = 0;
+    cal->framesDone = 0;
+
+    return scale;
+}
+
+/**
+ * @brief Calibra a escala a partir de uma imagem de referência
+ *
+ * A imagem tem de vir da mesma câmara e resolução dos frames (BGR, como os
+ * frames do vídeo) e deve mostrar moedas de várias denominações.
+ */
+float calibrateFromImage(FrameProcessor *proc, IVC *image) {
+    if (proc == NULL || image == NULL || image->channels != 3 ||
+        image->width != proc->width || image->height != proc->height)
+        return 0.0f;
+
+    OVC *blobs[VC_NUM_MASKS];
+    int nblobs[VC_NUM_MASKS];
+
+    proc->calibration.nSamples = 0;
+    segmentFrame(proc, image, image, 1, blobs, nblobs);
+    sampleFrame(proc, blobs, nblobs);
+    freeFrameBlobs(blobs);
+
+    return finishCalibration(proc);
+}
+
+/**
+ * @brief Classifica e contabiliza os blobs segmentados de um frame
+ *
+ * Enquanto houver uma calibração em curso só recolhe amostras (e termina a
+ * calibração no último frame); caso contrário associa os blobs principais
+ * às máscaras de cor, atualiza o rastreador e desenha o resultado em frame.
+ * Com a linha de contagem todos os blobs são classificados (não há moedas
+ * seguidas nem pontos de exclusão a consultar) e as deteções vão para
+ * crossTripwire() em vez de commitDetections(); quando só a banda foi
+ * segmentada (fullPass == 0), os blobs cortados pela banda só dão a posição
+ * da moeda.
+ */
+static void analyseBlobs(FrameProcessor *proc, IVC *frame, OVC **blobs, const int *nblobs, int *coinCounts,
+                         int fullPass) {
+    CoinTracker *tracker = proc->tracker;
+    ScaleCalibration *cal = &proc->calibration;
+    Tripwire *trip = proc->tripwire;
+
+    // Calibração da escala: amostra o frame e, no último, reescala a tabela
+    if (cal->frames > 0) {
+        sampleFrame(proc, blobs, nblobs);
+        if (++cal->framesDone >= cal->frames)
+            finishCalibration(proc);
+        return;
+    }
+
+    OVC *blobs2 = blobs[VC_MASK_GOLD], *blobs3 = blobs[VC_MASK_COPPER], *blobs4 = blobs[VC_MASK_EURO];
+    const int nlabels2 = nblobs[VC_MASK_GOLD], nlabels3 = nblobs[VC_MASK_COPPER], nlabels4 = nblobs[VC_MASK_EURO];
+
+    // Só prossegue se houver blobs principais
+    if (blobs[VC_MASK_MAIN] && nblobs[VC_MASK_MAIN] > 0) {
+        OVC *mainBlobs = blobs[VC_MASK_MAIN];
+        const int nlabels = nblobs[VC_MASK_MAIN];
+
+        // Limites à escala da sequência (ver PipelineParams)
+        const PipelineParams *params = &tracker->params;
+        const int DISTANCE_THRESHOLD_SQ = params->matchDistanceSq;
         
         // Processa os objetos detetados - versão simplificada
         for (int i = 0; i < nlabels; i++) {
             // Ignora blobs pequenos
-            if (blobs[i].area < 9000 || blobs[i].area >= 30000 || blobs[i].width > 220) {
+            if (mainBlobs[i].area < params->minBlobArea || mainBlobs[i].area >= params->maxBlobArea ||
+                mainBlobs[i].width > params->maxBlobWidth) {
                 continue;
             }
             
-            // Constantes
-            const int DISTANCE_THRESHOLD_SQ = 30 * 30;
-            
-            // Verifica se este blob está na lista de exclusão
-            bool isExcluded = false;
-            for (int j = 0; j < MAX_COINS; j++) {
-                if (excludeList[j * 2] == 0 && excludeList[j * 2 + 1] == 0)
-                    continue;
-                    
-                int dx = excludeList[j * 2] - blobs[i].xc;
-                int dy = excludeList[j * 2 + 1] - blobs[i].yc;
-                int distance_squared = dx * dx + dy * dy;
-                
-                if (distance_squared <= DISTANCE_THRESHOLD_SQ) {
-                    isExcluded = true;
-                    break;
-                }
+            // Um blob cortado pela banda da linha só dá a posição (tipo 0, sem voto)
+            if (trip && !fullPass && tripwireCut(trip, &mainBlobs[i])) {
+                CoinDetection detection = { mainBlobs[i].xc, mainBlobs[i].yc, 0, getDiameter(&mainBlobs[i]),
+                                            getCircularity(&mainBlobs[i]), mainBlobs[i].area, NULL, 0.0f, -1,
+                                            getDiameter(&mainBlobs[i]) };
+                addDetection(tracker, &detection);
+                continue;
             }
-            
-            if (isExcluded)
+
+            // Verifica se este blob está na lista de exclusão
+            if (!trip && isExcludedCoin(tracker, mainBlobs[i].xc, mainBlobs[i].yc))
+                continue;
+
+            // Moedas com a denominação já estável só atualizam a posição
+            const int stableType = trip ? 0 : stableCoinType(tracker, mainBlobs[i].xc, mainBlobs[i].yc);
+            if (stableType > 0) {
+                CoinDetection detection = { mainBlobs[i].xc, mainBlobs[i].yc, stableType, getDiameter(&mainBlobs[i]),
+                                            getCircularity(&mainBlobs[i]), mainBlobs[i].area, NULL, 0.0f, -1,
+                                            getDiameter(&mainBlobs[i]) };
+                addDetection(tracker, &detection);
+                excludeCoin(tracker, mainBlobs[i].xc, mainBlobs[i].yc, 0);
                 continue;
+            }
                 
             // Tenta detetar moedas
             bool coinFound = false;
             
             // Tenta detetar moedas de Euro primeiro (têm prioridade)
             if (blobs4 && nlabels4 > 0) {
-                coinFound = detectEuroCoins(&blobs[i], blobs4, nlabels4, excludeList, coinCounts, DISTANCE_THRESHOLD_SQ);
+                coinFound = detectEuroCoins(tracker, &mainBlobs[i], blobs4, nlabels4, DISTANCE_THRESHOLD_SQ);
             }
             
             // Tenta detetar moedas douradas em segundo
             if (!coinFound && blobs2 && nlabels2 > 0) {
-                coinFound = detectGoldCoins(&blobs[i], blobs2, nlabels2, excludeList, coinCounts, DISTANCE_THRESHOLD_SQ);
+                coinFound = detectGoldCoins(tracker, &mainBlobs[i], blobs2, nlabels2, DISTANCE_THRESHOLD_SQ);
             }
             
             // Tenta detetar moedas de cobre por último
             if (!coinFound && blobs3 && nlabels3 > 0) {
-                coinFound = detectCopperCoins(&blobs[i], blobs3, nlabels3, excludeList, coinCounts, DISTANCE_THRESHOLD_SQ);
+                coinFound = detectCopperCoins(tracker, &mainBlobs[i], blobs3, nlabels3, DISTANCE_THRESHOLD_SQ);
             }
         }
         
+        // Associa as deteções do frame ao rastreador e contabiliza as moedas novas
+        // (ou as que passaram a linha de contagem)
+        if (trip) crossTripwire(trip, tracker, coinCounts);
+        else commitDetections(tracker, coinCounts);
+        
         // Desenha visualizações no frame
-        drawCoins(frame, blobs2, blobs3, blobs4, nlabels2, nlabels3, nlabels4);
+        drawCoins(tracker, frame, blobs2, blobs3, blobs4, nlabels2, nlabels3, nlabels4);
     }
+    if (trip) drawTripwire(trip, frame);
 
-    // Mostra resumo das contagens atuais a cada 30 frames
-    int currentFrame = getFrameCount();
-    if (currentFrame % 30 == 0) {
-        float total = coinCounts[0] * 0.01f + coinCounts[1] * 0.02f + 
-                     coinCounts[2] * 0.05f + coinCounts[3] * 0.10f + 
-                     coinCounts[4] * 0.20f + coinCounts[5] * 0.50f +
-                     coinCounts[6] * 1.00f + coinCounts[7] * 2.00f;
+    // Mostra resumo das contagens atuais a cada 30 frames (uma linha por classe de cor)
+    long long currentFrame = getFrameCount(tracker);
+    if (tracker->verbose && currentFrame % 30 == 0) {
+        static const int CLASS_ORDER[3] = { VC_MASK_COPPER, VC_MASK_GOLD, VC_MASK_EURO };
+        const CoinSpecTable *specs = &tracker->specs;
+        float total = 0.0f;
+        int totalCoins = 0;
         
-        printf("\n[RESUMO DE MOEDAS] Frame %d\n", currentFrame);
-        printf("1c: %d (%.2f€), 2c: %d (%.2f€), 5c: %d (%.2f€)\n", 
-               coinCounts[0], coinCounts[0] * 0.01f,
-               coinCounts[1], coinCounts[1] * 0.02f,
-               coinCounts[2], coinCounts[2] * 0.05f);
-        printf("10c: %d (%.2f€), 20c: %d (%.2f€), 50c: %d (%.2f€)\n", 
-               coinCounts[3], coinCounts[3] * 0.10f,
-               coinCounts[4], coinCounts[4] * 0.20f,
-               coinCounts[5], coinCounts[5] * 0.50f);
-        printf("1€: %d (%.2f€), 2€: %d (%.2f€)\n", 
-               coinCounts[6], coinCounts[6] * 1.00f,
-               coinCounts[7], coinCounts[7] * 2.00f);
-        printf("Total de moedas: %d | Valor total: %.2f EUR\n", 
-               coinCounts[0] + coinCounts[1] + coinCounts[2] + 
-               coinCounts[3] + coinCounts[4] + coinCounts[5] +
-               coinCounts[6] + coinCounts[7], total);
+        printf("\n[RESUMO DE MOEDAS] Frame %lld\n", currentFrame);
+        for (int c = 0; c < 3; c++) {
+            int printed = 0;
+            for (int i = 0; i < specs->nSpecs; i++) {
+                const CoinSpec *spec = &specs->specs[i];
+                if (spec->colorClass != CLASS_ORDER[c]) continue;
+                
+                printf("%s%s: %d (%.2f€)", printed ? ", " : "", spec->name,
+                       coinCounts[i], coinCounts[i] * spec->value);
+                total += coinCounts[i] * spec->value;
+                totalCoins += coinCounts[i];
+                printed++;
+            }
+            if (printed) printf("\n");
+        }
+        printf("Total de moedas: %d | Valor total: %.2f EUR\n", totalCoins, total);
+    }
+
+}
+
+/**
+ * @brief Processa um frame para detetar e classificar moedas
+ *
+ * Esta função implementa o fluxo completo de processamento para deteção de moedas
+ * num frame de vídeo. O processo inclui:
+ * - Conversão de espaços de cor (BGR para RGB, RGB para HSV)
+ * - Segmentação das imagens para diferentes tipos de moedas (douradas, cobre, euro)
+ * - Deteção e análise de blobs
+ * - Classificação das moedas detetadas
+ * - Visualização dos resultados no frame original
+ * - Contabilização das moedas por tipo e valor
+ *
+ * As imagens de trabalho pertencem ao processador e são reutilizadas entre
+ * frames. No modo VC_DETECT_COARSE a segmentação e a etiquetagem são feitas
+ * num nível reduzido da pirâmide e só as ROIs candidatas são refinadas à
+ * resolução total. Com proc->roiTracking o frame completo só é analisado
+ * de proc->fullFrameInterval em proc->fullFrameInterval frames; nos
+ * restantes apenas as ROIs em torno da posição prevista das moedas seguidas
+ * (contadas ou não) e a faixa de entrada (proc->entryBand) são segmentadas, pelo que
+ * moedas que entrem fora da faixa só são detetadas na passagem completa
+ * seguinte. Enquanto houver uma calibração em curso (startCalibration())
+ * os frames só são amostrados e nenhuma moeda é contada. Com o detetor de
+ * movimento ligado (setMotionGate()), um frame igual ao último processado
+ * é saltado depois de avançar o relógio do rastreador: a cena não mudou,
+ * pelo que as moedas seguidas ficam paradas onde foram vistas
+ * (holdTracks()), e os índices dos frames são os de uma execução completa.
+ * Com o modelo de fundo (setBackgroundModel()) só as regiões alteradas são
+ * segmentadas, como as ROIs de roiTracking.
+ * Com a linha de contagem (setTripwire()) só a banda à volta da linha é
+ * segmentada e as moedas são contadas quando a atravessam.
+ * 
+ * @param proc Estado de processamento (buffers, modo de deteção e rastreador)
+ * @param frame Frame principal para análise (entrada e saída para visualização)
+ * @param frame2 Frame secundário para análise complementar
+ * @param coinCounts Array com contadores para cada tipo de moeda
+ * @param timestampMs Tempo de captura do frame em ms (negativo = derivar do índice do frame)
+ */
+void processFrameAt(FrameProcessor *proc, IVC *frame, IVC *frame2, int *coinCounts, long long timestampMs) {
+    // Validação básica dos parâmetros
+    if (!proc || !frame || !frame2 || !coinCounts) 
+        return;
+
+    // Avança o relógio do rastreador (índice de 64 bits e tempo de captura)
+    CoinTracker *tracker = proc->tracker;
+    advanceClock(tracker, timestampMs);
+
+    if (frame->width != proc->width || frame->height != proc->height ||
+        frame2->width != proc->width || frame2->height != proc->height)
+        return;
+
+    // Sem movimento desde o último frame processado (nunca durante a calibração): as
+    // moedas ficam onde estavam em vez de seguirem a velocidade estimada
+    if (proc->motion && proc->calibration.frames <= 0 && !updateMotionGate(proc->motion, frame)) {
+        holdTracks(tracker);
+        return;
+    }
+
+    // Passagem completa ou só as ROIs previstas (a calibração usa sempre o frame completo)
+    int fullPass = proc->calibration.frames > 0 || !proc->roiTracking || proc->fullFrameInterval <= 1 ||
+                   (tracker->frameIndex - 1) % proc->fullFrameInterval == 0;
+
+    // Com a linha de contagem só a banda é segmentada (fora da calibração); com o
+    // modelo de fundo as ROIs são as regiões alteradas e o frame completo só é
+    // processado no primeiro frame, na calibração e quando quase tudo mudou
+    if (proc->tripwire) {
+        fullPass = proc->calibration.frames > 0;
+        if (!fullPass) proc->tripwire->frames++;
+    }
+    else if (proc->background) {
+        BackgroundModel *bg = proc->background;
+        const int valid = updateBackground(bg, frame);
+        fullPass = proc->calibration.frames > 0 || !valid || bg->coverage > VC_BG_MAX_COVERAGE ||
+                   changeRegions(bg, tracker->params.roiMargin + (1 << bg->level)) < 0;
+
+        bg->frames++;
+        bg->areaSum += fullPass ? 1.0 : (double)bg->regionPixels / ((double)proc->width * proc->height);
     }
 
+    // Deteção de blobs
+    OVC *blobs[VC_NUM_MASKS];
+    int nblobs[VC_NUM_MASKS];
+
+    segmentFrame(proc, frame, frame2, fullPass, blobs, nblobs);
+    analyseBlobs(proc, frame, blobs, nblobs, coinCounts, fullPass);
+
     // Limpeza de memória
-    if (blobs) free(blobs);
-    if (blobs2) free(blobs2);
-    if (blobs3) free(blobs3);
-    if (blobs4) free(blobs4);
-    
-    freeImage(rgbImage);
-    freeImage(hsvImage);
-    freeImage(hsvImage2);
-    freeImage(hsvImage3);
-    freeImage(grayImage);
-    freeImage(grayImage2);
-    freeImage(grayImage3);
-    freeImage(grayImage4);
-    freeImage(binaryImage);
-    freeImage(binaryImage2);
-    freeImage(binaryImage3);
-    freeImage(binaryImage4);
+    freeFrameBlobs(blobs);
+}
+
+/**
+ * @brief Processa um frame sem tempo de captura conhecido
+ *
+ * Equivalente a processFrameAt() com timestampMs negativo: o tempo é
+ * derivado do índice do frame e da cadência nominal do rastreador.
+ */
+void processFrame(FrameProcessor *proc, IVC *frame, IVC *frame2, int *coinCounts) {
+    processFrameAt(proc, frame, frame2, coinCounts, -1);
+}
+
+/**
+ * @brief Liga, ajusta ou desliga a re-deteção nas ROIs previstas
+ *
+ * A faixa de entrada ocupa toda a largura do frame e é recortada à sua
+ * altura.
+ */
+int setRoiTracking(FrameProcessor *proc, int fullFrameInterval, int entryRows) {
+    if (proc == NULL) return 0;
+
+    memset(&proc->entryBand, 0, sizeof(ImageRegion));
+    if (fullFrameInterval <= 0) {
+        proc->roiTracking = 0;
+        return 1;
+    }
+
+    proc->roiTracking = 1;
+    proc->fullFrameInterval = fullFrameInterval;
+
+    if (entryRows != 0) {
+        const int rows = VC_MIN(entryRows > 0 ? entryRows : -entryRows, proc->height);
+        proc->entryBand.x = 0;
+        proc->entryBand.y = (entryRows > 0) ? 0 : proc->height - rows;
+        proc->entryBand.width = proc->width;
+        proc->entryBand.height = rows;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Escolhe o modo de limiar de uma máscara
+ *
+ * O seletor volta ao estado inicial: o limiar automático é recalculado no
+ * próximo frame a partir do limiar fixo da máscara.
+ */
+int setMaskThreshold(FrameProcessor *proc, int mask, int mode, int localRadius) {
+    if (proc == NULL || mask < 0 || mask >= VC_NUM_MASKS) return 0;
+    if (mode != VC_THRESH_FIXED && mode != VC_THRESH_OTSU && mode != VC_THRESH_LOCAL) return 0;
+    if (localRadius < 0) return 0;
+
+    initThreshold(&proc->thresholds[mask], mode, MASK_PARAMS[mask].threshold);
+    proc->thresholds[mask].localRadius = localRadius;
+
+    return 1;
+}
+
+/**
+ * @brief Cria um slot de frame para o modo pipeline
+ *
+ * Aloca o frame BGR, a sua versão RGB, as imagens de trabalho da
+ * segmentação (incluindo a integral do limiar local) e uma máscara por
+ * VC_MASK_*, todos com as dimensões dos frames.
+ */
+FrameSlot *createFrameSlot(int width, int height) {
+    FrameSlot *slot;
+    int m, ok = 1;
+
+    if (width <= 0 || height <= 0) return NULL;
+
+    slot = (FrameSlot *)calloc(1, sizeof(FrameSlot));
+    if (slot == NULL) return NULL;
+
+    slot->frame = createImage(width, height, 3, 255);
+    slot->rgb = createImage(width, height, 3, 255);
+    slot->hsv = createImage(width, height, 3, 255);
+    slot->gray = createImage(width, height, 1, 255);
+    slot->binary = createImage(width, height, 1, 255);
+    slot->integral = createIntegral(width, height, VC_INTEGRAL_32);
+    for (m = 0; m < VC_NUM_MASKS; m++) {
+        slot->masks[m] = createImage(width, height, 1, 255);
+        if (!slot->masks[m]) ok = 0;
+    }
+    slot->timestampMs = -1;
+
+    if (!ok || !slot->frame || !slot->rgb || !slot->hsv || !slot->gray || !slot->binary || !slot->integral) {
+        return freeFrameSlot(slot);
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Liberta um slot de frame
+ * @param slot Ponteiro para o slot
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+FrameSlot *freeFrameSlot(FrameSlot *slot) {
+    if (slot != NULL) {
+        if (slot->frame) freeImage(slot->frame);
+        if (slot->rgb) freeImage(slot->rgb);
+        if (slot->hsv) freeImage(slot->hsv);
+        if (slot->gray) freeImage(slot->gray);
+        if (slot->binary) freeImage(slot->binary);
+        if (slot->integral) freeIntegral(slot->integral);
+        for (int m = 0; m < VC_NUM_MASKS; m++) {
+            if (slot->masks[m]) freeImage(slot->masks[m]);
+        }
+        freeFrameBlobs(slot->blobs);
+        free(slot);
+    }
+
+    return NULL;
+}
+
+// 1 se a máscara tiver algum pixel a 255
+static int hasForeground(const IVC *mask) {
+    const long int size = (long int)mask->bytesperline * mask->height;
+
+    for (long int i = 0; i < size; i++) {
+        if (mask->data[i]) return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Estágio de segmentação do modo pipeline
+ *
+ * Limpa as quatro máscaras do slot à resolução total, sem as etiquetar; a
+ * conversão para RGB já foi feita na leitura. O papel de frame2 é feito
+ * pela imagem RGB do slot de referência, que não pode ser reescrita
+ * enquanto este slot é segmentado. Tal como em processFrameAt(), as
+ * máscaras de cor só são segmentadas se a máscara principal tiver algum
+ * pixel. O modo pipeline ignora detectMode e roiTracking. O processador só
+ * é lido e cada slot tem a sua integral, pelo que várias threads podem
+ * segmentar slots diferentes ao mesmo tempo, desde que cada uma use o seu
+ * conjunto de limiares.
+ *
+ * @param proc Estado de processamento (parâmetros do rastreador)
+ * @param slot Slot com frame e rgb preenchidos
+ * @param reference Slot do frame secundário (NULL = o próprio slot)
+ * @param thresholds Limiares de cada máscara (VC_NUM_MASKS elementos)
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int segmentSlot(FrameProcessor *proc, FrameSlot *slot, const FrameSlot *reference,
+                ThresholdSelector *thresholds) {
+    const PipelineParams *params;
+    int m;
+
+    if (!proc || !slot || !thresholds) return 0;
+    if (slot->frame->width != proc->width || slot->frame->height != proc->height) return 0;
+
+    params = &proc->tracker->params;
+    IVC *rgb2 = (reference != NULL) ? reference->rgb : slot->rgb;
+
+    cleanMask(proc, slot->rgb, VC_MASK_MAIN, &thresholds[VC_MASK_MAIN], slot->integral, slot->hsv, slot->gray,
+              slot->binary, slot->masks[VC_MASK_MAIN], params->openKernel[VC_MASK_MAIN],
+              params->closeKernel[VC_MASK_MAIN], 0, 1);
+
+    slot->colourMasks = hasForeground(slot->masks[VC_MASK_MAIN]);
+    if (!slot->colourMasks) return 1;
+
+    for (m = 0; m < VC_NUM_MASKS; m++) {
+        if (m == VC_MASK_MAIN) continue;
+        cleanMask(proc, MASK_PARAMS[m].useFrame2 ? rgb2 : slot->rgb, m, &thresholds[m], slot->integral,
+                  slot->hsv, slot->gray, slot->binary, slot->masks[m], params->openKernel[m],
+                  params->closeKernel[m], 0, 1);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Etiqueta as máscaras de um slot e extrai as propriedades dos blobs
+ *
+ * Só etiqueta as máscaras de cor se a principal tiver blobs, como em
+ * processFrameAt(). Não usa o processador, pelo que corre na mesma thread
+ * que segmentou o slot; os blobs ficam no slot até analyseSlot().
+ *
+ * @param slot Slot já segmentado
+ * @return Número de blobs da máscara principal
+ */
+int labelSlot(FrameSlot *slot) {
+    int m;
+
+    if (!slot) return 0;
+
+    freeFrameBlobs(slot->blobs);
+    for (m = 0; m < VC_NUM_MASKS; m++) slot->nblobs[m] = 0;
+
+    slot->blobs[VC_MASK_MAIN] = labelMask(slot->masks[VC_MASK_MAIN], &slot->nblobs[VC_MASK_MAIN]);
+    if (slot->blobs[VC_MASK_MAIN] && slot->colourMasks) {
+        for (m = 0; m < VC_NUM_MASKS; m++) {
+            if (m != VC_MASK_MAIN)
+                slot->blobs[m] = labelMask(slot->masks[m], &slot->nblobs[m]);
+        }
+    }
+
+    return slot->nblobs[VC_MASK_MAIN];
+}
+
+/**
+ * @brief Estágio de análise do modo pipeline
+ *
+ * Classifica os blobs extraídos por labelSlot(), atualiza o rastreador e
+ * desenha o resultado em slot->frame; no fim liberta os blobs do slot. Tem
+ * de ser chamada pela ordem dos frames, sempre pela mesma thread.
+ *
+ * @param proc Estado de processamento
+ * @param slot Slot já etiquetado
+ * @param coinCounts Array com contadores para cada tipo de moeda
+ */
+void analyseSlot(FrameProcessor *proc, FrameSlot *slot, int *coinCounts) {
+    if (!proc || !slot || !coinCounts) return;
+
+    advanceClock(proc->tracker, slot->timestampMs);
+    analyseBlobs(proc, slot->frame, slot->blobs, slot->nblobs, coinCounts, 1);
+    freeFrameBlobs(slot->blobs);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,318 @@
+/**
+ * @file vc_integral.cpp
+ * @brief Imagens integrais (summed-area tables) e consultas de retângulos.
+ *
+ * Este ficheiro implementa a construção de imagens integrais para imagens
+ * de 1 canal, com acumuladores de 32 ou 64 bits e, opcionalmente, a integral
+ * dos quadrados. Depois de construída, a soma, média, variância ou taxa de
+ * preenchimento de qualquer retângulo obtém-se em tempo constante.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cria uma imagem integral para imagens com as dimensões dadas
+ *
+ * As tabelas têm (width + 1) x (height + 1) entradas, com a primeira linha
+ * e coluna a zero. Se for pedido o acumulador de 32 bits mas a soma máxima
+ * possível (width * height * 255) não couber em 32 bits, é usado o de 64.
+ *
+ * @param width Largura da imagem de origem
+ * @param height Altura da imagem de origem
+ * @param flags Combinação de VC_INTEGRAL_64 e VC_INTEGRAL_SQUARED
+ * @return Ponteiro para a imagem integral ou NULL em caso de erro
+ */
+IntegralImage *createIntegral(int width, int height, int flags) {
+    IntegralImage *ii;
+    long int entries;
+
+    if (width <= 0 || height <= 0) return NULL;
+
+    ii = (IntegralImage *)calloc(1, sizeof(IntegralImage));
+    if (ii == NULL) return NULL;
+
+    ii->width = width;
+    ii->height = height;
+    ii->stride = width + 1;
+    entries = (long int)(width + 1) * (height + 1);
+
+    if ((flags & VC_INTEGRAL_64) || (unsigned long long)width * height * 255ULL > UINT_MAX) {
+        ii->sum64 = (unsigned long long *)calloc(entries, sizeof(unsigned long long));
+        if (ii->sum64 == NULL) return freeIntegral(ii);
+    }
+    else {
+        ii->sum32 = (unsigned int *)calloc(entries, sizeof(unsigned int));
+        if (ii->sum32 == NULL) return freeIntegral(ii);
+    }
+
+    if (flags & VC_INTEGRAL_SQUARED) {
+        ii->sqsum = (unsigned long long *)calloc(entries, sizeof(unsigned long long));
+        if (ii->sqsum == NULL) return freeIntegral(ii);
+    }
+
+    return ii;
+}
+
+/**
+ * @brief Liberta a memória de uma imagem integral
+ * @param ii Ponteiro para a imagem integral
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+IntegralImage *freeIntegral(IntegralImage *ii) {
+    if (ii != NULL) {
+        if (ii->sum32) free(ii->sum32);
+        if (ii->sum64) free(ii->sum64);
+        if (ii->sqsum) free(ii->sqsum);
+        free(ii);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Calcula a imagem integral de uma imagem de 1 canal
+ *
+ * Cada linha é feita em dois passos: a soma acumulada da linha (dependência
+ * em série) e a soma com a linha anterior da tabela, que não tem dependências
+ * entre colunas e é vetorizada pelo compilador. A primeira linha e a
+ * primeira coluna da tabela são escritas a 0, para que as tabelas possam
+ * ser reutilizadas por vistas com outro stride (integralView()).
+ *
+ * @param src Imagem de origem (1 canal, mesmas dimensões da integral)
+ * @param ii Imagem integral de destino
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int computeIntegral(IVC *src, IntegralImage *ii) {
+    const int width = src->width;
+    const int height = src->height;
+    const int stride = ii->stride;
+    int x, y;
+
+    if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+    if (src->channels != 1) return 0;
+    if ((src->width != ii->width) || (src->height != ii->height)) return 0;
+
+    if (ii->sum32 != NULL) memset(ii->sum32, 0, stride * sizeof(unsigned int));
+    else memset(ii->sum64, 0, stride * sizeof(unsigned long long));
+    if (ii->sqsum != NULL) memset(ii->sqsum, 0, stride * sizeof(unsigned long long));
+
+    for (y = 0; y < height; y++) {
+        const unsigned char *row = src->data + (long int)y * src->bytesperline;
+
+        if (ii->sum32 != NULL) {
+            unsigned int *prev = ii->sum32 + (long int)y * stride + 1;
+            unsigned int *cur = prev + stride;
+            unsigned int acc = 0;
+
+            cur[-1] = 0;
+            for (x = 0; x < width; x++) {
+                acc += row[x];
+                cur[x] = acc;
+            }
+            for (x = 0; x < width; x++) {
+                cur[x] += prev[x];
+            }
+        }
+        else {
+            unsigned long long *prev = ii->sum64 + (long int)y * stride + 1;
+            unsigned long long *cur = prev + stride;
+            unsigned long long acc = 0;
+
+            cur[-1] = 0;
+            for (x = 0; x < width; x++) {
+                acc += row[x];
+                cur[x] = acc;
+            }
+            for (x = 0; x < width; x++) {
+                cur[x] += prev[x];
+            }
+        }
+
+        if (ii->sqsum != NULL) {
+            unsigned long long *prev = ii->sqsum + (long int)y * stride + 1;
+            unsigned long long *cur = prev + stride;
+            unsigned long long acc = 0;
+
+            cur[-1] = 0;
+            for (x = 0; x < width; x++) {
+                acc += (unsigned int)row[x] * row[x];
+                cur[x] = acc;
+            }
+            for (x = 0; x < width; x++) {
+                cur[x] += prev[x];
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Vista sobre as tabelas de uma integral para uma imagem mais pequena
+ *
+ * Uma tabela de (width + 1) x (height + 1) entradas cabe nas de ii quando
+ * width <= ii->width e height <= ii->height; os acumuladores são os de ii
+ * (os de 32 bits chegam, porque a imagem é mais pequena).
+ *
+ * @param ii Imagem integral com as tabelas
+ * @param width Largura da imagem de origem da vista
+ * @param height Altura da imagem de origem da vista
+ * @param view Vista de destino
+ * @return 1 em caso de sucesso, 0 se a imagem não couber nas tabelas de ii
+ */
+int integralView(const IntegralImage *ii, int width, int height, IntegralImage *view) {
+    if (width <= 0 || height <= 0 || width > ii->width || height > ii->height) return 0;
+
+    *view = *ii;
+    view->width = width;
+    view->height = height;
+    view->stride = width + 1;
+
+    return 1;
+}
+
+// Recorta o retângulo (x, y, w, h) aos limites da imagem; devolve 0 se ficar vazio
+static int clipRect(const IntegralImage *ii, int *x0, int *y0, int *x1, int *y1,
+                    int x, int y, int w, int h) {
+    *x0 = VC_MAX(x, 0);
+    *y0 = VC_MAX(y, 0);
+    *x1 = VC_MIN(x + w, ii->width);
+    *y1 = VC_MIN(y + h, ii->height);
+
+    return (*x1 > *x0) && (*y1 > *y0);
+}
+
+/**
+ * @brief Soma dos pixels de um retângulo em tempo constante
+ *
+ * O retângulo é recortado aos limites da imagem.
+ *
+ * @param ii Imagem integral
+ * @param x Coluna do canto superior esquerdo
+ * @param y Linha do canto superior esquerdo
+ * @param w Largura do retângulo
+ * @param h Altura do retângulo
+ * @return Soma dos pixels (0 se o retângulo estiver fora da imagem)
+ */
+unsigned long long integralSum(const IntegralImage *ii, int x, int y, int w, int h) {
+    int x0, y0, x1, y1;
+    const long int s = ii->stride;
+
+    if (!clipRect(ii, &x0, &y0, &x1, &y1, x, y, w, h)) return 0;
+
+    if (ii->sum32 != NULL) {
+        const unsigned int *t = ii->sum32;
+        // Aritmética módulo 2^32: o resultado é exato mesmo que os parciais "deem a volta"
+        return (unsigned int)(t[y1 * s + x1] - t[y0 * s + x1] - t[y1 * s + x0] + t[y0 * s + x0]);
+    }
+
+    const unsigned long long *t = ii->sum64;
+    return t[y1 * s + x1] - t[y0 * s + x1] - t[y1 * s + x0] + t[y0 * s + x0];
+}
+
+/**
+ * @brief Soma dos quadrados dos pixels de um retângulo em tempo constante
+ * @return Soma dos quadrados, ou 0 se a integral não tiver a tabela de quadrados
+ */
+unsigned long long integralSqSum(const IntegralImage *ii, int x, int y, int w, int h) {
+    int x0, y0, x1, y1;
+    const long int s = ii->stride;
+    const unsigned long long *t = ii->sqsum;
+
+    if (t == NULL) return 0;
+    if (!clipRect(ii, &x0, &y0, &x1, &y1, x, y, w, h)) return 0;
+
+    return t[y1 * s + x1] - t[y0 * s + x1] - t[y1 * s + x0] + t[y0 * s + x0];
+}
+
+/**
+ * @brief Média dos pixels de um retângulo (recortado à imagem)
+ * @return Média, ou 0 se o retângulo estiver fora da imagem
+ */
+float integralMean(const IntegralImage *ii, int x, int y, int w, int h) {
+    int x0, y0, x1, y1;
+
+    if (!clipRect(ii, &x0, &y0, &x1, &y1, x, y, w, h)) return 0.0f;
+
+    return (float)integralSum(ii, x0, y0, x1 - x0, y1 - y0) / (float)((x1 - x0) * (y1 - y0));
+}
+
+/**
+ * @brief Variância dos pixels de um retângulo (requer VC_INTEGRAL_SQUARED)
+ * @return Variância, ou 0 se não houver tabela de quadrados
+ */
+float integralVariance(const IntegralImage *ii, int x, int y, int w, int h) {
+    int x0, y0, x1, y1;
+
+    if (ii->sqsum == NULL) return 0.0f;
+    if (!clipRect(ii, &x0, &y0, &x1, &y1, x, y, w, h)) return 0.0f;
+
+    const double n = (double)(x1 - x0) * (y1 - y0);
+    const double mean = (double)integralSum(ii, x0, y0, x1 - x0, y1 - y0) / n;
+    const double var = (double)integralSqSum(ii, x0, y0, x1 - x0, y1 - y0) / n - mean * mean;
+
+    return (var > 0.0) ? (float)var : 0.0f;
+}
+
+/**
+ * @brief Fração de pixels ativos de uma máscara binária num retângulo
+ *
+ * Para a integral de uma máscara 0/255, devolve a fração do retângulo que
+ * está a 255. Um círculo inscrito na sua caixa delimitadora ocupa ~0.785.
+ *
+ * @return Taxa de preenchimento entre 0.0 e 1.0
+ */
+float integralFillRatio(const IntegralImage *ii, int x, int y, int w, int h) {
+    return integralMean(ii, x, y, w, h) / 255.0f;
+}
+
+/**
+ * @brief Filtro de média (box blur) com janela (2*radius+1)² a partir da integral
+ *
+ * O custo por pixel é constante, independentemente do raio. Junto às bordas
+ * a janela é recortada e a média usa só os pixels existentes.
+ *
+ * @param ii Imagem integral da imagem a filtrar
+ * @param dst Imagem de destino (1 canal, mesmas dimensões)
+ * @param radius Raio da janela
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int boxFilter(const IntegralImage *ii, IVC *dst, int radius) {
+    int x, y;
+
+    if ((dst->data == NULL) || (dst->channels != 1)) return 0;
+    if ((dst->width != ii->width) || (dst->height != ii->height)) return 0;
+    if (radius < 0) return 0;
+
+    for (y = 0; y < dst->height; y++) {
+        unsigned char *out = dst->data + (long int)y * dst->bytesperline;
+        const int y0 = VC_MAX(y - radius, 0);
+        const int y1 = VC_MIN(y + radius + 1, ii->height);
+
+        for (x = 0; x < dst->width; x++) {
+            const int x0 = VC_MAX(x - radius, 0);
+            const int x1 = VC_MIN(x + radius + 1, ii->width);
+            const unsigned long long area = (unsigned long long)(x1 - x0) * (y1 - y0);
+
+            out[x] = (unsigned char)((integralSum(ii, x0, y0, x1 - x0, y1 - y0) + area / 2) / area);
+        }
+    }
+
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
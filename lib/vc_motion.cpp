@@ -0,0 +1,186 @@
+/**
+ * @file vc_motion.cpp
+ * @brief Deteção de movimento barata para saltar os frames sem alterações.
+ *
+ * O frame é reduzido na pirâmide (1/8 por omissão) e comparado, por soma
+ * das diferenças absolutas (SAD), com a versão reduzida do último frame
+ * processado. A comparação é feita em células quadradas e o resultado é a
+ * maior diferença média de uma célula, para que uma moeda pequena a
+ * entrar no frame não se dilua na média de uma imagem parada.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vc.h"
+#include "vc_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Soma das diferenças absolutas entre duas imagens num retângulo
+ *
+ * Soma |a - b| sobre todos os canais dos pixels do retângulo (recortado às
+ * imagens). Cada linha é comparada em blocos de 16 bytes com
+ * _mm_sad_epu8 (SSE2) e o resto byte a byte.
+ *
+ * @param a Primeira imagem
+ * @param b Segunda imagem, com as dimensões e canais de a
+ * @param x Coluna do canto superior esquerdo
+ * @param y Linha do canto superior esquerdo
+ * @param w Largura do retângulo
+ * @param h Altura do retângulo
+ * @return Soma das diferenças absolutas (0 em caso de erro)
+ */
+unsigned long long imageSAD(const IVC *a, const IVC *b, int x, int y, int w, int h) {
+    unsigned long long sum = 0;
+    int row, i;
+
+    if (!a || !b || !a->data || !b->data) return 0;
+    if (a->width != b->width || a->height != b->height || a->channels != b->channels) return 0;
+
+    // Recorta o retângulo às imagens
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    w = VC_MIN(w, a->width - x);
+    h = VC_MIN(h, a->height - y);
+    if (w <= 0 || h <= 0) return 0;
+
+    const int rowBytes = w * a->channels;
+
+    for (row = y; row < y + h; row++) {
+        const unsigned char *pa = a->data + (long int)row * a->bytesperline + x * a->channels;
+        const unsigned char *pb = b->data + (long int)row * b->bytesperline + x * b->channels;
+
+        i = 0;
+#ifdef VC_SIMD_SSE2
+        // _mm_sad_epu8 soma as 8 diferenças de cada metade num inteiro de 64 bits
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= rowBytes; i += 16) {
+            const __m128i va = _mm_loadu_si128((const __m128i *)(pa + i));
+            const __m128i vb = _mm_loadu_si128((const __m128i *)(pb + i));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+        sum += (unsigned long long)_mm_cvtsi128_si32(acc) +
+               (unsigned long long)_mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc));
+#endif
+        for (; i < rowBytes; i++) {
+            sum += (pa[i] > pb[i]) ? pa[i] - pb[i] : pb[i] - pa[i];
+        }
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Cria um detetor de movimento para frames com as dimensões dadas
+ *
+ * Usa o nível VC_MOTION_LEVEL da pirâmide (ou o mais fino em que caiba uma
+ * célula de VC_MOTION_TILE pixels), com o limiar VC_MOTION_THRESHOLD e no
+ * máximo VC_MOTION_MAX_SKIP frames seguidos saltados.
+ *
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param channels Canais dos frames
+ * @return Ponteiro para o detetor ou NULL em caso de erro
+ */
+MotionGate *createMotionGate(int width, int height, int channels) {
+    MotionGate *gate;
+    int level = VC_MOTION_LEVEL;
+
+    if (width <= 0 || height <= 0 || channels <= 0) return NULL;
+
+    while (level > 0 && ((width >> level) < VC_MOTION_TILE || (height >> level) < VC_MOTION_TILE)) level--;
+
+    gate = (MotionGate *)calloc(1, sizeof(MotionGate));
+    if (gate == NULL) return NULL;
+
+    gate->level = level;
+    gate->tile = VC_MOTION_TILE;
+    gate->threshold = VC_MOTION_THRESHOLD;
+    gate->maxSkip = VC_MOTION_MAX_SKIP;
+    gate->pyramid = createPyramid(width, height, channels, level + 1);
+    gate->reference = createImage(width >> level, height >> level, channels, 255);
+
+    if (!gate->pyramid || !gate->reference) return freeMotionGate(gate);
+
+    return gate;
+}
+
+/**
+ * @brief Liberta um detetor de movimento
+ * @param gate Ponteiro para o detetor
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+MotionGate *freeMotionGate(MotionGate *gate) {
+    if (gate != NULL) {
+        if (gate->pyramid) freePyramid(gate->pyramid);
+        if (gate->reference) freeImage(gate->reference);
+        free(gate);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Decide se um frame deve ser processado
+ *
+ * Reduz o frame e calcula, célula a célula, a diferença média por amostra
+ * em relação ao último frame processado; o maior valor fica em
+ * gate->score. O frame é processado (e passa a ser a referência) se não
+ * houver referência, se score for maior do que gate->threshold ou se já
+ * tiverem sido saltados gate->maxSkip frames seguidos. Frames com outras
+ * dimensões são sempre processados.
+ *
+ * @param gate Detetor de movimento
+ * @param frame Frame a avaliar
+ * @return 1 se o frame deve ser processado, 0 se pode ser saltado
+ */
+int updateMotionGate(MotionGate *gate, IVC *frame) {
+    const IVC *reference;
+    IVC *small;
+    int x, y;
+
+    if (gate == NULL) return 1;
+    gate->frames++;
+
+    if (!buildPyramid(frame, gate->pyramid)) return 1;
+    small = gate->pyramid->levels[gate->level];
+    reference = gate->reference;
+    if (small->channels != reference->channels) return 1;
+
+    // Maior diferença média por amostra de uma célula
+    gate->score = 0.0f;
+    if (gate->hasReference) {
+        for (y = 0; y < small->height; y += gate->tile) {
+            const int h = VC_MIN(gate->tile, small->height - y);
+            for (x = 0; x < small->width; x += gate->tile) {
+                const int w = VC_MIN(gate->tile, small->width - x);
+                const float mean = (float)imageSAD(small, reference, x, y, w, h) / (float)(w * h * small->channels);
+                if (mean > gate->score) gate->score = mean;
+            }
+        }
+
+        if (gate->score <= gate->threshold && gate->skipped < gate->maxSkip) {
+            gate->skipped++;
+            gate->skippedFrames++;
+            return 0;
+        }
+    }
+
+    memcpy(reference->data, small->data, small->bytesperline * small->height);
+    gate->hasReference = 1;
+    gate->skipped = 0;
+
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
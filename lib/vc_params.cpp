@@ -0,0 +1,148 @@
+/**
+ * @file vc_params.cpp
+ * @brief Parâmetros espaciais do processamento independentes da resolução.
+ *
+ * Este ficheiro deriva, uma vez por sequência, todos os limiares em pixels
+ * do processamento (áreas, larguras, distâncias, kernels morfológicos,
+ * portas de associação e margens) a partir dos valores da montagem de
+ * referência e da escala da tabela de denominações, que vem da resolução
+ * dos frames ou da calibração automática.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parâmetros da montagem de referência (frames de 640x480, tabela por omissão)
+static const PipelineParams REFERENCE_PARAMS = {
+    1.0f,                   // scale
+    9000, 30000, 220,       // minBlobArea, maxBlobArea, maxBlobWidth
+    30 * 30,                // matchDistanceSq
+    { 3, 7, 3, 3 },         // openKernel (VC_MASK_MAIN, GOLD, COPPER, EURO)
+    { 5, 0, 0, 0 },         // closeKernel
+    4000,                   // coarseMinArea
+    6000,                   // minClassArea
+    100000, 14000, 130,     // euroMaxArea, euroPartialMinArea, euroPartialMinSize
+    0.65f,                  // euroPartialMinCircularity
+    7000, 12000,            // drawMinArea, drawEuroMinArea
+    50,                     // toleranceMargin
+    50, 75,                 // coinGate, euroGate
+    50,                     // locationRadius
+    30,                     // exclusionRadius
+    VC_ROI_MARGIN,          // roiMargin
+    VC_ROI_DEFAULT_DIAMETER,
+    VC_TRACK_MAX_SPEED,
+};
+
+static inline int scaledLength(int length, float scale) {
+    return VC_MAX(1, (int)lroundf(length * scale));
+}
+
+static inline int scaledArea(int area, float scale) {
+    return (int)lroundf(area * scale * scale);
+}
+
+// Kernels morfológicos mantêm-se ímpares (0 continua a desligar a operação)
+static inline int scaledKernel(int kernel, float scale) {
+    if (kernel <= 0) return 0;
+    return 2 * (int)lroundf((kernel - 1) / 2.0f * scale) + 1;
+}
+
+/**
+ * @brief Deriva os parâmetros espaciais para um fator de escala
+ *
+ * Comprimentos são multiplicados por scale e áreas por scale²; com
+ * scale = 1 os parâmetros são exatamente os de referência.
+ */
+void derivePipelineParams(PipelineParams *params, float scale) {
+    const PipelineParams *ref = &REFERENCE_PARAMS;
+    int m;
+
+    if (scale <= 0.0f) scale = 1.0f;
+
+    const int matchDistance = (int)lroundf(sqrtf((float)ref->matchDistanceSq) * scale);
+
+    params->scale = scale;
+    params->minBlobArea = scaledArea(ref->minBlobArea, scale);
+    params->maxBlobArea = scaledArea(ref->maxBlobArea, scale);
+    params->maxBlobWidth = scaledLength(ref->maxBlobWidth, scale);
+    params->matchDistanceSq = matchDistance * matchDistance;
+
+    for (m = 0; m < VC_NUM_MASKS; m++) {
+        params->openKernel[m] = scaledKernel(ref->openKernel[m], scale);
+        params->closeKernel[m] = scaledKernel(ref->closeKernel[m], scale);
+    }
+
+    params->coarseMinArea = scaledArea(ref->coarseMinArea, scale);
+    params->minClassArea = scaledArea(ref->minClassArea, scale);
+    params->euroMaxArea = scaledArea(ref->euroMaxArea, scale);
+    params->euroPartialMinArea = scaledArea(ref->euroPartialMinArea, scale);
+    params->euroPartialMinSize = scaledLength(ref->euroPartialMinSize, scale);
+    params->euroPartialMinCircularity = ref->euroPartialMinCircularity;
+    params->drawMinArea = scaledArea(ref->drawMinArea, scale);
+    params->drawEuroMinArea = scaledArea(ref->drawEuroMinArea, scale);
+    params->toleranceMargin = scaledLength(ref->toleranceMargin, scale);
+    params->coinGate = scaledLength(ref->coinGate, scale);
+    params->euroGate = scaledLength(ref->euroGate, scale);
+    params->locationRadius = scaledLength(ref->locationRadius, scale);
+    params->exclusionRadius = scaledLength(ref->exclusionRadius, scale);
+    params->roiMargin = scaledLength(ref->roiMargin, scale);
+    params->roiDefaultDiameter = ref->roiDefaultDiameter * scale;
+    params->maxSpeed = ref->maxSpeed * scale;
+}
+
+/**
+ * @brief Recalcula os parâmetros espaciais do rastreador
+ *
+ * A escala é a razão entre a escala (px/mm) da tabela do rastreador e a da
+ * tabela por omissão; para tabelas sem diâmetros reais usa a razão entre a
+ * altura dos frames e VC_REFERENCE_HEIGHT.
+ */
+void updatePipelineParams(CoinTracker *tracker) {
+    CoinSpecTable reference;
+    float scale;
+
+    defaultCoinSpecs(&reference);
+
+    const float current = coinSpecScale(&tracker->specs);
+    if (current > 0.0f)
+        scale = current / coinSpecScale(&reference);
+    else
+        scale = (float)tracker->height / VC_REFERENCE_HEIGHT;
+
+    derivePipelineParams(&tracker->params, scale);
+    tracker->maxSpeed = tracker->params.maxSpeed;
+}
+
+/**
+ * @brief Usa uma tabela de denominações definida à resolução de referência
+ *
+ * Assume o mesmo campo de visão da montagem de referência: os diâmetros
+ * crescem com a altura dos frames. Uma calibração posterior
+ * (finishCalibration()) corrige a escala quando a câmara também mudou.
+ */
+void setCoinSpecs(CoinTracker *tracker, const CoinSpecTable *table) {
+    if (tracker == NULL || table == NULL) return;
+
+    if (table != &tracker->specs)
+        tracker->specs = *table;
+
+    if (tracker->height != VC_REFERENCE_HEIGHT)
+        resizeCoinSpecs(&tracker->specs, (float)tracker->height / VC_REFERENCE_HEIGHT);
+
+    updatePipelineParams(tracker);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,497 @@
+/**
+ * @file vc_pipeline.cpp
+ * @brief Execução em pipeline: leitura, segmentação, análise e visualização em paralelo.
+ *
+ * Cada estágio corre na sua própria thread e passa os frames ao seguinte
+ * através de anéis sem bloqueios com um único produtor e um único
+ * consumidor. Os frames vivem num conjunto fixo de slots (FrameSlot),
+ * alocados ao arrancar; pelos anéis só circulam os índices dos slots, e
+ * depois de mostrado cada slot volta ao anel de slots livres do estágio de
+ * leitura.
+ *
+ * A segmentação, a etiquetagem e a extração das propriedades dos blobs
+ * podem correr em K threads de trabalho: a leitura distribui os frames
+ * por ordem (o frame n vai para a thread n % K, cada uma com o seu anel) e
+ * a análise recolhe-os pela mesma ordem, pelo que só a classificação e o
+ * rastreador, que são baratos, ficam numa única thread. As contagens são
+ * as mesmas do processamento sequencial à resolução total. A leitura
+ * converte cada frame para RGB antes de o distribuir, para que o frame2
+ * (a imagem RGB de um slot anterior) esteja pronto seja qual for a thread
+ * que o usa; esse slot só volta a ficar livre depois de mostrados todos
+ * os frames que dependem dele.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "vc.h"
+
+#define VC_CACHE_LINE 64
+
+// Anel circular de índices: head só é escrito pelo consumidor e tail só pelo
+// produtor, cada um na sua linha de cache
+struct SlotRing {
+    int *items;
+    int capacity;
+    char pad0[VC_CACHE_LINE];
+    std::atomic<long long> head;    // Próxima posição a ler
+    char pad1[VC_CACHE_LINE];
+    std::atomic<long long> tail;    // Próxima posição a escrever
+    char pad2[VC_CACHE_LINE];
+    std::atomic<bool> closed;
+};
+
+// Estado partilhado pelas threads de um pipeline
+typedef struct {
+    FrameProcessor *proc;
+    const PipelineCallbacks *callbacks;
+    int *coinCounts;
+    FrameSlot **slots;       // Conjunto fixo de slots
+    int nSlots;
+    int *references;         // Slot do frame2 de cada slot (escrito pela leitura)
+    int nWorkers;
+    SlotRing *freeSlots;     // render -> leitura
+    SlotRing **decoded;      // leitura -> thread de trabalho (uma por thread)
+    SlotRing **segmented;    // thread de trabalho -> análise (um por thread)
+    SlotRing *analysed;      // análise -> render
+    std::atomic<bool> stop;
+    long long sequence;      // Próximo frame a ler
+    long long firstSequence; // Primeiro frame distribuído pelas threads de trabalho
+    int reference;           // Slot do frame2 em vigor (-1 = nenhum)
+    long long frames;        // Frames que chegaram ao fim do pipeline
+    double stageSeconds[VC_PIPELINE_STAGES];
+    double *workerSeconds;   // Tempo ocupado de cada thread de trabalho
+    ThresholdSelector *thresholds; // VC_NUM_MASKS limiares por thread de trabalho
+} Pipeline;
+
+typedef std::chrono::steady_clock PipelineClock;
+
+static double elapsedSeconds(PipelineClock::time_point start) {
+    return std::chrono::duration<double>(PipelineClock::now() - start).count();
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cria um anel de índices de slots
+ * @param capacity Número máximo de índices no anel
+ * @return Ponteiro para o anel ou NULL em caso de erro
+ */
+SlotRing *createSlotRing(int capacity) {
+    SlotRing *ring;
+
+    if (capacity <= 0) return NULL;
+
+    ring = new (std::nothrow) SlotRing;
+    if (ring == NULL) return NULL;
+
+    ring->items = (int *)calloc(capacity, sizeof(int));
+    if (ring->items == NULL) {
+        delete ring;
+        return NULL;
+    }
+
+    ring->capacity = capacity;
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->closed.store(false);
+
+    return ring;
+}
+
+/**
+ * @brief Liberta um anel de índices
+ * @param ring Ponteiro para o anel
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+SlotRing *freeSlotRing(SlotRing *ring) {
+    if (ring != NULL) {
+        if (ring->items) free(ring->items);
+        delete ring;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Coloca um índice no fim do anel, sem esperar
+ *
+ * Só pode ser chamada pela thread produtora. A publicação de tail (release)
+ * torna visível ao consumidor tudo o que o produtor escreveu no slot.
+ *
+ * @param ring Ponteiro para o anel
+ * @param index Índice a inserir
+ * @return 1 em caso de sucesso, 0 se o anel estiver cheio
+ */
+int ringPush(SlotRing *ring, int index) {
+    const long long tail = ring->tail.load(std::memory_order_relaxed);
+
+    if (tail - ring->head.load(std::memory_order_acquire) >= ring->capacity) return 0;
+
+    ring->items[tail % ring->capacity] = index;
+    ring->tail.store(tail + 1, std::memory_order_release);
+
+    return 1;
+}
+
+/**
+ * @brief Retira o índice do início do anel, sem esperar
+ *
+ * Só pode ser chamada pela thread consumidora.
+ *
+ * @param ring Ponteiro para o anel
+ * @param index Onde escrever o índice retirado
+ * @return 1 em caso de sucesso, 0 se o anel estiver vazio
+ */
+int ringPop(SlotRing *ring, int *index) {
+    const long long head = ring->head.load(std::memory_order_relaxed);
+
+    if (head == ring->tail.load(std::memory_order_acquire)) return 0;
+
+    *index = ring->items[head % ring->capacity];
+    ring->head.store(head + 1, std::memory_order_release);
+
+    return 1;
+}
+
+/**
+ * @brief Fecha o anel: o produtor deixa de inserir e o consumidor termina
+ * depois de retirar os índices que ainda lá estão
+ * @param ring Ponteiro para o anel
+ */
+void ringClose(SlotRing *ring) {
+    ring->closed.store(true, std::memory_order_release);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+// Espera ativa curta; depois cede o processador e, por fim, dorme
+static void backoff(int *spins) {
+    if (++(*spins) < 64) return;
+
+    if (*spins < 1024)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+// Retira um índice, esperando enquanto o anel estiver vazio; 0 = fechado e vazio
+static int waitPop(SlotRing *ring, int *index) {
+    int spins = 0;
+
+    while (!ringPop(ring, index)) {
+        // Depois de ver o anel fechado, um último pop apanha o que foi inserido antes
+        if (ring->closed.load(std::memory_order_acquire))
+            return ringPop(ring, index);
+        backoff(&spins);
+    }
+
+    return 1;
+}
+
+// Insere um índice, esperando enquanto o anel estiver cheio; 0 = fechado
+static int waitPush(SlotRing *ring, int index) {
+    int spins = 0;
+
+    while (!ringPush(ring, index)) {
+        if (ring->closed.load(std::memory_order_acquire)) return 0;
+        backoff(&spins);
+    }
+
+    return 1;
+}
+
+// Lê o próximo frame para slot, converte-o para RGB e fixa o seu frame2; devolve 0 no fim da sequência
+static int readFrame(Pipeline *p, FrameSlot *slot) {
+    const PipelineClock::time_point start = PipelineClock::now();
+
+    slot->timestampMs = -1;
+    slot->sequence = p->sequence;
+    const int ok = p->callbacks->read(p->callbacks->user, slot);
+    if (ok) {
+        bgr2rgb(slot->frame, slot->rgb);
+
+        // frame2 é o último frame com índice múltiplo de VC_FRAME2_INTERVAL
+        if (slot->sequence % VC_FRAME2_INTERVAL == 0)
+            p->reference = slot->index;
+        p->references[slot->index] = p->reference;
+        p->sequence++;
+    }
+    p->stageSeconds[VC_STAGE_DECODE] += elapsedSeconds(start);
+
+    return ok;
+}
+
+// Segmenta e etiqueta slot com os limiares da thread de trabalho worker
+static void segmentFrame(Pipeline *p, FrameSlot *slot, int worker) {
+    const PipelineClock::time_point start = PipelineClock::now();
+    const int reference = p->references[slot->index];
+
+    segmentSlot(p->proc, slot, (reference >= 0) ? p->slots[reference] : NULL,
+                &p->thresholds[worker * VC_NUM_MASKS]);
+    labelSlot(slot);
+    p->workerSeconds[worker] += elapsedSeconds(start);
+}
+
+// Thread de trabalho que recebe o frame n (contado a partir de firstSequence)
+static int workerOf(const Pipeline *p, long long sequence) {
+    return (int)((sequence - p->firstSequence) % p->nWorkers);
+}
+
+// Estágio de leitura: preenche slots livres até ao fim da sequência ou a um pedido de paragem
+static void decodeStage(Pipeline *p) {
+    int index, w;
+
+    while (!p->stop.load() && waitPop(p->freeSlots, &index)) {
+        if (p->stop.load() || !readFrame(p, p->slots[index])) break;
+        if (!waitPush(p->decoded[workerOf(p, p->slots[index]->sequence)], index)) break;
+    }
+
+    for (w = 0; w < p->nWorkers; w++) ringClose(p->decoded[w]);
+}
+
+// Thread de trabalho: limiar, morfologia, etiquetagem e propriedades dos blobs
+static void workerStage(Pipeline *p, int worker) {
+    int index;
+
+    while (waitPop(p->decoded[worker], &index)) {
+        segmentFrame(p, p->slots[index], worker);
+        if (!waitPush(p->segmented[worker], index)) break;
+    }
+
+    ringClose(p->segmented[worker]);
+}
+
+// Estágio de análise: única thread que altera o rastreador, a recolher os frames pela ordem
+static void analyseStage(Pipeline *p) {
+    long long next = p->firstSequence;
+    int index;
+
+    // Se o anel do próximo frame fechou vazio, a leitura terminou antes dele
+    while (waitPop(p->segmented[workerOf(p, next)], &index)) {
+        const PipelineClock::time_point start = PipelineClock::now();
+        analyseSlot(p->proc, p->slots[index], p->coinCounts);
+        p->stageSeconds[VC_STAGE_ANALYSE] += elapsedSeconds(start);
+        next++;
+
+        if (!waitPush(p->analysed, index)) break;
+    }
+
+    ringClose(p->analysed);
+}
+
+// Mostra um slot; devolve 0 quando a aplicação pede para parar
+static int renderFrame(Pipeline *p, FrameSlot *slot) {
+    int more = 1;
+
+    if (p->callbacks->render) {
+        const PipelineClock::time_point start = PipelineClock::now();
+        more = p->callbacks->render(p->callbacks->user, slot);
+        p->stageSeconds[VC_STAGE_RENDER] += elapsedSeconds(start);
+    }
+
+    p->frames++;
+    return more;
+}
+
+// Processa na thread atual, com os slots em rotação, os frames de uma calibração em curso
+static int calibrateSequential(Pipeline *p) {
+    FrameProcessor *proc = p->proc;
+
+    while (proc->calibration.frames > 0) {
+        FrameSlot *slot = p->slots[p->sequence % p->nSlots];
+
+        if (!readFrame(p, slot)) {
+            finishCalibration(proc);
+            return 0;
+        }
+
+        segmentFrame(p, slot, 0);
+
+        const PipelineClock::time_point start = PipelineClock::now();
+        analyseSlot(proc, slot, p->coinCounts);
+        p->stageSeconds[VC_STAGE_ANALYSE] += elapsedSeconds(start);
+
+        if (!renderFrame(p, slot)) return 0;
+    }
+
+    return 1;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Processa uma sequência em pipeline
+ *
+ * A leitura, as threads de segmentação e a análise correm em threads
+ * próprias; a visualização corre na thread que chama esta função (as
+ * janelas do OpenCV têm de ser geridas pela thread principal). Em cada
+ * momento há no máximo depth frames em circulação e, depois de arrancar,
+ * nenhum frame é copiado. Cada thread de segmentação tem a sua cópia dos
+ * limiares do processador; no modo de Otsu cada cópia seria atualizada só
+ * com os frames dessa thread e o limiar de cada frame dependeria do número
+ * de threads, por isso o modo de Otsu só é aceite com uma thread. Quando
+ * render devolve 0, a leitura pára e os frames já lidos são processados
+ * mas não mostrados.
+ *
+ * @param proc Estado de processamento
+ * @param callbacks Estágios de leitura e visualização da aplicação
+ * @param depth Número de slots em circulação (<= 0 = VC_PIPELINE_DEPTH; mínimo workers + VC_FRAME2_INTERVAL)
+ * @param workers Threads de segmentação (1 a VC_PIPELINE_MAX_WORKERS)
+ * @param coinCounts Array com contadores para cada tipo de moeda
+ * @param stats Tempos por estágio (pode ser NULL)
+ * @return 1 em caso de sucesso, 0 em caso de erro (incluindo uma máscara com VC_THRESH_OTSU e workers > 1)
+ */
+int runPipeline(FrameProcessor *proc, const PipelineCallbacks *callbacks, int depth, int workers,
+                int *coinCounts, PipelineStats *stats) {
+    const PipelineClock::time_point runStart = PipelineClock::now();
+    Pipeline p;
+    int i, w, ok = 1;
+
+    if (!proc || !callbacks || !callbacks->read || !coinCounts) return 0;
+    if (workers < 1 || workers > VC_PIPELINE_MAX_WORKERS) return 0;
+    for (i = 0; workers > 1 && i < VC_NUM_MASKS; i++) {
+        if (proc->thresholds[i].mode == VC_THRESH_OTSU) {
+            fprintf(stderr, "Erro: o limiar de Otsu (máscara %d) não é determinístico com %d threads de segmentação\n",
+                    i, workers);
+            return 0;
+        }
+    }
+    if (depth <= 0) depth = VC_PIPELINE_DEPTH;
+    // Um slot fica retido como frame2; os restantes mantêm todas as threads ocupadas
+    depth = VC_MAX(depth, workers + VC_FRAME2_INTERVAL);
+
+    p.proc = proc;
+    p.callbacks = callbacks;
+    p.coinCounts = coinCounts;
+    p.nSlots = depth;
+    p.nWorkers = workers;
+    p.stop = false;
+    p.sequence = 0;
+    p.firstSequence = 0;
+    p.reference = -1;
+    p.frames = 0;
+    memset(p.stageSeconds, 0, sizeof(p.stageSeconds));
+    p.slots = (FrameSlot **)calloc(depth, sizeof(FrameSlot *));
+    p.references = (int *)calloc(depth, sizeof(int));
+    p.decoded = (SlotRing **)calloc(workers, sizeof(SlotRing *));
+    p.segmented = (SlotRing **)calloc(workers, sizeof(SlotRing *));
+    p.workerSeconds = (double *)calloc(workers, sizeof(double));
+    p.thresholds = (ThresholdSelector *)calloc((size_t)workers * VC_NUM_MASKS, sizeof(ThresholdSelector));
+    p.freeSlots = createSlotRing(depth);
+    p.analysed = createSlotRing(depth);
+
+    if (!p.slots || !p.references || !p.decoded || !p.segmented || !p.workerSeconds || !p.thresholds ||
+        !p.freeSlots || !p.analysed) ok = 0;
+    for (w = 0; ok && w < workers; w++) {
+        p.decoded[w] = createSlotRing(depth);
+        p.segmented[w] = createSlotRing(depth);
+        if (!p.decoded[w] || !p.segmented[w]) ok = 0;
+        else memcpy(&p.thresholds[w * VC_NUM_MASKS], proc->thresholds, sizeof(proc->thresholds));
+    }
+    for (i = 0; ok && i < depth; i++) {
+        p.slots[i] = createFrameSlot(proc->width, proc->height);
+        if (p.slots[i] == NULL) ok = 0;
+        else p.slots[i]->index = i;
+    }
+
+    // A calibração altera os parâmetros lidos pela segmentação: termina-a antes de arrancar
+    const int running = ok && calibrateSequential(&p);
+
+    if (running) {
+        // O frame2 em vigor fica retido; os outros slots entram em rotação a partir do seguinte ao último usado
+        int held = p.reference;
+        for (i = 0; i < depth; i++) {
+            const int index = (int)((p.sequence + i) % depth);
+            if (index != held) ringPush(p.freeSlots, index);
+        }
+        p.firstSequence = p.sequence;
+        // A calibração corre com os limiares da primeira thread; as outras partem do mesmo estado
+        for (w = 1; w < workers; w++)
+            memcpy(&p.thresholds[w * VC_NUM_MASKS], p.thresholds, VC_NUM_MASKS * sizeof(ThresholdSelector));
+
+        std::vector<std::thread> threads;
+        try {
+            threads.push_back(std::thread(decodeStage, &p));
+            for (w = 0; w < workers; w++) threads.push_back(std::thread(workerStage, &p, w));
+            threads.push_back(std::thread(analyseStage, &p));
+        }
+        catch (const std::system_error &e) {
+            fprintf(stderr, "Erro: não foi possível criar as threads do pipeline (%s)\n", e.what());
+            p.stop = true;
+            ringClose(p.freeSlots);
+            for (w = 0; w < workers; w++) {
+                ringClose(p.decoded[w]);
+                ringClose(p.segmented[w]);
+            }
+            ringClose(p.analysed);
+            ok = 0;
+        }
+
+        // Visualização na thread atual; depois de um pedido de paragem só devolve os slots
+        int index;
+        while (waitPop(p.analysed, &index)) {
+            const FrameSlot *slot = p.slots[index];
+
+            if (p.stop.load()) p.frames++;
+            else if (!renderFrame(&p, p.slots[index])) p.stop = true;
+
+            // Os frames que usam um slot como frame2 são mostrados antes do frame2 seguinte
+            if (slot->sequence % VC_FRAME2_INTERVAL == 0) {
+                if (held >= 0) waitPush(p.freeSlots, held);
+                held = index;
+            }
+            else waitPush(p.freeSlots, index);
+        }
+        if (held >= 0) waitPush(p.freeSlots, held);
+        ringClose(p.freeSlots);
+
+        for (size_t t = 0; t < threads.size(); t++) {
+            if (threads[t].joinable()) threads[t].join();
+        }
+    }
+
+    for (i = 0; p.slots && i < depth; i++) freeFrameSlot(p.slots[i]);
+    for (w = 0; w < workers; w++) {
+        if (p.decoded) freeSlotRing(p.decoded[w]);
+        if (p.segmented) freeSlotRing(p.segmented[w]);
+        if (p.workerSeconds) p.stageSeconds[VC_STAGE_SEGMENT] += p.workerSeconds[w];
+    }
+    free(p.slots);
+    free(p.references);
+    free(p.decoded);
+    free(p.segmented);
+    free(p.workerSeconds);
+    free(p.thresholds);
+    freeSlotRing(p.freeSlots);
+    freeSlotRing(p.analysed);
+
+    if (stats) {
+        stats->frames = p.frames;
+        memcpy(stats->stageSeconds, p.stageSeconds, sizeof(p.stageSeconds));
+        stats->wallSeconds = elapsedSeconds(runStart);
+    }
+
+    return ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file vc_pyramid.cpp
+ * @brief Redução de resolução e pirâmides de imagens.
+ *
+ * Este ficheiro implementa a redução 2x2 (média de caixa) de imagens IVC e
+ * a construção de pirâmides de resolução, usadas para segmentar e etiquetar
+ * as moedas a uma escala grosseira antes de refinar à resolução total.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vc.h"
+#include "vc_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Redução 2x2 com um buffer de somas verticais dado pelo chamador
+ *
+ * Implementação de downsample2x(). sums tem de ter espaço para
+ * dst->width * 2 * channels somas.
+ */
+static int downsampleRows(IVC *src, IVC *dst, unsigned short *sums) {
+    const int channels = src->channels;
+    const int dstWidth = dst->width;
+    const int dstHeight = dst->height;
+    const int rowBytes = dstWidth * 2 * channels;
+    int x, y, c;
+
+    if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL))
+        return 0;
+    if ((dstWidth != src->width / 2) || (dstHeight != src->height / 2) || (dst->channels != channels))
+        return 0;
+    if (dstWidth <= 0 || dstHeight <= 0)
+        return 0;
+
+    for (y = 0; y < dstHeight; y++) {
+        const unsigned char *row0 = src->data + (long int)(2 * y) * src->bytesperline;
+        const unsigned char *row1 = row0 + src->bytesperline;
+        unsigned char *out = dst->data + (long int)y * dst->bytesperline;
+
+        x = 0;
+#ifdef VC_SIMD_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= rowBytes; x += 16) {
+            const __m128i a = _mm_loadu_si128((const __m128i *)(row0 + x));
+            const __m128i b = _mm_loadu_si128((const __m128i *)(row1 + x));
+            _mm_storeu_si128((__m128i *)(sums + x),
+                             _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+            _mm_storeu_si128((__m128i *)(sums + x + 8),
+                             _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+        }
+#endif
+        for (; x < rowBytes; x++) {
+            sums[x] = (unsigned short)(row0[x] + row1[x]);
+        }
+
+        x = 0;
+#ifdef VC_SIMD_SSE2
+        if (channels == 1) {
+            const __m128i ones = _mm_set1_epi16(1);
+            const __m128i two = _mm_set1_epi32(2);
+
+            // 16 pixels de saída a partir de 32 somas verticais
+            for (; x + 16 <= dstWidth; x += 16) {
+                const __m128i *p = (const __m128i *)(sums + 2 * x);
+                const __m128i s0 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128(p), ones), two), 2);
+                const __m128i s1 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128(p + 1), ones), two), 2);
+                const __m128i s2 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128(p + 2), ones), two), 2);
+                const __m128i s3 = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128(p + 3), ones), two), 2);
+                _mm_storeu_si128((__m128i *)(out + x),
+                                 _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3)));
+            }
+        }
+#endif
+        for (; x < dstWidth; x++) {
+            const unsigned short *p = sums + 2 * x * channels;
+            for (c = 0; c < channels; c++) {
+                out[x * channels + c] = (unsigned char)((p[c] + p[c + channels] + 2) >> 2);
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Reduz uma imagem para metade com uma média de caixa 2x2
+ *
+ * Cada pixel (e canal) do destino é a média arredondada dos quatro pixels
+ * correspondentes da origem. A soma vertical das duas linhas é feita com
+ * SSE2 para qualquer número de canais; em imagens de 1 canal também a soma
+ * horizontal dos pares é vetorizada (madd com pesos 1).
+ *
+ * @param src Ponteiro para a imagem de origem
+ * @param dst Ponteiro para a imagem de destino, com largura src->width / 2 e altura src->height / 2
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int downsample2x(IVC *src, IVC *dst) {
+    // Somas verticais de uma linha (no máximo 510, cabem em 16 bits)
+    unsigned short *sums = (unsigned short *)malloc(((long int)dst->width * 2 * src->channels + 16) * sizeof(unsigned short));
+    int ok;
+
+    if (sums == NULL)
+        return 0;
+
+    ok = downsampleRows(src, dst, sums);
+    free(sums);
+    return ok;
+}
+
+/**
+ * @brief Cria uma pirâmide de imagens
+ *
+ * O nível 0 não é alocado: aponta para a imagem passada a buildPyramid().
+ * Os níveis seguintes têm metade da largura e altura do anterior.
+ *
+ * @param width Largura da imagem base
+ * @param height Altura da imagem base
+ * @param channels Número de canais da imagem base
+ * @param nlevels Número de níveis, incluindo a base (1 a VC_PYRAMID_MAX_LEVELS)
+ * @return Ponteiro para a pirâmide criada ou NULL em caso de erro
+ */
+ImagePyramid *createPyramid(int width, int height, int channels, int nlevels) {
+    ImagePyramid *pyramid;
+    int i;
+
+    if (width <= 0 || height <= 0) return NULL;
+    if (nlevels < 1 || nlevels > VC_PYRAMID_MAX_LEVELS) return NULL;
+    if ((width >> (nlevels - 1)) <= 0 || (height >> (nlevels - 1)) <= 0) return NULL;
+
+    pyramid = (ImagePyramid *)calloc(1, sizeof(ImagePyramid));
+    if (pyramid == NULL) return NULL;
+
+    pyramid->nlevels = nlevels;
+
+    // A linha mais larga a somar é a do nível 0 (metade da largura, aos pares)
+    pyramid->rowSums = (unsigned short *)malloc(((long int)(width / 2) * 2 * channels + 16) * sizeof(unsigned short));
+    if (pyramid->rowSums == NULL) {
+        return freePyramid(pyramid);
+    }
+
+    for (i = 1; i < nlevels; i++) {
+        pyramid->levels[i] = createImage(width >> i, height >> i, channels, 255);
+        if (pyramid->levels[i] == NULL) {
+            return freePyramid(pyramid);
+        }
+    }
+
+    return pyramid;
+}
+
+/**
+ * @brief Liberta a memória de uma pirâmide (o nível 0 não lhe pertence)
+ * @param pyramid Ponteiro para a pirâmide
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+ImagePyramid *freePyramid(ImagePyramid *pyramid) {
+    int i;
+
+    if (pyramid != NULL) {
+        for (i = 1; i < VC_PYRAMID_MAX_LEVELS; i++) {
+            if (pyramid->levels[i] != NULL)
+                freeImage(pyramid->levels[i]);
+        }
+        if (pyramid->rowSums != NULL)
+            free(pyramid->rowSums);
+        free(pyramid);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Constrói todos os níveis da pirâmide a partir de uma imagem base
+ * @param src Imagem base (passa a ser o nível 0)
+ * @param pyramid Pirâmide criada com as mesmas dimensões que src
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int buildPyramid(IVC *src, ImagePyramid *pyramid) {
+    int i;
+
+    if (src == NULL || pyramid == NULL) return 0;
+    if (pyramid->nlevels > 1 &&
+        (pyramid->levels[1]->width != src->width / 2 || pyramid->levels[1]->height != src->height / 2))
+        return 0;
+
+    pyramid->levels[0] = src;
+
+    for (i = 1; i < pyramid->nlevels; i++) {
+        if (!downsampleRows(pyramid->levels[i - 1], pyramid->levels[i], pyramid->rowSums))
+            return 0;
+    }
+
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
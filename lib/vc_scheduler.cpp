@@ -0,0 +1,418 @@
+/**
+ * @file vc_scheduler.cpp
+ * @brief Escalonador de tarefas com roubo de trabalho (work stealing).
+ *
+ * Cada thread de trabalho tem a sua fila dupla de tarefas. As tarefas
+ * submetidas por uma thread de trabalho entram no fim da sua própria fila,
+ * e é também pelo fim que a thread as retira (as mais recentes primeiro,
+ * com os dados ainda em cache); uma thread sem trabalho rouba pelo início
+ * da fila de outra, onde estão as tarefas mais antigas. As tarefas
+ * submetidas por outras threads são distribuídas pelas filas por rotação.
+ *
+ * O mesmo escalonador recebe trabalho de granularidade muito diferente:
+ * frames inteiros (um stream, um bloco) e faixas de linhas dos kernels de
+ * um frame (parallelRows()). Enquanto uma thread processa um frame com
+ * muitas moedas, as faixas desse frame ficam na sua fila e são roubadas
+ * pelas threads que terminaram frames mais simples, o que equilibra a
+ * carga sem uma divisão fixa do trabalho.
+ *
+ * As filas são protegidas por um mutex cada (as operações são curtas e
+ * raramente disputadas) e separadas por uma linha de cache para que filas
+ * vizinhas não partilhem linhas.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "vc.h"
+
+// Tarefa em fila
+typedef struct {
+    TaskFunction fn;
+    void *arg;
+    TaskGroup *group;
+} Task;
+
+// Fila de uma thread de trabalho (o enchimento separa as filas vizinhas na cache)
+struct TaskQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+    char padding[64];
+};
+
+struct TaskGroup {
+    std::atomic<int> pending;   // Tarefas submetidas e ainda não concluídas
+};
+
+struct TaskScheduler {
+    int workers;                // Threads de trabalho criadas (pode ser 0)
+    int nqueues;                // Filas (pelo menos uma, esvaziada por waitTaskGroup() se não houver threads)
+    TaskQueue *queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued;    // Tarefas em fila, em todas as filas
+    std::atomic<unsigned> next; // Fila da próxima submissão externa
+    std::atomic<int> stop;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+};
+
+// Faixa de linhas de parallelRows()
+typedef struct {
+    RowFunction fn;
+    void *arg;
+    int y0, y1;
+} RowTask;
+
+// Escalonador e fila da thread atual (-1 = não é uma thread de trabalho)
+static thread_local TaskScheduler *currentScheduler = NULL;
+static thread_local int currentWorker = -1;
+static thread_local unsigned stealStart = 0;
+
+static int workerIndex(const TaskScheduler *sched) {
+    return (currentScheduler == sched) ? currentWorker : -1;
+}
+
+// Coloca uma tarefa numa fila e acorda uma thread parada
+static void pushTask(TaskScheduler *sched, const Task &task, int front) {
+    int q = workerIndex(sched);
+    if (q < 0) q = (int)(sched->next.fetch_add(1) % (unsigned)sched->nqueues);
+
+    task.group->pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(sched->queues[q].lock);
+        if (front) sched->queues[q].tasks.push_front(task);
+        else sched->queues[q].tasks.push_back(task);
+    }
+    sched->queued.fetch_add(1);
+
+    // O mutex garante que uma thread prestes a adormecer vê a nova tarefa
+    { std::lock_guard<std::mutex> guard(sched->sleepLock); }
+    sched->wake.notify_one();
+}
+
+// Retira da fila q a tarefa mais recente (back) ou mais antiga, só do grupo dado se group != NULL
+static int takeTask(TaskScheduler *sched, int q, TaskGroup *group, int back, Task *task) {
+    TaskQueue *queue = &sched->queues[q];
+    std::lock_guard<std::mutex> guard(queue->lock);
+
+    if (queue->tasks.empty()) return 0;
+
+    if (group == NULL) {
+        if (back) {
+            *task = queue->tasks.back();
+            queue->tasks.pop_back();
+        }
+        else {
+            *task = queue->tasks.front();
+            queue->tasks.pop_front();
+        }
+    }
+    else {
+        // Só as tarefas do grupo em espera (as filas são curtas)
+        std::deque<Task>::iterator it;
+        if (back) {
+            std::deque<Task>::reverse_iterator r = queue->tasks.rbegin();
+            while (r != queue->tasks.rend() && r->group != group) ++r;
+            if (r == queue->tasks.rend()) return 0;
+            it = --r.base();
+        }
+        else {
+            it = queue->tasks.begin();
+            while (it != queue->tasks.end() && it->group != group) ++it;
+            if (it == queue->tasks.end()) return 0;
+        }
+        *task = *it;
+        queue->tasks.erase(it);
+    }
+
+    sched->queued.fetch_sub(1);
+    return 1;
+}
+
+// Procura uma tarefa: primeiro na própria fila (pelo fim), depois nas outras (pelo início)
+static int findTask(TaskScheduler *sched, int self, TaskGroup *group, Task *task) {
+    if (self >= 0 && takeTask(sched, self, group, 1, task)) return 1;
+    if (sched->queued.load() == 0) return 0;
+
+    // A vítima inicial roda para não roubar sempre da mesma fila
+    const unsigned start = stealStart++;
+    for (int k = 0; k < sched->nqueues; k++) {
+        const int victim = (int)((start + k) % (unsigned)sched->nqueues);
+        if (victim != self && takeTask(sched, victim, group, 0, task)) return 1;
+    }
+
+    return 0;
+}
+
+static void runTask(const Task &task) {
+    task.fn(task.arg);
+    task.group->pending.fetch_sub(1);
+}
+
+// Thread de trabalho: executa tarefas até freeScheduler()
+static void workerLoop(TaskScheduler *sched, int self) {
+    currentScheduler = sched;
+    currentWorker = self;
+    stealStart = (unsigned)self + 1;
+
+    for (;;) {
+        Task task;
+        if (findTask(sched, self, NULL, &task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sched->sleepLock);
+        if (sched->stop.load()) return;
+        if (sched->queued.load() == 0)
+            sched->wake.wait_for(guard, std::chrono::milliseconds(1));
+    }
+}
+
+static void runRows(void *arg) {
+    const RowTask *band = (const RowTask *)arg;
+    band->fn(band->arg, band->y0, band->y1);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cria um escalonador com as suas threads de trabalho
+ *
+ * Se não for possível criar todas as threads, o escalonador fica com as
+ * que foram criadas; sem nenhuma, as tarefas são executadas pelas threads
+ * que esperam por elas em waitTaskGroup().
+ *
+ * @param workers Threads de trabalho (<= 0 = uma por núcleo, no máximo VC_SCHED_MAX_WORKERS)
+ * @return Ponteiro para o escalonador ou NULL em caso de erro
+ */
+TaskScheduler *createScheduler(int workers) {
+    TaskScheduler *sched;
+    int i;
+
+    if (workers <= 0) workers = VC_MAX((int)std::thread::hardware_concurrency(), 1);
+    workers = VC_MIN(workers, VC_SCHED_MAX_WORKERS);
+
+    sched = new (std::nothrow) TaskScheduler;
+    if (sched == NULL) return NULL;
+
+    sched->queues = new (std::nothrow) TaskQueue[workers];
+    if (sched->queues == NULL) {
+        delete sched;
+        return NULL;
+    }
+
+    sched->workers = 0;
+    sched->nqueues = workers;
+    sched->queued = 0;
+    sched->next = 0;
+    sched->stop = 0;
+
+    for (i = 0; i < workers; i++) {
+        try {
+            sched->threads.push_back(std::thread(workerLoop, sched, i));
+        }
+        catch (const std::system_error &e) {
+            fprintf(stderr, "Aviso: só foi possível criar %d threads de trabalho (%s)\n", i, e.what());
+            break;
+        }
+    }
+    sched->workers = (int)sched->threads.size();
+
+    return sched;
+}
+
+/**
+ * @brief Termina as threads de trabalho e liberta o escalonador
+ *
+ * Todas as tarefas submetidas já devem ter terminado (waitTaskGroup()).
+ *
+ * @param sched Ponteiro para o escalonador
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+TaskScheduler *freeScheduler(TaskScheduler *sched) {
+    if (sched != NULL) {
+        {
+            std::lock_guard<std::mutex> guard(sched->sleepLock);
+            sched->stop = 1;
+        }
+        sched->wake.notify_all();
+        for (size_t i = 0; i < sched->threads.size(); i++) sched->threads[i].join();
+
+        delete[] sched->queues;
+        delete sched;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Número de threads que executam tarefas do escalonador
+ * @param sched Ponteiro para o escalonador (NULL = execução sequencial)
+ * @return Threads de trabalho, ou 1 se não houver nenhuma
+ */
+int schedulerWorkers(const TaskScheduler *sched) {
+    return (sched != NULL && sched->workers > 0) ? sched->workers : 1;
+}
+
+/**
+ * @brief Cria um grupo de tarefas vazio
+ * @return Ponteiro para o grupo ou NULL em caso de erro
+ */
+TaskGroup *createTaskGroup(void) {
+    TaskGroup *group = new (std::nothrow) TaskGroup;
+    if (group != NULL) group->pending = 0;
+    return group;
+}
+
+/**
+ * @brief Liberta um grupo de tarefas (sem tarefas pendentes)
+ * @param group Ponteiro para o grupo
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+TaskGroup *freeTaskGroup(TaskGroup *group) {
+    delete group;
+    return NULL;
+}
+
+/**
+ * @brief Submete uma tarefa ao escalonador
+ *
+ * Numa thread de trabalho a tarefa entra no fim da própria fila e é a
+ * próxima a ser executada por essa thread; nas outras threads é colocada
+ * numa fila escolhida por rotação.
+ *
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a que a tarefa pertence
+ * @param fn Função da tarefa
+ * @param arg Argumento passado a fn
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int submitTask(TaskScheduler *sched, TaskGroup *group, TaskFunction fn, void *arg) {
+    if (!sched || !group || !fn) return 0;
+
+    Task task = { fn, arg, group };
+    pushTask(sched, task, 0);
+    return 1;
+}
+
+/**
+ * @brief Submete uma tarefa para depois das que já estão na fila
+ *
+ * Numa thread de trabalho a tarefa entra no início da própria fila: a
+ * thread só volta a ela depois das restantes e é a primeira a ser roubada.
+ * Serve para tarefas que se voltam a submeter (um stream que processa um
+ * frame de cada vez) sem passarem à frente das outras.
+ *
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a que a tarefa pertence
+ * @param fn Função da tarefa
+ * @param arg Argumento passado a fn
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int deferTask(TaskScheduler *sched, TaskGroup *group, TaskFunction fn, void *arg) {
+    if (!sched || !group || !fn) return 0;
+
+    Task task = { fn, arg, group };
+    pushTask(sched, task, 1);
+    return 1;
+}
+
+/**
+ * @brief Espera que todas as tarefas de um grupo terminem
+ *
+ * Enquanto espera, a thread executa as tarefas do próprio grupo que ainda
+ * estejam em fila (e só essas, para que a espera não se prolongue com
+ * trabalho alheio).
+ *
+ * @param sched Ponteiro para o escalonador
+ * @param group Grupo a esperar
+ */
+void waitTaskGroup(TaskScheduler *sched, TaskGroup *group) {
+    const int self = workerIndex(sched);
+    int idle = 0;
+
+    if (!sched || !group) return;
+
+    while (group->pending.load() > 0) {
+        Task task;
+        if (findTask(sched, self, group, &task)) {
+            runTask(task);
+            idle = 0;
+        }
+        else if (++idle < 64) {
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+/**
+ * @brief Executa fn sobre as linhas [0, height) em faixas paralelas
+ *
+ * Divide as linhas em faixas de pelo menos minRows linhas (no máximo
+ * VC_SCHED_MAX_BANDS), submete-as ao escalonador, executa a primeira na
+ * thread atual e espera pelas restantes. Sem escalonador, ou com imagens
+ * pequenas, chama fn(arg, 0, height) diretamente. As faixas têm de poder
+ * ser calculadas em qualquer ordem.
+ *
+ * @param sched Ponteiro para o escalonador (NULL = sequencial)
+ * @param height Número de linhas
+ * @param minRows Linhas mínimas de cada faixa
+ * @param fn Função que processa as linhas [y0, y1)
+ * @param arg Argumento passado a fn
+ */
+void parallelRows(TaskScheduler *sched, int height, int minRows, RowFunction fn, void *arg) {
+    RowTask bands[VC_SCHED_MAX_BANDS];
+    TaskGroup group;
+    int nbands, b;
+
+    if (height <= 0) return;
+
+    // Threads que podem executar faixas: as de trabalho e a atual, se não for uma delas
+    const int threads = (sched != NULL) ? sched->workers + (workerIndex(sched) < 0 ? 1 : 0) : 1;
+    nbands = VC_MIN(height / VC_MAX(minRows, 1), VC_MIN(4 * threads, VC_SCHED_MAX_BANDS));
+
+    if (threads < 2 || nbands < 2) {
+        fn(arg, 0, height);
+        return;
+    }
+
+    group.pending = 0;
+    for (b = 0; b < nbands; b++) {
+        bands[b].fn = fn;
+        bands[b].arg = arg;
+        bands[b].y0 = (int)((long long)height * b / nbands);
+        bands[b].y1 = (int)((long long)height * (b + 1) / nbands);
+    }
+
+    // Por ordem inversa: a faixa 1 fica no fim da fila e esta thread retoma-as por ordem
+    for (b = nbands - 1; b >= 1; b--) {
+        Task task = { runRows, &bands[b], &group };
+        pushTask(sched, task, 0);
+    }
+
+    runRows(&bands[0]);
+    waitTaskGroup(sched, &group);
+}
+
+#ifdef __cplusplus
+}
+#endif
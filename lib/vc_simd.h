@@ -0,0 +1,28 @@
+/**
+ * @file vc_simd.h
+ * @brief Seleção das extensões SIMD disponíveis em tempo de compilação.
+ *
+ * Ficheiro interno da biblioteca. Inclui os cabeçalhos de intrínsecos do
+ * compilador e define macros VC_SIMD_* que os kernels usam para escolher
+ * entre a versão vetorizada e a versão escalar equivalente.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#ifndef VC_SIMD_H
+#define VC_SIMD_H
+
+// SSE2 faz parte da base x86-64, por isso está quase sempre disponível
+#if defined(__SSE2__) || defined(_M_X64)
+#define VC_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// SSSE3 (pshufb) só existe quando o compilador o ativa (-mssse3 / -march=native)
+#if defined(VC_SIMD_SSE2) && defined(__SSSE3__)
+#define VC_SIMD_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#endif // VC_SIMD_H
@@ -0,0 +1,221 @@
+/**
+ * @file vc_spatial.cpp
+ * @brief Índice espacial em grelha uniforme para pontos identificados por inteiros.
+ *
+ * Este ficheiro implementa uma grelha uniforme (spatial hash) usada pelo
+ * rastreador para encontrar moedas e pontos de exclusão próximos de uma
+ * posição sem percorrer todas as entradas. Cada célula guarda uma lista
+ * duplamente ligada de identificadores, pelo que inserir, mover e remover
+ * são operações de custo constante.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Coluna/linha da célula de uma coordenada, presa aos limites da grelha
+static inline int gridCoord(int v, int cellSize, int n) {
+    if (v < 0) return 0;
+    v /= cellSize;
+    return (v >= n) ? n - 1 : v;
+}
+
+/**
+ * @brief Cria uma grelha espacial para uma área width x height
+ *
+ * Pontos fora da área são guardados nas células da borda, por isso as
+ * consultas continuam corretas para qualquer coordenada.
+ *
+ * @param width Largura da área coberta
+ * @param height Altura da área coberta
+ * @param cellSize Lado de cada célula (idealmente o maior raio de pesquisa)
+ * @param capacity Número de identificadores (0 a capacity-1)
+ * @return Ponteiro para a grelha ou NULL em caso de erro
+ */
+SpatialGrid *createGrid(int width, int height, int cellSize, int capacity) {
+    SpatialGrid *grid;
+
+    if (width <= 0 || height <= 0 || cellSize <= 0 || capacity <= 0) return NULL;
+
+    grid = (SpatialGrid *)calloc(1, sizeof(SpatialGrid));
+    if (grid == NULL) return NULL;
+
+    grid->cellSize = cellSize;
+    grid->cols = (width + cellSize - 1) / cellSize;
+    grid->rows = (height + cellSize - 1) / cellSize;
+    grid->capacity = capacity;
+
+    grid->cellHead = (int *)malloc(grid->cols * grid->rows * sizeof(int));
+    grid->next = (int *)malloc(capacity * sizeof(int));
+    grid->prev = (int *)malloc(capacity * sizeof(int));
+    grid->itemCell = (int *)malloc(capacity * sizeof(int));
+
+    if (!grid->cellHead || !grid->next || !grid->prev || !grid->itemCell)
+        return freeGrid(grid);
+
+    gridClear(grid);
+    return grid;
+}
+
+/**
+ * @brief Liberta a memória de uma grelha espacial
+ * @param grid Ponteiro para a grelha
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+SpatialGrid *freeGrid(SpatialGrid *grid) {
+    if (grid != NULL) {
+        if (grid->cellHead) free(grid->cellHead);
+        if (grid->next) free(grid->next);
+        if (grid->prev) free(grid->prev);
+        if (grid->itemCell) free(grid->itemCell);
+        free(grid);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Altera o número de identificadores suportados pela grelha
+ *
+ * Os identificadores que deixam de caber (id >= capacity) são removidos;
+ * os restantes mantêm a sua posição.
+ *
+ * @param grid Ponteiro para a grelha
+ * @param capacity Nova capacidade
+ * @return 1 em caso de sucesso, 0 em caso de erro (a grelha fica inalterada)
+ */
+int gridReserve(SpatialGrid *grid, int capacity) {
+    int id;
+
+    if (capacity <= 0) return 0;
+    if (capacity == grid->capacity) return 1;
+
+    for (id = capacity; id < grid->capacity; id++) {
+        gridRemove(grid, id);
+    }
+
+    int *next = (int *)realloc(grid->next, capacity * sizeof(int));
+    if (next == NULL) return 0;
+    grid->next = next;
+
+    int *prev = (int *)realloc(grid->prev, capacity * sizeof(int));
+    if (prev == NULL) return 0;
+    grid->prev = prev;
+
+    int *itemCell = (int *)realloc(grid->itemCell, capacity * sizeof(int));
+    if (itemCell == NULL) return 0;
+    grid->itemCell = itemCell;
+
+    for (id = grid->capacity; id < capacity; id++) {
+        grid->itemCell[id] = -1;
+    }
+    grid->capacity = capacity;
+
+    return 1;
+}
+
+/**
+ * @brief Remove todos os identificadores da grelha
+ * @param grid Ponteiro para a grelha
+ */
+void gridClear(SpatialGrid *grid) {
+    memset(grid->cellHead, 0xFF, grid->cols * grid->rows * sizeof(int));
+    memset(grid->itemCell, 0xFF, grid->capacity * sizeof(int));
+}
+
+/**
+ * @brief Remove um identificador da grelha (não faz nada se não estiver inserido)
+ * @param grid Ponteiro para a grelha
+ * @param id Identificador a remover
+ */
+void gridRemove(SpatialGrid *grid, int id) {
+    int cell;
+
+    if (id < 0 || id >= grid->capacity) return;
+    if ((cell = grid->itemCell[id]) < 0) return;
+
+    if (grid->prev[id] >= 0)
+        grid->next[grid->prev[id]] = grid->next[id];
+    else
+        grid->cellHead[cell] = grid->next[id];
+
+    if (grid->next[id] >= 0)
+        grid->prev[grid->next[id]] = grid->prev[id];
+
+    grid->itemCell[id] = -1;
+}
+
+/**
+ * @brief Insere um identificador na posição (x, y), ou move-o se já existir
+ * @param grid Ponteiro para a grelha
+ * @param id Identificador (0 a capacity-1)
+ * @param x Coordenada X
+ * @param y Coordenada Y
+ */
+void gridInsert(SpatialGrid *grid, int id, int x, int y) {
+    int cell;
+
+    if (id < 0 || id >= grid->capacity) return;
+
+    cell = gridCoord(y, grid->cellSize, grid->rows) * grid->cols + gridCoord(x, grid->cellSize, grid->cols);
+
+    // Movimento dentro da mesma célula não altera as listas
+    if (grid->itemCell[id] == cell) return;
+
+    gridRemove(grid, id);
+
+    grid->prev[id] = -1;
+    grid->next[id] = grid->cellHead[cell];
+    if (grid->cellHead[cell] >= 0)
+        grid->prev[grid->cellHead[cell]] = id;
+    grid->cellHead[cell] = id;
+    grid->itemCell[id] = cell;
+}
+
+/**
+ * @brief Lista os identificadores candidatos a estar a menos de radius de (x, y)
+ *
+ * Devolve todos os identificadores das células que intersetam o quadrado
+ * [x - radius, x + radius] x [y - radius, y + radius]. O chamador deve
+ * confirmar a distância exata; com cellSize >= radius são no máximo 3x3
+ * células.
+ *
+ * @param grid Ponteiro para a grelha
+ * @param x Coordenada X do centro da pesquisa
+ * @param y Coordenada Y do centro da pesquisa
+ * @param radius Raio de pesquisa
+ * @param out Array onde escrever os identificadores
+ * @param maxOut Tamanho de out
+ * @return Número de identificadores escritos em out
+ */
+int gridQuery(const SpatialGrid *grid, int x, int y, int radius, int *out, int maxOut) {
+    const int c0 = gridCoord(x - radius, grid->cellSize, grid->cols);
+    const int c1 = gridCoord(x + radius, grid->cellSize, grid->cols);
+    const int r0 = gridCoord(y - radius, grid->cellSize, grid->rows);
+    const int r1 = gridCoord(y + radius, grid->cellSize, grid->rows);
+    int r, c, id, n = 0;
+
+    for (r = r0; r <= r1; r++) {
+        for (c = c0; c <= c1; c++) {
+            for (id = grid->cellHead[r * grid->cols + c]; id >= 0; id = grid->next[id]) {
+                if (n >= maxOut) return n;
+                out[n++] = id;
+            }
+        }
+    }
+
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file vc_streams.cpp
+ * @brief Processamento de várias sequências de vídeo (streams) no mesmo processo.
+ *
+ * Cada stream tem o seu próprio contexto: processador, rastreador, frames e
+ * contadores. A biblioteca não tem estado global, pelo que contextos
+ * diferentes podem ser usados ao mesmo tempo por threads diferentes. Os
+ * streams são tarefas do escalonador com roubo de trabalho
+ * (vc_scheduler.cpp): cada tarefa lê e processa o próximo frame do seu
+ * stream e volta a submeter-se atrás dos streams já prontos. Cada stream
+ * tem no máximo uma tarefa em fila, o que garante que os seus frames são
+ * processados por ordem e nunca por duas threads ao mesmo tempo; as faixas
+ * de linhas da segmentação entram no mesmo escalonador e ocupam as
+ * threads que ficam sem stream.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "vc.h"
+
+typedef std::chrono::steady_clock StreamClock;
+
+typedef struct StreamRun StreamRun;
+
+// Tarefa de um stream: processa um frame e volta a submeter-se
+typedef struct {
+    StreamRun *run;
+    int index;
+} StreamTask;
+
+// Estado partilhado pelas tarefas dos streams
+struct StreamRun {
+    VideoStream **streams;
+    TaskScheduler *sched;
+    TaskGroup *group;
+    StreamTask *tasks;
+    double *readyAt;            // Instante em que cada stream ficou pronto para o próximo frame
+    StreamClock::time_point start;
+};
+
+static double secondsSince(StreamClock::time_point start) {
+    return std::chrono::duration<double>(StreamClock::now() - start).count();
+}
+
+// Lê e processa o próximo frame do stream; devolve 0 no fim da sequência
+static int processStreamFrame(StreamRun *run, int index) {
+    VideoStream *stream = run->streams[index];
+    const StreamClock::time_point begin = StreamClock::now();
+    long long timestampMs = -1;
+
+    if (!stream->read(stream->source, stream->frame, &timestampMs)) {
+        stream->seconds = secondsSince(run->start);
+        return 0;
+    }
+
+    // frame2 só é atualizado a cada VC_FRAME2_INTERVAL frames, como no modo sequencial
+    if (stream->frames % VC_FRAME2_INTERVAL == 0)
+        memcpy(stream->frame2->data, stream->frame->data, stream->frame->bytesperline * stream->frame->height);
+
+    processFrameAt(stream->proc, stream->frame, stream->frame2, stream->coinCounts, timestampMs);
+    stream->frames++;
+
+    const double now = secondsSince(run->start);
+    const double latency = now - run->readyAt[index];
+    stream->busySeconds += std::chrono::duration<double>(StreamClock::now() - begin).count();
+    stream->latencySum += latency;
+    if (latency > stream->latencyMax) stream->latencyMax = latency;
+
+    return 1;
+}
+
+// Processa um frame e volta à fila atrás dos streams já prontos
+static void streamTask(void *arg) {
+    StreamTask *task = (StreamTask *)arg;
+    StreamRun *run = task->run;
+
+    if (processStreamFrame(run, task->index)) {
+        run->readyAt[task->index] = secondsSince(run->start);
+        deferTask(run->sched, run->group, streamTask, task);
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cria um stream com um processador e frames próprios
+ *
+ * O processador é criado com a configuração por omissão; a aplicação
+ * ajusta-o (denominações, calibração, cadência) e define read e source
+ * antes de chamar runStreams().
+ *
+ * @param width Largura dos frames do stream
+ * @param height Altura dos frames do stream
+ * @return Ponteiro para o stream ou NULL em caso de erro
+ */
+VideoStream *createVideoStream(int width, int height) {
+    VideoStream *stream;
+
+    if (width <= 0 || height <= 0) return NULL;
+
+    stream = (VideoStream *)calloc(1, sizeof(VideoStream));
+    if (stream == NULL) return NULL;
+
+    stream->proc = createFrameProcessor(width, height);
+    stream->frame = createImage(width, height, 3, 255);
+    stream->frame2 = createImage(width, height, 3, 255);
+
+    if (!stream->proc || !stream->frame || !stream->frame2) return freeVideoStream(stream);
+
+    return stream;
+}
+
+/**
+ * @brief Liberta um stream e o seu processador
+ * @param stream Ponteiro para o stream
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+VideoStream *freeVideoStream(VideoStream *stream) {
+    if (stream != NULL) {
+        if (stream->proc) freeFrameProcessor(stream->proc);
+        if (stream->frame) freeImage(stream->frame);
+        if (stream->frame2) freeImage(stream->frame2);
+        free(stream);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Processa vários streams ao mesmo tempo num escalonador com roubo de trabalho
+ *
+ * Cada stream é uma tarefa que processa um frame e se volta a submeter
+ * atrás dos streams já prontos, pelo que os frames de um stream são
+ * processados por ordem, um de cada vez, e as threads rodam pelos
+ * streams. Durante a execução os processadores dos streams usam o mesmo
+ * escalonador para dividir a segmentação em faixas de linhas: as threads
+ * sem stream para processar (mais threads do que streams, ou streams já
+ * terminados) roubam faixas dos frames em curso. A latência de um frame é
+ * medida desde que o stream fica pronto até o frame estar processado,
+ * incluindo a espera por uma thread livre e a leitura; seconds é o tempo
+ * desde o arranque até ao fim da sequência do stream. A thread que chama
+ * a função também executa tarefas enquanto espera.
+ *
+ * @param streams Streams a processar (com read e source definidos)
+ * @param nStreams Número de streams (1 a VC_MAX_STREAMS)
+ * @param workers Threads de trabalho (<= 0 = uma por núcleo)
+ * @return Número de threads de trabalho, ou 0 em caso de erro
+ */
+int runStreams(VideoStream **streams, int nStreams, int workers) {
+    TaskScheduler *saved[VC_MAX_STREAMS];
+    StreamRun run;
+    int i, used;
+
+    if (!streams || nStreams < 1 || nStreams > VC_MAX_STREAMS) return 0;
+    for (i = 0; i < nStreams; i++) {
+        if (!streams[i] || !streams[i]->proc || !streams[i]->read) return 0;
+    }
+
+    run.streams = streams;
+    run.sched = createScheduler(workers);
+    run.group = createTaskGroup();
+    run.tasks = (StreamTask *)calloc(nStreams, sizeof(StreamTask));
+    run.readyAt = (double *)calloc(nStreams, sizeof(double));
+
+    if (!run.sched || !run.group || !run.tasks || !run.readyAt) {
+        freeScheduler(run.sched);
+        freeTaskGroup(run.group);
+        free(run.tasks);
+        free(run.readyAt);
+        return 0;
+    }
+
+    run.start = StreamClock::now();
+    for (i = 0; i < nStreams; i++) {
+        VideoStream *stream = streams[i];
+        stream->frames = 0;
+        stream->seconds = stream->busySeconds = 0.0;
+        stream->latencySum = stream->latencyMax = 0.0;
+
+        saved[i] = stream->proc->scheduler;
+        stream->proc->scheduler = run.sched;
+
+        run.tasks[i].run = &run;
+        run.tasks[i].index = i;
+        submitTask(run.sched, run.group, streamTask, &run.tasks[i]);
+    }
+
+    waitTaskGroup(run.sched, run.group);
+
+    for (i = 0; i < nStreams; i++) streams[i]->proc->scheduler = saved[i];
+
+    used = schedulerWorkers(run.sched);
+    freeScheduler(run.sched);
+    freeTaskGroup(run.group);
+    free(run.tasks);
+    free(run.readyAt);
+
+    return used;
+}
+
+#ifdef __cplusplus
+}
+#endif
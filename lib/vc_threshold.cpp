@@ -0,0 +1,249 @@
+/**
+ * @file vc_threshold.cpp
+ * @brief Histogramas e seleção automática de limiares.
+ *
+ * Este ficheiro implementa o cálculo de histogramas, a seleção de limiar
+ * pelo método de Otsu, a limiarização local baseada na média da vizinhança
+ * (com imagem integral) e a gestão incremental dos limiares de cada máscara,
+ * que só são recalculados de N em N frames ou quando a iluminação muda.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Calcula o histograma de uma imagem de 1 canal
+ *
+ * Usa quatro sub-histogramas intercalados e lê 4 pixels de cada vez, para
+ * que incrementos consecutivos do mesmo nível (muito comuns em zonas
+ * uniformes) não fiquem à espera uns dos outros. Com step > 1 só é
+ * amostrada uma linha e uma coluna em cada step, o que serve para uma
+ * estimativa barata da distribuição.
+ *
+ * @param src Imagem de origem (1 canal)
+ * @param hist Histograma de destino com 256 posições
+ * @param step Passo de amostragem em linhas e colunas (1 = todos os pixels)
+ * @return Número de pixels amostrados, ou 0 em caso de erro
+ */
+long int computeHistogram(IVC *src, unsigned int *hist, int step) {
+    unsigned int partial[4][256];
+    const int width = src->width;
+    const int height = src->height;
+    long int count = 0;
+    int x, y, i;
+
+    if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+    if (src->channels != 1 || hist == NULL) return 0;
+    if (step < 1) step = 1;
+
+    memset(partial, 0, sizeof(partial));
+
+    for (y = 0; y < height; y += step) {
+        const unsigned char *row = src->data + (long int)y * src->bytesperline;
+
+        if (step == 1) {
+            for (x = 0; x + 4 <= width; x += 4) {
+                partial[0][row[x]]++;
+                partial[1][row[x + 1]]++;
+                partial[2][row[x + 2]]++;
+                partial[3][row[x + 3]]++;
+            }
+            for (; x < width; x++) {
+                partial[0][row[x]]++;
+            }
+            count += width;
+        }
+        else {
+            for (x = 0; x < width; x += step) {
+                partial[x & 3][row[x]]++;
+                count++;
+            }
+        }
+    }
+
+    for (i = 0; i < 256; i++) {
+        hist[i] = partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+    }
+
+    return count;
+}
+
+/**
+ * @brief Seleciona o limiar de Otsu a partir de um histograma
+ *
+ * Escolhe o limiar que maximiza a variância entre as classes "abaixo" e
+ * "acima". O valor devolvido é o primeiro nível da classe de cima, pronto a
+ * usar em gray2binary()/rgb2binary() (pixel >= limiar).
+ *
+ * @param hist Histograma com 256 posições
+ * @return Limiar entre 1 e 255, ou -1 se o histograma estiver vazio
+ */
+int otsuThreshold(const unsigned int *hist) {
+    double total = 0.0, sumAll = 0.0;
+    double weightLow = 0.0, sumLow = 0.0;
+    double bestVariance = -1.0;
+    int best = -1, t;
+
+    for (t = 0; t < 256; t++) {
+        total += hist[t];
+        sumAll += (double)t * hist[t];
+    }
+    if (total <= 0.0) return -1;
+
+    for (t = 0; t < 255; t++) {
+        weightLow += hist[t];
+        if (weightLow == 0.0) continue;
+
+        const double weightHigh = total - weightLow;
+        if (weightHigh == 0.0) break;
+
+        sumLow += (double)t * hist[t];
+
+        const double meanLow = sumLow / weightLow;
+        const double meanHigh = (sumAll - sumLow) / weightHigh;
+        const double variance = weightLow * weightHigh * (meanLow - meanHigh) * (meanLow - meanHigh);
+
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            best = t + 1;
+        }
+    }
+
+    // Imagem com um só nível: qualquer limiar acima dele serve
+    if (best < 0) {
+        for (t = 0; t < 256 && hist[t] == 0; t++);
+        best = VC_MIN(t + 1, 255);
+    }
+
+    return best;
+}
+
+/**
+ * @brief Limiarização local pela média da vizinhança
+ *
+ * Um pixel fica a 255 quando é pelo menos offset níveis mais claro do que a
+ * média da janela (2*radius+1)² à sua volta. A média vem da imagem integral,
+ * pelo que o custo por pixel não depende do raio. Para segmentar moedas a
+ * janela deve ser maior do que uma moeda, senão o interior fica a 0.
+ *
+ * @param src Imagem de origem em níveis de cinzento
+ * @param dst Imagem binária de destino
+ * @param ii Imagem integral de src (já calculada)
+ * @param radius Raio da janela
+ * @param offset Diferença mínima em relação à média
+ * @return 1 em caso de sucesso, 0 em caso de erro
+ */
+int adaptiveThreshold(IVC *src, IVC *dst, const IntegralImage *ii, int radius, int offset) {
+    int x, y;
+
+    if ((src->width <= 0) || (src->height <= 0) || (src->data == NULL)) return 0;
+    if ((src->channels != 1) || (dst->channels != 1)) return 0;
+    if ((src->width != dst->width) || (src->height != dst->height)) return 0;
+    if ((ii->width != src->width) || (ii->height != src->height)) return 0;
+    if (radius < 1) return 0;
+
+    for (y = 0; y < src->height; y++) {
+        const unsigned char *in = src->data + (long int)y * src->bytesperline;
+        unsigned char *out = dst->data + (long int)y * dst->bytesperline;
+        const int y0 = VC_MAX(y - radius, 0);
+        const int y1 = VC_MIN(y + radius + 1, src->height);
+
+        for (x = 0; x < src->width; x++) {
+            const int x0 = VC_MAX(x - radius, 0);
+            const int x1 = VC_MIN(x + radius + 1, src->width);
+            const long long area = (long long)(x1 - x0) * (y1 - y0);
+            const long long sum = (long long)integralSum(ii, x0, y0, x1 - x0, y1 - y0);
+
+            // in >= media + offset, sem divisões
+            out[x] = ((long long)(in[x] - offset) * area >= sum) ? 255 : 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Inicializa o seletor de limiar de uma máscara
+ *
+ * Por omissão o limiar automático é recalculado de 30 em 30 frames, ou
+ * antes disso se a média amostrada da imagem variar mais de 8 níveis. A
+ * janela local usa um raio de 1/8 do maior lado da imagem.
+ *
+ * @param sel Seletor a inicializar
+ * @param mode VC_THRESH_FIXED, VC_THRESH_OTSU ou VC_THRESH_LOCAL
+ * @param value Limiar fixo (e valor inicial dos restantes modos)
+ */
+void initThreshold(ThresholdSelector *sel, int mode, int value) {
+    memset(sel, 0, sizeof(ThresholdSelector));
+    sel->mode = mode;
+    sel->value = value;
+    sel->interval = 30;
+    sel->driftTolerance = 8.0f;
+    sel->localRadius = 0;
+    sel->localOffset = 10;
+    sel->framesSinceUpdate = -1; // Força o cálculo no primeiro frame
+    sel->lastMean = -1.0f;
+}
+
+/**
+ * @brief Atualiza o limiar automático com a imagem do frame atual
+ *
+ * Deve ser chamada uma vez por frame. No modo Otsu o histograma completo só
+ * é calculado quando passaram sel->interval frames desde a última vez, ou
+ * quando a média de uma amostra esparsa (1 em cada 64 pixels) se afastou
+ * mais de sel->driftTolerance do valor da última atualização.
+ *
+ * @param sel Seletor de limiar
+ * @param gray Imagem em níveis de cinzento do frame atual
+ * @return Limiar global em vigor
+ */
+int updateThreshold(ThresholdSelector *sel, IVC *gray) {
+    unsigned int hist[256];
+    long int n;
+    int i, recompute;
+
+    if (sel->mode != VC_THRESH_OTSU)
+        return sel->value;
+
+    recompute = (sel->framesSinceUpdate < 0) || (++sel->framesSinceUpdate >= sel->interval);
+
+    if (!recompute) {
+        // Estimativa barata da iluminação para detetar mudanças bruscas
+        double sum = 0.0;
+        n = computeHistogram(gray, hist, 8);
+        for (i = 0; i < 256; i++) sum += (double)i * hist[i];
+
+        if (n > 0 && fabs(sum / n - sel->lastMean) > sel->driftTolerance)
+            recompute = 1;
+    }
+
+    if (recompute) {
+        double sum = 0.0;
+        n = computeHistogram(gray, hist, 1);
+        const int t = otsuThreshold(hist);
+        if (t > 0) sel->value = t;
+
+        // A média de referência usa a mesma amostragem do teste de deriva
+        n = computeHistogram(gray, hist, 8);
+        for (i = 0; i < 256; i++) sum += (double)i * hist[i];
+        sel->lastMean = (n > 0) ? (float)(sum / n) : 0.0f;
+        sel->framesSinceUpdate = 0;
+    }
+
+    return sel->value;
+}
+
+#ifdef __cplusplus
+}
+#endif
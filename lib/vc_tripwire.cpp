@@ -0,0 +1,336 @@
+/**
+ * @file vc_tripwire.cpp
+ * @brief Contagem de moedas pela passagem numa linha fixa (tapetes).
+ *
+ * Num tapete as moedas atravessam sempre a mesma linha da imagem, pelo que
+ * não é preciso seguir cada moeda em todo o frame: basta segmentar uma
+ * banda de linhas à volta da linha de contagem e contar cada moeda quando
+ * o centro do seu blob passa para o outro lado. A linha é dividida em
+ * pistas com a largura da maior moeda. Cada pista segue as poucas moedas
+ * que estão na banda só pela última posição e pelos votos das
+ * denominações das suas deteções; a moeda é contada uma vez, com a
+ * denominação mais votada. Durante alguns frames (debounce) não se conta
+ * outra passagem junto do sítio de uma passagem contada, para que uma
+ * moeda partida em dois blobs não seja contada duas vezes.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pista da coluna x
+static int laneOf(const Tripwire *tw, int x) {
+    return VC_MIN(VC_MAX(x, 0) / tw->laneWidth, tw->nLanes - 1);
+}
+
+// 1 se a deteção pode ser contada: denominação conhecida ou só posição (tipo 0)
+static int usableDetection(const CoinSpecTable *specs, const CoinDetection *d) {
+    return d->type == 0 || getCoinSpec(specs, d->type) != NULL;
+}
+
+// Associa as deteções às moedas seguidas na pista da coluna do seu centro e
+// nas vizinhas, a menos de meia pista na horizontal e de uma pista na
+// vertical, dos pares mais próximos para os mais afastados; cada moeda
+// recebe no máximo uma deteção. O índice da moeda (pista *
+// VC_TRIP_LANE_COINS + posição) fica em track, -1 se não houver
+static void assignCoins(Tripwire *tw, CoinTracker *tracker, long long frame) {
+    const int reachX = tw->laneWidth / 2, reachY = tw->laneWidth;
+    int i, l, k;
+
+    for (i = 0; i < tracker->nPending; i++) tracker->pending[i].track = -1;
+
+    for (;;) {
+        int bestDetection = -1, bestCoin = -1, bestDist = 0;
+
+        for (i = 0; i < tracker->nPending; i++) {
+            const CoinDetection *d = &tracker->pending[i];
+            if (d->track >= 0 || !usableDetection(&tracker->specs, d)) continue;
+
+            const int lane = laneOf(tw, d->x);
+            for (l = VC_MAX(lane - 1, 0); l <= VC_MIN(lane + 1, tw->nLanes - 1); l++) {
+                for (k = 0; k < VC_TRIP_LANE_COINS; k++) {
+                    const TripCoin *coin = &tw->lanes[l].coins[k];
+                    if (coin->lastFrame <= 0 || frame - coin->lastFrame > VC_TRIP_LANE_MEMORY ||
+                        coin->assignedFrame == frame)
+                        continue;
+
+                    const int dx = coin->x - d->x, dy = coin->y - d->y;
+                    if (dx > reachX || -dx > reachX || dy > reachY || -dy > reachY) continue;
+
+                    if (bestDetection < 0 || dx*dx + dy*dy < bestDist) {
+                        bestDetection = i;
+                        bestCoin = l * VC_TRIP_LANE_COINS + k;
+                        bestDist = dx*dx + dy*dy;
+                    }
+                }
+            }
+        }
+
+        if (bestDetection < 0) break;
+
+        tracker->pending[bestDetection].track = bestCoin;
+        tw->lanes[bestCoin / VC_TRIP_LANE_COINS].coins[bestCoin % VC_TRIP_LANE_COINS].assignedFrame = frame;
+    }
+}
+
+// 1 se a passagem em (x, y) está a menos do espaçamento das moedas de outra
+// contada há debounce frames ou menos, na pista ou nas vizinhas
+static int recentCrossing(const Tripwire *tw, int lane, int x, int y, long long frame) {
+    const int spacingSq = tw->coinSpacing * tw->coinSpacing;
+
+    for (int l = VC_MAX(lane - 1, 0); l <= VC_MIN(lane + 1, tw->nLanes - 1); l++) {
+        const TripLane *other = &tw->lanes[l];
+        if (other->countFrame <= 0 || frame - other->countFrame > tw->debounce) continue;
+
+        const int dx = other->countX - x, dy = other->countY - y;
+        if (dx*dx + dy*dy < spacingSq) return 1;
+    }
+
+    return 0;
+}
+
+// Entrada livre (ou a mais antiga) de uma pista para uma moeda nova, fora
+// das que já receberam uma deteção neste frame; NULL se não houver
+static TripCoin *newCoin(TripLane *lane, int x, int y, long long frame) {
+    TripCoin *coin = NULL;
+
+    for (int k = 0; k < VC_TRIP_LANE_COINS; k++) {
+        TripCoin *entry = &lane->coins[k];
+        if (entry->assignedFrame == frame) continue;
+        if (coin == NULL || entry->lastFrame < coin->lastFrame) coin = entry;
+    }
+    if (coin == NULL) return NULL;
+
+    memset(coin, 0, sizeof(TripCoin));
+    coin->x = x;
+    coin->y = y;
+    coin->assignedFrame = frame;
+    return coin;
+}
+
+/**
+ * @brief Cria uma linha de contagem
+ *
+ * A banda é automática (VC_TRIP_BAND_FACTOR diâmetros da maior moeda para
+ * cada lado) e o debounce é de VC_TRIP_DEBOUNCE frames.
+ *
+ * @param width Largura dos frames
+ * @param height Altura dos frames
+ * @param y Linha de contagem (0 a height-1)
+ * @return Ponteiro para a linha ou NULL em caso de erro
+ */
+Tripwire *createTripwire(int width, int height, int y) {
+    Tripwire *tw;
+
+    if (width <= 0 || height <= 0 || y < 0 || y >= height) return NULL;
+
+    tw = (Tripwire *)calloc(1, sizeof(Tripwire));
+    if (tw == NULL) return NULL;
+
+    tw->width = width;
+    tw->height = height;
+    tw->y = y;
+    tw->halfBand = 0;
+    tw->debounce = VC_TRIP_DEBOUNCE;
+
+    return tw;
+}
+
+/**
+ * @brief Liberta uma linha de contagem
+ * @param tw Ponteiro para a linha
+ * @return NULL sempre, para facilitar a atribuição após libertação
+ */
+Tripwire *freeTripwire(Tripwire *tw) {
+    if (tw != NULL) free(tw);
+
+    return NULL;
+}
+
+/**
+ * @brief Calcula a banda a segmentar e a largura das pistas
+ *
+ * A banda ocupa toda a largura do frame e tw->halfBand linhas para cada
+ * lado da linha ou, se for automática, VC_TRIP_BAND_FACTOR vezes o
+ * diâmetro da maior denominação: uma moeda com o centro sobre a linha cabe
+ * inteira na banda e continua inteira durante alguns frames antes e depois
+ * de a passar. Uma moeda de diâmetro d está inteira na banda enquanto o
+ * centro está a menos de halfBand - d/2 da linha, pelo que é sempre vista
+ * inteira (e contada) até cerca de 2 * halfBand - d pixels por frame: meia
+ * moeda por frame para a maior, com a banda automática. As pistas têm a
+ * largura da maior denominação (no mínimo a que divide o frame em
+ * VC_TRIP_MAX_LANES pistas). Como depende das denominações, a banda
+ * acompanha a calibração da escala. O espaçamento das moedas é o diâmetro
+ * da menor denominação: os centros de duas moedas distintas nunca estão
+ * mais próximos.
+ *
+ * @param tw Linha de contagem
+ * @param specs Denominações à escala dos frames
+ * @return Banda a segmentar (também em tw->band)
+ */
+ImageRegion tripwireBand(Tripwire *tw, const CoinSpecTable *specs) {
+    float largest = 0.0f, smallest = 0.0f;
+    int i;
+
+    for (i = 0; i < specs->nSpecs; i++) {
+        const float diameter = specs->specs[i].diameter;
+        if (diameter > largest) largest = diameter;
+        if (diameter > 0.0f && (smallest <= 0.0f || diameter < smallest)) smallest = diameter;
+    }
+    if (largest <= 0.0f) largest = smallest = VC_ROI_DEFAULT_DIAMETER;
+
+    const int half = (tw->halfBand > 0) ? tw->halfBand : (int)(VC_TRIP_BAND_FACTOR * largest + 0.5f);
+    const int y0 = VC_MAX(0, tw->y - half);
+    const int y1 = VC_MIN(tw->height, tw->y + half + 1);
+
+    tw->laneWidth = VC_MAX((int)(largest + 0.5f), (tw->width + VC_TRIP_MAX_LANES - 1) / VC_TRIP_MAX_LANES);
+    tw->nLanes = VC_MIN((tw->width + tw->laneWidth - 1) / tw->laneWidth, VC_TRIP_MAX_LANES);
+    tw->coinSpacing = (int)(smallest + 0.5f);
+
+    tw->band.x = 0;
+    tw->band.y = y0;
+    tw->band.width = tw->width;
+    tw->band.height = y1 - y0;
+
+    return tw->band;
+}
+
+/**
+ * @brief Verifica se um blob foi cortado pela banda
+ *
+ * Só os limites da banda que não são bordas do frame cortam as moedas. A
+ * área e o diâmetro de um blob cortado não são os da moeda, mas, com a
+ * banda a cobrir pelo menos meia moeda para cada lado da linha (como a
+ * automática), o seu centro fica do mesmo lado da linha que o da moeda.
+ */
+int tripwireCut(const Tripwire *tw, const OVC *blob) {
+    const int bottom = tw->band.y + tw->band.height;
+
+    return (tw->band.y > 0 && blob->y <= tw->band.y + 1) ||
+           (bottom < tw->height && blob->y + blob->height >= bottom - 1);
+}
+
+/**
+ * @brief Conta as moedas que passaram a linha no frame atual
+ *
+ * Consome as deteções em fila no rastreador (addDetection()) em vez de
+ * commitDetections(). As deteções são associadas às moedas seguidas na
+ * pista da coluna do seu centro ou nas vizinhas, a menos de meia pista na
+ * horizontal e de uma pista na vertical, dos pares mais próximos para os
+ * mais afastados; sem moeda próxima começa uma moeda nova. Moedas sem
+ * deteções há mais de VC_TRIP_LANE_MEMORY frames são esquecidas. Cada
+ * deteção vota na sua denominação com o seu peso; as de tipo 0 (blobs
+ * cortados pela banda, ver tripwireCut()) só dão a posição. Quando o
+ * centro de uma moeda passa para o outro lado da linha, a moeda é contada
+ * com a denominação mais votada logo que tenha um voto, exceto se outra
+ * passagem foi contada há tw->debounce frames ou menos a menos de
+ * tw->coinSpacing do seu centro, na mesma pista ou numa vizinha (é a mesma
+ * moeda, partida em dois blobs; duas moedas distintas nunca estão tão
+ * próximas). Uma moeda contada que volta a atravessar a linha não é
+ * contada de novo.
+ *
+ * @param tw Linha de contagem
+ * @param tracker Rastreador com as deteções do frame
+ * @param counters Contadores por tipo, atualizados com as moedas contadas
+ * @return Moedas contadas neste frame
+ */
+int crossTripwire(Tripwire *tw, CoinTracker *tracker, int *counters) {
+    const CoinSpecTable *specs = &tracker->specs;
+    const long long frame = tracker->frameIndex;
+    int i, k, counted = 0;
+
+    if (tw->laneWidth <= 0) tripwireBand(tw, specs);
+
+    assignCoins(tw, tracker, frame);
+
+    for (i = 0; i < tracker->nPending; i++) {
+        const CoinDetection *d = &tracker->pending[i];
+        if (!usableDetection(specs, d)) continue;
+
+        TripLane *lane;
+        TripCoin *coin;
+        if (d->track >= 0) {
+            lane = &tw->lanes[d->track / VC_TRIP_LANE_COINS];
+            coin = &lane->coins[d->track % VC_TRIP_LANE_COINS];
+        }
+        else {
+            lane = &tw->lanes[laneOf(tw, d->x)];
+            if ((coin = newCoin(lane, d->x, d->y, frame)) == NULL) continue;
+        }
+
+        if (coin->lastFrame > 0 && (coin->y < tw->y) != (d->y < tw->y)) coin->crossed = 1;
+        if (d->type > 0) coin->votes[d->type - 1] += d->weight;
+        coin->x = d->x;
+        coin->y = d->y;
+        coin->lastFrame = frame;
+
+        if (!coin->crossed || coin->counted) continue;
+
+        // Sem nenhuma deteção completa a denominação ainda não é conhecida
+        int best = (d->type > 0) ? d->type - 1 : 0;
+        for (k = 0; k < specs->nSpecs; k++) {
+            if (coin->votes[k] > coin->votes[best]) best = k;
+        }
+        if (coin->votes[best] <= 0.0f) continue;
+        coin->counted = 1;
+
+        // Uma segunda passagem logo a seguir e no mesmo sítio é a mesma moeda, partida em dois blobs
+        if (recentCrossing(tw, (int)(lane - tw->lanes), d->x, d->y, frame)) continue;
+
+        lane->countFrame = frame;
+        lane->countX = d->x;
+        lane->countY = d->y;
+        tracker->countedByType[best]++;
+        if (counters != NULL) counters[best]++;
+        tw->crossings++;
+        counted++;
+
+        if (tracker->verbose) {
+            printf("[MOEDA] %s | Diâm: %.1f | Área: %d | Circularidade: %.2f\n",
+                   specs->specs[best].label, d->diameter, d->area, d->circularity);
+        }
+    }
+
+    tracker->nPending = 0;
+    return counted;
+}
+
+/**
+ * @brief Desenha a linha de contagem (vermelha) e os limites da banda (amarelos)
+ * @param tw Linha de contagem
+ * @param frame Frame BGR com as dimensões da linha
+ */
+void drawTripwire(const Tripwire *tw, IVC *frame) {
+    static const unsigned char LINE[3] = { 0, 0, 255 };
+    static const unsigned char EDGE[3] = { 0, 255, 255 };
+    const int rows[3] = { tw->y, tw->band.y, tw->band.y + tw->band.height - 1 };
+    int r, x;
+
+    if (frame == NULL || frame->channels != 3 || frame->width != tw->width || frame->height != tw->height)
+        return;
+
+    for (r = 0; r < 3; r++) {
+        if (rows[r] < 0 || rows[r] >= frame->height || (r > 0 && tw->band.height <= 0)) continue;
+
+        const unsigned char *colour = (r == 0) ? LINE : EDGE;
+        unsigned char *p = frame->data + (long int)rows[r] * frame->bytesperline;
+        for (x = 0; x < frame->width; x++, p += 3) {
+            p[0] = colour[0];
+            p[1] = colour[1];
+            p[2] = colour[2];
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
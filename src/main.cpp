@@ -16,6 +16,9 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <vector>
 #include <opencv2/opencv.hpp>
 
 extern "C" {
@@ -49,24 +52,574 @@ void timer(void) {
     }
 }
 
-int main(void) {
-    // Lista de exclusão para moedas que não devem ser contadas
-    int excludeList[MAX_COINS * 2] = {0};
-    // Contadores de moedas: 1c, 2c, 5c, 10c, 20c, 50c, 1€, 2€
-    int coinCounts[8] = {0};
+// Opções da linha de comandos
+typedef struct {
+    std::string input;      // Vídeo de entrada
+    std::vector<std::string> streams; // Vídeos processados em simultâneo (mais de um = modo multi-stream)
+    bool headless;          // Sem janela (sem chamadas ao highgui)
+    int calibrationFrames;  // Frames para calibrar a escala (0 = sem calibração)
+    bool coarse;            // Segmenta na pirâmide e refina só à volta dos blobs grosseiros
+    int thresholdMode[VC_NUM_MASKS];   // Modo de limiar de cada máscara (VC_THRESH_*)
+    int thresholdRadius[VC_NUM_MASKS]; // Raio da janela do limiar local (0 = automático)
+    int roiInterval;        // Frames entre passagens completas com as ROIs previstas (0 = todos completos)
+    int entryRows;          // Faixa de entrada das ROIs previstas (> 0 primeiras linhas, < 0 últimas)
+    bool pipeline;          // Leitura, segmentação, análise e visualização em threads separadas
+    int workers;            // Threads de segmentação (pipeline) ou de trabalho (multi-stream); 0 = por omissão
+    int chunks;             // Blocos processados em paralelo (0 = sem divisão)
+    int overlap;            // Frames de sobreposição entre blocos
+    float motion;           // Limiar do detetor de movimento (0 = processa todos os frames)
+    int maxSkip;            // Máximo de frames seguidos saltados pelo detetor de movimento
+    float background;       // Taxa de aprendizagem do modelo de fundo (0 = segmenta o frame completo)
+    int bgThreshold;        // Diferença para o modelo que torna uma amostra primeiro plano
+    int tripwire;           // Linha de contagem (-1 = rastreamento em todo o frame)
+    int tripwireBand;       // Meia altura da banda à volta da linha (0 = automática)
+    int debounce;           // Frames em que uma passagem junto de outra já contada não conta
+} Options;
+
+// Estado partilhado pelos estágios de leitura e visualização do modo pipeline
+typedef struct {
+    cv::VideoCapture *capture;
+    int width, height;
+    bool headless;
+} VideoStages;
+
+// Descodifica o próximo frame diretamente para a memória de image (sem cópias
+// intermédias, salvo se o vídeo não vier em BGR de 8 bits com as dimensões esperadas)
+static bool readInto(cv::VideoCapture *capture, IVC *image) {
+    cv::Mat view(image->height, image->width, CV_8UC3, image->data);
+    
+    if (!capture->read(view)) return false;
+    
+    if (view.data != image->data) {
+        if (view.rows != image->height || view.cols != image->width || view.channels() != 3) return false;
+        for (int y = 0; y < image->height; y++) {
+            memcpy(image->data + y * image->bytesperline, view.ptr(y), image->width * 3);
+        }
+    }
+    
+    return true;
+}
+
+// Estágio de leitura: descodifica para o slot (o frame2 é tratado pelo pipeline)
+static int readStage(void *user, FrameSlot *slot) {
+    VideoStages *video = (VideoStages *)user;
+    
+    if (!readInto(video->capture, slot->frame)) return 0;
+    slot->timestampMs = (long long)video->capture->get(cv::CAP_PROP_POS_MSEC);
+    
+    return 1;
+}
+
+// Leitura independente do modo por blocos (lida com readCapture())
+static void *openChunk(void *user, long long firstFrame) {
+    const std::string *input = (const std::string *)user;
+    cv::VideoCapture *capture = new cv::VideoCapture(*input);
+    
+    if (!capture->isOpened()) {
+        delete capture;
+        return NULL;
+    }
+    
+    // Se o posicionamento não for exato, lê desde o início e descarta os frames anteriores
+    if (firstFrame > 0) {
+        capture->set(cv::CAP_PROP_POS_FRAMES, (double)firstFrame);
+        if ((long long)capture->get(cv::CAP_PROP_POS_FRAMES) != firstFrame) {
+            capture->open(*input);
+            for (long long i = 0; i < firstFrame && capture->grab(); i++) {}
+        }
+    }
+    
+    return capture;
+}
+
+// Lê o próximo frame de uma leitura aberta (modos por blocos e multi-stream)
+static int readCapture(void *stream, IVC *frame, long long *timestampMs) {
+    cv::VideoCapture *capture = (cv::VideoCapture *)stream;
+    
+    if (!readInto(capture, frame)) return 0;
+    *timestampMs = (long long)capture->get(cv::CAP_PROP_POS_MSEC);
+    
+    return 1;
+}
+
+static void closeChunk(void *stream) {
+    delete (cv::VideoCapture *)stream;
+}
+
+// Estágio de visualização (thread principal); devolve 0 quando se prime 'q'
+static int renderStage(void *user, FrameSlot *slot) {
+    VideoStages *video = (VideoStages *)user;
+    
+    if (video->headless) return 1;
+    
+    cv::Mat view(video->height, video->width, CV_8UC3, slot->frame->data);
+    cv::imshow("Contador de Moedas", view);
+    
+    return cv::waitKey(10) != 'q';
+}
+
+// Nomes das máscaras na opção --threshold, pela ordem de VC_MASK_*
+static const char *MASK_NAMES[VC_NUM_MASKS] = { "main", "gold", "copper", "euro" };
+
+// Lê MASCARA=fixed|otsu|local[:N] da opção --threshold; devolve false se for inválido
+static bool parseThreshold(const std::string &value, Options *options) {
+    const size_t eq = value.find('=');
+    if (eq == std::string::npos) return false;
+    
+    const std::string name = value.substr(0, eq);
+    std::string mode = value.substr(eq + 1);
+    int radius = 0;
+    
+    const size_t colon = mode.find(':');
+    if (colon != std::string::npos) {
+        radius = atoi(mode.c_str() + colon + 1);
+        mode = mode.substr(0, colon);
+        if (mode != "local" || radius <= 0) return false;
+    }
+    
+    for (int m = 0; m < VC_NUM_MASKS; m++) {
+        if (name != MASK_NAMES[m]) continue;
+        
+        if (mode == "fixed") options->thresholdMode[m] = VC_THRESH_FIXED;
+        else if (mode == "otsu") options->thresholdMode[m] = VC_THRESH_OTSU;
+        else if (mode == "local") options->thresholdMode[m] = VC_THRESH_LOCAL;
+        else return false;
+        
+        options->thresholdRadius[m] = radius;
+        return true;
+    }
+    
+    return false;
+}
+
+// Configura um processador: cadência nominal, denominações e calibração da escala
+static void configureProcessor(FrameProcessor *processor, const Options *options, int fps) {
+    // Cadência usada quando o vídeo não fornece o tempo de captura
+    if (fps > 0) processor->tracker->nominalFps = fps;
+    
+    // Denominações alternativas (outra moeda ou outra lente), se houver ficheiro,
+    // convertidas da resolução de referência para a do vídeo
+    CoinSpecTable specTable;
+    if (loadCoinSpecs(&specTable, VC_COIN_SPEC_FILE) > 0) {
+        setCoinSpecs(processor->tracker, &specTable);
+        std::cout << "Especificação das moedas lida de " << VC_COIN_SPEC_FILE << "\n";
+    }
+    
+    // Escala das denominações a partir de uma imagem de referência da mesma câmara, se existir
+    if (std::ifstream(VC_CALIBRATION_IMAGE).good()) {
+        IVC *reference = readImage((char *)VC_CALIBRATION_IMAGE);
+        IVC *referenceBgr = reference ? createImage(reference->width, reference->height, 3, 255) : NULL;
+        
+        if (!referenceBgr || !bgr2rgb(reference, referenceBgr) ||
+            calibrateFromImage(processor, referenceBgr) <= 0.0f) {
+            std::cerr << "Aviso: calibração com " << VC_CALIBRATION_IMAGE << " falhou\n";
+        }
+        
+        if (reference) freeImage(reference);
+        if (referenceBgr) freeImage(referenceBgr);
+    }
+    
+    // Calibração nos primeiros frames do vídeo, se pedida
+    if (options->calibrationFrames > 0) {
+        startCalibration(processor, options->calibrationFrames);
+    }
+    
+    // Limiar automático (Otsu) ou local das máscaras pedidas
+    for (int m = 0; m < VC_NUM_MASKS; m++) {
+        if (options->thresholdMode[m] != VC_THRESH_FIXED) {
+            setMaskThreshold(processor, m, options->thresholdMode[m], options->thresholdRadius[m]);
+        }
+    }
+    
+    // Passagens completas na pirâmide, refinadas só à volta dos blobs grosseiros, se pedido
+    if (options->coarse) {
+        processor->detectMode = VC_DETECT_COARSE;
+    }
+    
+    // Entre passagens completas segmenta só as ROIs previstas e a faixa de entrada, se pedido
+    if (options->roiInterval > 0) {
+        setRoiTracking(processor, options->roiInterval, options->entryRows);
+    }
+    
+    // Salta os frames sem movimento, se pedido
+    if (options->motion > 0.0f && !setMotionGate(processor, options->motion, options->maxSkip)) {
+        std::cerr << "Aviso: não foi possível criar o detetor de movimento\n";
+    }
+    
+    // Segmenta só as regiões alteradas em relação ao fundo, se pedido
+    if (options->background > 0.0f && !setBackgroundModel(processor, options->background, options->bgThreshold)) {
+        std::cerr << "Aviso: não foi possível criar o modelo de fundo\n";
+    }
+    
+    // Conta as passagens numa linha em vez de rastrear as moedas, se pedido
+    if (options->tripwire >= 0 &&
+        !setTripwire(processor, options->tripwire, options->tripwireBand, options->debounce)) {
+        std::cerr << "Aviso: linha de contagem " << options->tripwire << " fora do frame\n";
+    }
+}
+
+// Percentagem de frames saltados pelo detetor de movimento
+static void printSkipped(const FrameProcessor *processor, const char *indent) {
+    const MotionGate *gate = processor->motion;
+    if (gate == NULL || gate->frames <= 0) return;
+    
+    std::cout << indent << "Saltados:       " << std::setw(8) << gate->skippedFrames << " de " << gate->frames
+              << " frames sem movimento (" << std::setprecision(1) << 100.0 * gate->skippedFrames / gate->frames << "%)\n";
+}
+
+// Fração média de cada frame segmentada com o modelo de fundo
+static void printSegmentedArea(const FrameProcessor *processor, const char *indent) {
+    const BackgroundModel *bg = processor->background;
+    if (bg == NULL || bg->frames <= 0) return;
+    
+    std::cout << indent << "Área segmentada:" << std::setprecision(1) << std::setw(8) << 100.0 * bg->areaSum / bg->frames
+              << " % do frame, em média (modelo de fundo)\n";
+}
+
+// Passagens contadas na linha de contagem e altura da banda segmentada
+static void printTripwire(const FrameProcessor *processor, const char *indent) {
+    const Tripwire *tw = processor->tripwire;
+    if (tw == NULL || tw->frames <= 0) return;
+    
+    std::cout << indent << "Linha " << tw->y << ":      " << std::setw(8) << tw->crossings << " passagens, banda de "
+              << tw->band.height << " linhas (" << std::setprecision(1) << 100.0 * tw->band.height / tw->height
+              << "% do frame)\n";
+}
+
+static void printUsage(const char *program) {
+    std::cout << "Uso: " << program << " [opções] [vídeo...]\n"
+              << "  vídeo...           Ficheiro(s) de vídeo (por omissão video1.mp4); vários\n"
+              << "                     vídeos são processados em simultâneo, sem janela\n"
+              << "  --headless         Processa sem janela nem espera por teclas\n"
+              << "  --calibrate N      Calibra a escala nos primeiros N frames (sem contagem)\n"
+              << "  --coarse           Segmenta a 1/4 da resolução e refina só à volta das moedas\n"
+              << "                     encontradas; não se aplica a --pipeline\n"
+              << "  --threshold M=S    Limiar da máscara M (main, gold, copper ou euro): fixed (por\n"
+              << "                     omissão), otsu ou local[:R] (janela de raio R); otsu não se\n"
+              << "                     aplica a --workers K com K > 1\n"
+              << "  --pipeline         Lê, segmenta, analisa e mostra os frames em threads separadas\n"
+              << "  --workers K        Segmenta K frames em paralelo (implica --pipeline); com\n"
+              << "                     vários vídeos, número de threads de trabalho\n"
+              << "  --chunks N         Divide o vídeo em N blocos processados em paralelo (sem janela)\n"
+              << "  --overlap F        Frames de sobreposição entre blocos (por omissão " << VC_CHUNK_OVERLAP << ")\n"
+              << "  --motion T         Salta os frames sem movimento (diferença média por célula <= T,\n"
+              << "                     p. ex. " << VC_MOTION_THRESHOLD << "); não se aplica a --pipeline\n"
+              << "  --max-skip N       Máximo de frames seguidos saltados (por omissão " << VC_MOTION_MAX_SKIP << ")\n"
+              << "  --roi N            Segmenta o frame completo de N em N frames e, nos restantes, só\n"
+              << "                     as ROIs previstas das moedas seguidas; não se aplica a --pipeline\n"
+              << "  --entry-band H     Com --roi, segmenta também as primeiras H linhas, por onde entram\n"
+              << "                     as moedas (H < 0 = as últimas -H linhas)\n"
+              << "  --background R     Segmenta só as regiões que diferem do modelo de fundo, aprendido\n"
+              << "                     com a taxa R (p. ex. " << VC_BG_LEARNING_RATE << "); não se aplica a --pipeline\n"
+              << "  --bg-threshold D   Diferença para o fundo que conta como alteração (por omissão " << VC_BG_THRESHOLD << ")\n"
+              << "  --tripwire Y       Conta as moedas quando passam a linha Y, segmentando só a banda\n"
+              << "                     à volta da linha (sem rastreamento em todo o frame)\n"
+              << "  --tripwire-band H  Linhas da banda para cada lado da linha (por omissão automática)\n"
+              << "  --debounce N       Frames em que uma passagem a menos de um diâmetro de outra já\n"
+              << "                     contada não conta (por omissão " << VC_TRIP_DEBOUNCE << ")\n"
+              << "  -h, --help         Mostra esta ajuda\n";
+}
+
+// Lê as opções; devolve false (depois de imprimir a ajuda) se forem inválidas
+static bool parseOptions(int argc, char *argv[], Options *options) {
+    options->input = "video1.mp4";
+    options->headless = false;
+    options->calibrationFrames = 0;
+    options->coarse = false;
+    for (int m = 0; m < VC_NUM_MASKS; m++) {
+        options->thresholdMode[m] = VC_THRESH_FIXED;
+        options->thresholdRadius[m] = 0;
+    }
+    options->roiInterval = 0;
+    options->entryRows = 0;
+    options->pipeline = false;
+    options->workers = 0;
+    options->chunks = 0;
+    options->overlap = VC_CHUNK_OVERLAP;
+    options->motion = 0.0f;
+    options->maxSkip = VC_MOTION_MAX_SKIP;
+    options->background = 0.0f;
+    options->bgThreshold = VC_BG_THRESHOLD;
+    options->tripwire = -1;
+    options->tripwireBand = 0;
+    options->debounce = VC_TRIP_DEBOUNCE;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+
+        if (arg == "--headless") {
+            options->headless = true;
+        }
+        else if (arg == "--coarse") {
+            options->coarse = true;
+        }
+        else if (arg == "--threshold" && i + 1 < argc) {
+            if (!parseThreshold(argv[++i], options)) {
+                std::cerr << "Erro: --threshold precisa de MASCARA=fixed|otsu|local[:R] (main, gold, copper ou euro)\n";
+                return false;
+            }
+        }
+        else if (arg == "--pipeline") {
+            options->pipeline = true;
+        }
+        else if (arg == "--workers" && i + 1 < argc) {
+            options->workers = atoi(argv[++i]);
+            options->pipeline = true;
+            if (options->workers < 1 || options->workers > VC_PIPELINE_MAX_WORKERS) {
+                std::cerr << "Erro: --workers precisa de um número entre 1 e " << VC_PIPELINE_MAX_WORKERS << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--chunks" && i + 1 < argc) {
+            options->chunks = atoi(argv[++i]);
+            options->headless = true;
+            if (options->chunks < 1 || options->chunks > VC_MAX_CHUNKS) {
+                std::cerr << "Erro: --chunks precisa de um número entre 1 e " << VC_MAX_CHUNKS << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--overlap" && i + 1 < argc) {
+            options->overlap = atoi(argv[++i]);
+            if (options->overlap < 0) {
+                std::cerr << "Erro: --overlap não pode ser negativo\n";
+                return false;
+            }
+        }
+        else if (arg == "--motion" && i + 1 < argc) {
+            options->motion = (float)atof(argv[++i]);
+            if (options->motion <= 0.0f) {
+                std::cerr << "Erro: --motion precisa de um limiar positivo\n";
+                return false;
+            }
+        }
+        else if (arg == "--max-skip" && i + 1 < argc) {
+            options->maxSkip = atoi(argv[++i]);
+            if (options->maxSkip < 0) {
+                std::cerr << "Erro: --max-skip não pode ser negativo\n";
+                return false;
+            }
+        }
+        else if (arg == "--background" && i + 1 < argc) {
+            options->background = (float)atof(argv[++i]);
+            if (options->background <= 0.0f || options->background > 1.0f) {
+                std::cerr << "Erro: --background precisa de uma taxa entre 0 e 1\n";
+                return false;
+            }
+        }
+        else if (arg == "--bg-threshold" && i + 1 < argc) {
+            options->bgThreshold = atoi(argv[++i]);
+            if (options->bgThreshold < 1 || options->bgThreshold > 255) {
+                std::cerr << "Erro: --bg-threshold precisa de um número entre 1 e 255\n";
+                return false;
+            }
+        }
+        else if (arg == "--tripwire" && i + 1 < argc) {
+            options->tripwire = atoi(argv[++i]);
+            if (options->tripwire < 0) {
+                std::cerr << "Erro: --tripwire não pode ser negativo\n";
+                return false;
+            }
+        }
+        else if (arg == "--tripwire-band" && i + 1 < argc) {
+            options->tripwireBand = atoi(argv[++i]);
+            if (options->tripwireBand < 1) {
+                std::cerr << "Erro: --tripwire-band precisa de um número de linhas positivo\n";
+                return false;
+            }
+        }
+        else if (arg == "--debounce" && i + 1 < argc) {
+            options->debounce = atoi(argv[++i]);
+            if (options->debounce < 0) {
+                std::cerr << "Erro: --debounce não pode ser negativo\n";
+                return false;
+            }
+        }
+        else if (arg == "--calibrate" && i + 1 < argc) {
+            options->calibrationFrames = atoi(argv[++i]);
+            if (options->calibrationFrames <= 0) {
+                std::cerr << "Erro: --calibrate precisa de um número de frames positivo\n";
+                return false;
+            }
+        }
+        else if (arg == "--roi" && i + 1 < argc) {
+            options->roiInterval = atoi(argv[++i]);
+            if (options->roiInterval < 1) {
+                std::cerr << "Erro: --roi precisa de um número de frames positivo\n";
+                return false;
+            }
+        }
+        else if (arg == "--entry-band" && i + 1 < argc) {
+            options->entryRows = atoi(argv[++i]);
+            if (options->entryRows == 0) {
+                std::cerr << "Erro: --entry-band precisa de um número de linhas diferente de 0\n";
+                return false;
+            }
+        }
+        else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return false;
+        }
+        else if (arg.compare(0, 1, "-") == 0) {
+            std::cerr << "Erro: opção desconhecida " << arg << "\n";
+            printUsage(argv[0]);
+            return false;
+        }
+        else {
+            options->streams.push_back(arg);
+        }
+    }
+
+    if (!options->streams.empty()) options->input = options->streams[0];
+
+    // Vários vídeos: cada um é um stream independente, sem janela
+    if (options->streams.size() > 1) {
+        if (options->chunks > 0) {
+            std::cerr << "Erro: --chunks só aceita um vídeo\n";
+            return false;
+        }
+        if (options->streams.size() > VC_MAX_STREAMS) {
+            std::cerr << "Erro: no máximo " << VC_MAX_STREAMS << " vídeos em simultâneo\n";
+            return false;
+        }
+        options->pipeline = false;
+        options->headless = true;
+    }
+
+    // Cada thread de segmentação teria o seu limiar de Otsu, atualizado só com os seus frames
+    if (options->pipeline && options->workers > 1) {
+        for (int m = 0; m < VC_NUM_MASKS; m++) {
+            if (options->thresholdMode[m] == VC_THRESH_OTSU) {
+                std::cerr << "Erro: --threshold " << MASK_NAMES[m] << "=otsu não se aplica a --workers "
+                          << options->workers << "\n";
+                return false;
+            }
+        }
+    }
+
+    // Cada bloco recomeçaria o cálculo do limiar de Otsu na sua sobreposição
+    if (options->chunks > 1) {
+        for (int m = 0; m < VC_NUM_MASKS; m++) {
+            if (options->thresholdMode[m] == VC_THRESH_OTSU) {
+                std::cerr << "Erro: --threshold " << MASK_NAMES[m] << "=otsu não se aplica a --chunks "
+                          << options->chunks << "\n";
+                return false;
+            }
+        }
+    }
+    
+    if (options->entryRows != 0 && options->roiInterval == 0) {
+        std::cerr << "Erro: --entry-band só se aplica com --roi\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Modo multi-stream: um contexto por vídeo, todos servidos pelo mesmo conjunto de threads
+static int runStreamsMode(const Options *options) {
+    const int nStreams = (int)options->streams.size();
+    std::vector<cv::VideoCapture *> captures(nStreams, (cv::VideoCapture *)NULL);
+    std::vector<VideoStream *> streams(nStreams, (VideoStream *)NULL);
+    bool ok = true;
+    
+    for (int i = 0; i < nStreams && ok; i++) {
+        captures[i] = new cv::VideoCapture(options->streams[i]);
+        if (!captures[i]->isOpened()) {
+            std::cerr << "Erro: VideoCapture não foi aberto (" << options->streams[i] << ")!\n";
+            ok = false;
+            break;
+        }
+        
+        const int width = (int)captures[i]->get(cv::CAP_PROP_FRAME_WIDTH);
+        const int height = (int)captures[i]->get(cv::CAP_PROP_FRAME_HEIGHT);
+        streams[i] = createVideoStream(width, height);
+        if (streams[i] == NULL) {
+            std::cerr << "Erro: não foi possível criar o stream " << i << " (" << width << "x" << height << ")\n";
+            ok = false;
+            break;
+        }
+        
+        configureProcessor(streams[i]->proc, options, (int)captures[i]->get(cv::CAP_PROP_FPS));
+        // Os registos de vários streams misturar-se-iam
+        streams[i]->proc->tracker->verbose = 0;
+        streams[i]->read = readCapture;
+        streams[i]->source = captures[i];
+    }
+    
+    const auto runStart = std::chrono::steady_clock::now();
+    const int threads = ok ? runStreams(streams.data(), nStreams, options->workers) : 0;
+    const double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    
+    if (ok && threads == 0) std::cerr << "Erro: o modo multi-stream falhou\n";
+    
+    if (threads > 0) {
+        long long totalFrames = 0;
+        
+        std::cout << "\n\n";
+        std::cout << "=====================================================\n";
+        std::cout << "           RESULTADOS POR STREAM (" << threads << " threads)\n";
+        std::cout << "=====================================================\n";
+        for (int i = 0; i < nStreams; i++) {
+            const VideoStream *stream = streams[i];
+            const CoinSpecTable *specs = &stream->proc->tracker->specs;
+            float value = 0.0f;
+            int coins = 0;
+            
+            std::cout << "Stream " << i << " (" << options->streams[i] << "):\n  ";
+            for (int t = 0; t < specs->nSpecs; t++) {
+                std::cout << (t ? ", " : "") << specs->specs[t].name << ": " << stream->coinCounts[t];
+                coins += stream->coinCounts[t];
+                value += stream->coinCounts[t] * specs->specs[t].value;
+            }
+            std::cout << "\n  - Total: " << coins << " moedas | " << std::fixed << std::setprecision(2) << value << " €\n";
+            
+            if (stream->frames > 0 && stream->seconds > 0.0) {
+                std::cout << "  - " << stream->frames << " frames: " << std::setprecision(1)
+                          << stream->frames / stream->seconds << " fps | latência média "
+                          << std::setprecision(2) << 1000.0 * stream->latencySum / stream->frames
+                          << " ms, máxima " << 1000.0 * stream->latencyMax << " ms\n";
+            }
+            printSkipped(stream->proc, "  - ");
+            printSegmentedArea(stream->proc, "  - ");
+            printTripwire(stream->proc, "  - ");
+            totalFrames += stream->frames;
+        }
+        std::cout << "=====================================================\n";
+        std::cout << "\nDébito (" << totalFrames << " frames em " << std::setprecision(2) << runSeconds << " s):\n";
+        if (runSeconds > 0.0)
+            std::cout << "  - Total:          " << std::setprecision(1) << std::setw(8) << totalFrames / runSeconds << " fps\n";
+    }
+    
+    for (int i = 0; i < nStreams; i++) {
+        freeVideoStream(streams[i]);
+        delete captures[i];
+    }
+    
+    return (threads > 0) ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) return -1;
+    
+    // Vários vídeos: um stream independente por vídeo
+    if (options.streams.size() > 1) return runStreamsMode(&options);
+    
+    // Contadores de moedas, pela ordem da tabela de denominações (1c ... 2€ por omissão)
+    int coinCounts[VC_MAX_COIN_TYPES] = {0};
     // Estatísticas para cada tipo de moeda
-    CoinStats coinStats[8] = {0};
+    CoinStats coinStats[VC_MAX_COIN_TYPES] = {0};
     
     // Carregamento do vídeo
     cv::VideoCapture capture;
     int key = 0;
     
     // Abre o ficheiro de vídeo
-    capture.open("../video/moedas.avi");
+    capture.open(options.input);
     
     // Verifica se o vídeo foi aberto com sucesso
     if (!capture.isOpened()) {
-        std::cerr << "Erro: VideoCapture não foi aberto!\n";
+        std::cerr << "Erro: VideoCapture não foi aberto (" << options.input << ")!\n";
         return -1;
     }
     
@@ -83,89 +636,126 @@ int main(void) {
     std::cout << "  - Total de frames: " << totalFrames << "\n\n";
     
     // Cria uma janela para visualização
-    cv::namedWindow("Contador de Moedas", cv::WINDOW_NORMAL);
-    
-    // Cria contentores de imagem OpenCV
-    cv::Mat frame, frame2;
+    if (!options.headless) {
+        cv::namedWindow("Contador de Moedas", cv::WINDOW_NORMAL);
+    }
     
     // Cria contentores de imagem IVC
     IVC *ivc_frame = createImage(width, height, 3, 255);
     IVC *ivc_frame2 = createImage(width, height, 3, 255);
     
+    // Cria o estado de processamento (buffers de trabalho reutilizados entre frames)
+    FrameProcessor *processor = createFrameProcessor(width, height);
+    
     // Verifica se as imagens foram criadas com sucesso
-    if (!ivc_frame || !ivc_frame2) {
+    if (!ivc_frame || !ivc_frame2 || !processor) {
         std::cerr << "Erro: Imagens IVC não criadas!\n";
         return -1;
     }
     
+    // Vista OpenCV sobre ivc_frame, para mostrar o frame sem o copiar
+    cv::Mat frame(height, width, CV_8UC3, ivc_frame->data);
+    
+    // Cadência, denominações e calibração
+    configureProcessor(processor, &options, fps);
+    
     // Configura para rastrear estatísticas dos blobs para médias
     int frameCount = 0;
     
-    // Processa os frames do vídeo
-    while (key != 'q') {
-        // Obtém o próximo frame
-        if (!capture.read(frame)) break;
-        
-        // Processa a cada dois frames para melhorar o desempenho
-        if (frameCount % 2 == 0) {
-            frame.copyTo(frame2);
+    // Tempos para o relatório de débito: total e só do processamento
+    double decodeSeconds = 0.0, processSeconds = 0.0;
+    const auto runStart = std::chrono::steady_clock::now();
+    
+    // Tempos de cada estágio no modo pipeline
+    PipelineStats pipelineStats = {0};
+    
+    // Resultado de cada bloco no modo por blocos
+    ChunkResult chunkResults[VC_MAX_CHUNKS] = {};
+    
+    if (options.chunks > 0) {
+        // Cada bloco abre a sua própria leitura do vídeo
+        ChunkCallbacks callbacks = { openChunk, readCapture, closeChunk, &options.input };
+        if (!processChunks(processor, &callbacks, totalFrames, options.chunks, options.overlap,
+                           coinCounts, chunkResults)) {
+            std::cerr << "Erro: o modo por blocos falhou\n";
         }
-        frameCount++;
-        
-        // Converte o formato Mat do OpenCV para o formato IVC
-        memcpy(ivc_frame->data, frame.data, width * height * 3);
-        memcpy(ivc_frame2->data, frame2.data, width * height * 3);
-        
-        // Processa o frame com as nossas funções personalizadas
-        processFrame(ivc_frame, ivc_frame2, excludeList, coinCounts);
-        
-        // Exibe a imagem
-        cv::imshow("Contador de Moedas", frame);
+        else {
+            // Os frames da calibração são os anteriores ao primeiro bloco
+            frameCount = (int)chunkResults[0].firstFrame;
+            for (int i = 0; i < options.chunks; i++) {
+                if (chunkResults[i].ok) frameCount += (int)(chunkResults[i].frames - chunkResults[i].leadIn);
+            }
+        }
+    }
+    else if (options.pipeline) {
+        // Leitura, segmentação e análise em threads próprias; visualização nesta thread
+        VideoStages video;
+        video.capture = &capture;
+        video.width = width;
+        video.height = height;
+        video.headless = options.headless;
         
-        // Aguarda tecla (10ms)
-        key = cv::waitKey(10);
+        PipelineCallbacks callbacks = { readStage, renderStage, &video };
+        if (!runPipeline(processor, &callbacks, VC_PIPELINE_DEPTH, VC_MAX(options.workers, 1), coinCounts,
+                         &pipelineStats)) {
+            std::cerr << "Erro: o modo pipeline falhou\n";
+        }
+        frameCount = (int)pipelineStats.frames;
+    }
+    else {
+        // Processa os frames do vídeo
+        while (key != 'q') {
+            // Obtém o próximo frame, descodificado diretamente para o IVC
+            auto stageStart = std::chrono::steady_clock::now();
+            if (!readInto(&capture, ivc_frame)) break;
+            decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count();
+            
+            // frame2 só é atualizado a cada dois frames (antes de se desenhar em ivc_frame)
+            if (frameCount % VC_FRAME2_INTERVAL == 0) {
+                memcpy(ivc_frame2->data, ivc_frame->data, ivc_frame->bytesperline * height);
+            }
+            frameCount++;
+            
+            // Processa o frame com as nossas funções personalizadas
+            stageStart = std::chrono::steady_clock::now();
+            processFrameAt(processor, ivc_frame, ivc_frame2, coinCounts,
+                           (long long)capture.get(cv::CAP_PROP_POS_MSEC));
+            processSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count();
+            
+            if (!options.headless) {
+                // Exibe a imagem com as visualizações
+                cv::imshow("Contador de Moedas", frame);
+            
+                // Aguarda tecla (10ms)
+                key = cv::waitKey(10);
+            }
+        }
     }
     
-    // Calcula estatísticas finais
-    const char* coinNames[8] = {"1¢", "2¢", "5¢", "10¢", "20¢", "50¢", "1€", "2€"};
-    const float coinValues[8] = {0.01, 0.02, 0.05, 0.10, 0.20, 0.50, 1.00, 2.00};
+    const double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    
+    // Recolhe estatísticas de moedas do rastreador do processador
+    CoinTracker *tracker = processor->tracker;
+    const CoinSpecTable *specs = &tracker->specs;
     float totalValue = 0.0f;
     int totalCoins = 0;
     
-    // Recolhe estatísticas de moedas do array de rastreamento
-    // Este array externo contém informações sobre todas as moedas detetadas
-    extern int detectedCoins[150][5]; // Do sistema de rastreamento de moedas
-    extern int MAX_TRACKED_COINS; 
-    
     // Reinicia os arrays de estatísticas de moedas
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < VC_MAX_COIN_TYPES; i++) {
         coinStats[i].count = 0;
         coinStats[i].totalArea = 0;
         coinStats[i].totalPerimeter = 0;
     }
     
-    // Processa os dados de moedas armazenados para calcular estatísticas
-    for (int i = 0; i < MAX_TRACKED_COINS; i++) {
-        // Ignora registos vazios
-        if (detectedCoins[i][0] == 0 && detectedCoins[i][1] == 0) continue;
-        
-        // Obtém o tipo de moeda (índice baseado em 1, precisa subtrair 1 para índice do array)
-        int coinType = detectedCoins[i][2];
-        if (coinType < 1 || coinType > 8) continue;
-        
-        // Contabiliza apenas moedas que foram realmente contadas (flag definida como 1)
-        if (detectedCoins[i][4] == 1) {
-            int coinIndex = coinType - 1;
-            
-            // Atualiza contagem apenas (área e perímetro não são mais necessários)
-            coinStats[coinIndex].count++;
-        }
+    // As contagens por tipo sobrevivem à expiração das entradas do rastreador
+    for (int i = 0; i < VC_MAX_COIN_TYPES; i++) {
+        coinStats[i].count += tracker->countedByType[i];
     }
     
     // Calcula estatísticas finais
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < specs->nSpecs; i++) {
         totalCoins += coinCounts[i];
-        totalValue += coinCounts[i] * coinValues[i];
+        totalValue += coinCounts[i] * specs->specs[i].value;
     }
     
     // Imprime resultados finais com formato simplificado (sem área e perímetro)
@@ -176,11 +766,11 @@ int main(void) {
     std::cout << "Tipo Moeda | Quantidade | Valor (€)\n";
     std::cout << "-----------|-----------|---------\n";
     
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < specs->nSpecs; i++) {
         if (coinCounts[i] > 0) {
-            std::cout << std::left << std::setw(11) << coinNames[i] << " | " 
+            std::cout << std::left << std::setw(11) << specs->specs[i].name << " | " 
                       << std::right << std::setw(9) << coinCounts[i] << " | " 
-                      << std::fixed << std::setprecision(2) << std::setw(7) << coinCounts[i] * coinValues[i] << " €\n";
+                      << std::fixed << std::setprecision(2) << std::setw(7) << coinCounts[i] * specs->specs[i].value << " €\n";
         }
     }
     
@@ -190,12 +780,57 @@ int main(void) {
               << std::fixed << std::setprecision(2) << std::setw(7) << totalValue << " €\n";
     std::cout << "=====================================================\n";
     
+    // Relatório de débito
+    std::cout << "\nDébito (" << frameCount << " frames em " << std::setprecision(2) << runSeconds << " s):\n";
+    if (frameCount > 0 && runSeconds > 0.0) {
+        std::cout << "  - Total:          " << std::setprecision(1) << std::setw(8) << frameCount / runSeconds << " fps\n";
+        if (options.chunks > 0) {
+            // Frames próprios de cada bloco; a sobreposição é processada duas vezes
+            for (int i = 0; i < options.chunks; i++) {
+                const ChunkResult *chunk = &chunkResults[i];
+                if (!chunk->ok) continue;
+                std::cout << "  - Bloco " << i << ": frame " << chunk->firstFrame << ", "
+                          << chunk->frames - chunk->leadIn << " frames (+" << chunk->leadIn << " de sobreposição) em "
+                          << std::setprecision(2) << chunk->seconds << " s";
+                if (chunk->skipped > 0) std::cout << ", " << chunk->skipped << " saltados";
+                std::cout << "\n";
+            }
+        }
+        else if (options.pipeline) {
+            // Tempo ocupado de cada estágio; o débito é limitado pelo mais lento
+            // (a segmentação é dividida pelas threads de trabalho)
+            static const char *STAGE_NAMES[VC_PIPELINE_STAGES] = {
+                "Descodificação:", "Segmentação:   ", "Análise:       ", "Visualização:  "
+            };
+            for (int i = 0; i < VC_PIPELINE_STAGES; i++) {
+                const int threads = (i == VC_STAGE_SEGMENT) ? VC_MAX(options.workers, 1) : 1;
+                std::cout << "  - " << STAGE_NAMES[i] << " " << std::setprecision(2) << std::setw(8)
+                          << 1000.0 * pipelineStats.stageSeconds[i] / frameCount / threads << " ms/frame";
+                if (threads > 1) std::cout << " (" << threads << " threads)";
+                std::cout << "\n";
+            }
+        }
+        else {
+            std::cout << "  - Descodificação: " << std::setprecision(2) << std::setw(8) << 1000.0 * decodeSeconds / frameCount << " ms/frame\n";
+            std::cout << "  - Processamento:  " << std::setprecision(2) << std::setw(8) << 1000.0 * processSeconds / frameCount << " ms/frame";
+            if (processSeconds > 0.0)
+                std::cout << " (" << std::setprecision(1) << frameCount / processSeconds << " fps)";
+            std::cout << "\n";
+            printSkipped(processor, "  - ");
+            printSegmentedArea(processor, "  - ");
+            printTripwire(processor, "  - ");
+        }
+    }
+    
     // Liberta recursos
     if (ivc_frame) freeImage(ivc_frame);
     if (ivc_frame2) freeImage(ivc_frame2);
+    if (processor) freeFrameProcessor(processor);
     
     // Fecha janelas e liberta o vídeo
-    cv::destroyAllWindows();
+    if (!options.headless) {
+        cv::destroyAllWindows();
+    }
     capture.release();
     
     return 0;
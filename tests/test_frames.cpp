@@ -0,0 +1,159 @@
+/**
+ * @file test_frames.cpp
+ * @brief Testes do processamento completo de frames sintéticos
+ *
+ * Os frames do tapete sintético passam pela segmentação, pela análise dos
+ * blobs e pelo rastreador, como os frames descodificados dos vídeos.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+
+#include "vc_test.h"
+
+#define TEST_WIDTH 640
+#define TEST_HEIGHT 480
+
+/**
+ * Moeda a 10 px/frame que para a meio do frame: com o detetor de movimento
+ * os frames parados são saltados, mas a moeda continua a ser contada uma
+ * única vez.
+ */
+static void testStoppedBelt(void) {
+    const BeltCoin coin = { 320.0f, -80.0f, 0.0f, 10.0f, 152.0f, VC_MASK_COPPER, 32 };
+
+    for (int gated = 0; gated <= 1; gated++) {
+        FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+        proc->tracker->verbose = 0;
+        if (gated) setMotionGate(proc, VC_MOTION_THRESHOLD, 30);
+
+        const int n = countSequential(proc, &coin, 1, 80);
+        CHECK(n == 1, "moeda que para contada %d vezes (detetor de movimento %s)", n, gated ? "ligado" : "desligado");
+        if (gated) CHECK(proc->motion->skippedFrames > 0, "nenhum frame saltado com a moeda parada");
+        freeFrameProcessor(proc);
+    }
+}
+
+/**
+ * Com a re-deteção nas ROIs previstas, as moedas rápidas (ainda por contar
+ * quando são vistas pela primeira vez numa passagem completa) continuam a
+ * ser seguidas nas ROIs até serem contadas, com ou sem faixa de entrada.
+ * As moedas de euro, cuja classe de cor só vê o centro dourado, também
+ * cabem inteiras na ROI.
+ */
+static void testRoiTracking(void) {
+    for (int speed = 8; speed <= 24; speed += 8) {
+        for (int entryRows = 0; entryRows <= 100; entryRows += 100) {
+            const BeltCoin coin = { 320.0f, -80.0f, 0.0f, (float)speed, 174.0f, VC_MASK_GOLD, -1 };
+            FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+            proc->tracker->verbose = 0;
+            setRoiTracking(proc, VC_ROI_FULL_INTERVAL, entryRows);
+
+            const int n = countSequential(proc, &coin, 1, (TEST_HEIGHT + 240) / speed);
+            CHECK(n == 1, "moeda a %d px/frame contada %d vezes com ROIs (faixa de entrada de %d linhas)",
+                  speed, n, entryRows);
+            freeFrameProcessor(proc);
+        }
+    }
+
+    for (float diameter = 185.0f; diameter <= 195.0f; diameter += 10.0f) {
+        const float speed = 18.0f;
+        const BeltCoin coin = { 320.0f, -100.0f, 0.0f, speed, diameter, VC_MASK_EURO, -1 };
+        FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+        proc->tracker->verbose = 0;
+        setRoiTracking(proc, VC_ROI_FULL_INTERVAL, 0);
+
+        const int n = countSequential(proc, &coin, 1, (long long)((TEST_HEIGHT + 300) / speed));
+        CHECK(n == 1, "moeda de euro de %.0f px a %.0f px/frame contada %d vezes com ROIs", diameter, speed, n);
+        freeFrameProcessor(proc);
+    }
+}
+
+/**
+ * Com a linha de contagem, a maior moeda é contada uma vez a qualquer
+ * velocidade até 2H - D px/frame (meia banda H automática), seja qual for
+ * a posição em que aparece no primeiro frame.
+ */
+static void testTripwireSpeed(void) {
+    const float diameter = 195.0f;
+    const float limit = 2.0f * VC_TRIP_BAND_FACTOR * diameter - diameter - 4.0f; // Menos as margens do corte
+
+    for (float speed = 0.25f * limit; speed <= limit; speed += 0.25f * limit) {
+        for (float phase = 0.0f; phase < speed; phase += speed / 3.0f) {
+            const BeltCoin coin = { 320.0f, -100.0f - phase, 0.0f, speed, diameter, VC_MASK_EURO, -1 };
+            FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+            proc->tracker->verbose = 0;
+            setTripwire(proc, TEST_HEIGHT / 2, 0, VC_TRIP_DEBOUNCE);
+
+            const int n = countSequential(proc, &coin, 1, (long long)((TEST_HEIGHT + 300) / speed));
+            CHECK(n == 1, "moeda de %.0f px a %.0f px/frame (fase %.0f) contada %d vezes na linha",
+                  diameter, speed, phase, n);
+            freeFrameProcessor(proc);
+        }
+    }
+}
+
+/**
+ * O modo grosseiro (segmentação na pirâmide e refinamento à volta dos
+ * blobs) conta as mesmas moedas do tapete que a resolução total.
+ */
+static void testCoarseMode(void) {
+    int counts[2];
+
+    for (int mode = VC_DETECT_FULL; mode <= VC_DETECT_COARSE; mode++) {
+        FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+        proc->tracker->verbose = 0;
+        proc->detectMode = mode;
+        counts[mode] = countSequential(proc, TEST_BELT, TEST_BELT_COINS, TEST_BELT_FRAMES);
+        freeFrameProcessor(proc);
+    }
+
+    CHECK(counts[VC_DETECT_FULL] == TEST_BELT_COINS, "tapete com %d moedas contado como %d à resolução total",
+          TEST_BELT_COINS, counts[VC_DETECT_FULL]);
+    CHECK(counts[VC_DETECT_COARSE] == counts[VC_DETECT_FULL], "modo grosseiro contou %d moedas e o completo %d",
+          counts[VC_DETECT_COARSE], counts[VC_DETECT_FULL]);
+}
+
+/**
+ * Com o limiar de Otsu ou o limiar local em todas as máscaras o tapete
+ * continua a ser contado por inteiro; no modo de Otsu o limiar da máscara
+ * principal fica entre o fundo e as moedas.
+ */
+static void testThresholdModes(void) {
+    static const int MODES[] = { VC_THRESH_OTSU, VC_THRESH_LOCAL };
+
+    for (int i = 0; i < 2; i++) {
+        FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+        proc->tracker->verbose = 0;
+        for (int m = 0; m < VC_NUM_MASKS; m++) {
+            CHECK(setMaskThreshold(proc, m, MODES[i], 0), "setMaskThreshold recusou a máscara %d", m);
+        }
+
+        const int n = countSequential(proc, TEST_BELT, TEST_BELT_COINS, TEST_BELT_FRAMES);
+        CHECK(n == TEST_BELT_COINS, "tapete com %d moedas contado como %d com o limiar %s",
+              TEST_BELT_COINS, n, MODES[i] == VC_THRESH_OTSU ? "de Otsu" : "local");
+        if (MODES[i] == VC_THRESH_OTSU) {
+            const int t = proc->thresholds[VC_MASK_MAIN].value;
+            CHECK(t > 40 && t < 150, "limiar de Otsu da máscara principal %d fora do intervalo fundo-moedas", t);
+        }
+        freeFrameProcessor(proc);
+    }
+}
+
+int main(void) {
+    testStoppedBelt();
+    testRoiTracking();
+    testTripwireSpeed();
+    testCoarseMode();
+    testThresholdModes();
+
+    if (testFailures > 0) {
+        printf("%d verificações falharam\n", testFailures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file test_kernels.cpp
+ * @brief Testes dos kernels vetorizados (cinzento, binarização e Sobel) contra a versão escalar
+ *
+ * As imagens são aleatórias, com larguras que não são múltiplas do passo
+ * SIMD (os últimos pixels de cada linha passam pelo ciclo escalar) e
+ * linhas com bytes de enchimento depois do último pixel, como as vistas
+ * sobre os buffers do processador. A integral calculada numa vista sobre
+ * tabelas partilhadas (integralView()) é comparada com uma integral própria.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "vc_test.h"
+
+static const int WIDTHS[] = { 1, 7, 15, 16, 17, 31, 33, 47, 63, 97, 641 };
+#define NUM_WIDTHS ((int)(sizeof(WIDTHS) / sizeof(WIDTHS[0])))
+#define TEST_ROWS 5
+
+static unsigned int randomState = 12345u;
+
+// Gerador congruencial simples, para os testes serem reprodutíveis
+static unsigned char randomByte(void) {
+    randomState = randomState * 1103515245u + 12345u;
+    return (unsigned char)(randomState >> 16);
+}
+
+/**
+ * @brief Cria uma imagem aleatória com enchimento no fim de cada linha
+ *
+ * A imagem devolvida é uma vista sobre *buffer, com bytesperline maior do
+ * que width * channels; o enchimento também é aleatório.
+ */
+static IVC paddedImage(IVC **buffer, int width, int height, int channels, int pad) {
+    *buffer = createImage(width + pad, height, channels, 255);
+    for (long int i = 0; i < (long int)(*buffer)->bytesperline * height; i++) {
+        (*buffer)->data[i] = randomByte();
+    }
+
+    IVC view = **buffer;
+    view.width = width;
+    return view;
+}
+
+// Luminância Q8 de referência, calculada pixel a pixel como o ciclo escalar
+static unsigned char referenceGray(const unsigned char *p) {
+    return (unsigned char)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+}
+
+/**
+ * rgb2gray() e rgb2binary() dão, em todas as larguras, o mesmo resultado
+ * que a fórmula escalar, incluindo os limiares nos extremos (0, 1, 255 e
+ * fora do intervalo), e não escrevem no enchimento das linhas.
+ */
+static void testGrayKernels(void) {
+    static const int THRESHOLDS[] = { -1, 0, 1, 127, 128, 254, 255, 256 };
+
+    for (int w = 0; w < NUM_WIDTHS; w++) {
+        const int width = WIDTHS[w], pad = 1 + w % 5;
+        IVC *srcBuffer, *dstBuffer;
+        IVC src = paddedImage(&srcBuffer, width, TEST_ROWS, 3, pad);
+        IVC dst = paddedImage(&dstBuffer, width, TEST_ROWS, 1, pad);
+        int errors = 0, padErrors = 0;
+
+        // Marca o enchimento para verificar que não é escrito
+        for (int y = 0; y < TEST_ROWS; y++) {
+            memset(dst.data + (long int)y * dst.bytesperline + width, 77, pad);
+        }
+
+        CHECK(rgb2gray(&src, &dst) == 1, "rgb2gray falhou com largura %d", width);
+        for (int y = 0; y < TEST_ROWS; y++) {
+            const unsigned char *in = src.data + (long int)y * src.bytesperline;
+            const unsigned char *out = dst.data + (long int)y * dst.bytesperline;
+            for (int x = 0; x < width; x++) {
+                if (out[x] != referenceGray(in + x * 3)) errors++;
+            }
+            for (int x = width; x < width + pad; x++) {
+                if (out[x] != 77) padErrors++;
+            }
+        }
+        CHECK(errors == 0, "rgb2gray difere da versão escalar em %d pixels (largura %d)", errors, width);
+
+        for (int t = 0; t < (int)(sizeof(THRESHOLDS) / sizeof(THRESHOLDS[0])); t++) {
+            const int threshold = THRESHOLDS[t];
+            errors = 0;
+
+            CHECK(rgb2binary(&src, &dst, threshold) == 1, "rgb2binary falhou com largura %d", width);
+            for (int y = 0; y < TEST_ROWS; y++) {
+                const unsigned char *in = src.data + (long int)y * src.bytesperline;
+                const unsigned char *out = dst.data + (long int)y * dst.bytesperline;
+                for (int x = 0; x < width; x++) {
+                    // Fora de [1, 255] a imagem é uniforme: toda a 255 (<= 0) ou toda a 0 (> 255)
+                    const unsigned char expected = (threshold <= 0) ? 255 : (threshold > 255) ? 0 :
+                                                   (referenceGray(in + x * 3) >= threshold) ? 255 : 0;
+                    if (out[x] != expected) errors++;
+                }
+                for (int x = width; x < width + pad; x++) {
+                    if (out[x] != 77) padErrors++;
+                }
+            }
+            CHECK(errors == 0, "rgb2binary difere da versão escalar em %d pixels (largura %d, limiar %d)",
+                  errors, width, threshold);
+        }
+
+        CHECK(padErrors == 0, "%d bytes de enchimento escritos (largura %d)", padErrors, width);
+        freeImage(srcBuffer);
+        freeImage(dstBuffer);
+    }
+}
+
+/**
+ * detectEdgesDirection() sem imagem de direção (ciclo SSE2) dá as mesmas
+ * bordas que com ela (só ciclo escalar), em todas as larguras e limiares,
+ * e não escreve no enchimento das linhas.
+ */
+static void testSobelKernel(void) {
+    static const float THRESHOLDS[] = { -1.0f, 0.0f, 10.0f, 100.0f, 250.5f, 1001.0f };
+
+    for (int w = 0; w < NUM_WIDTHS; w++) {
+        const int width = WIDTHS[w], pad = 1 + w % 5;
+        IVC *srcBuffer, *simdBuffer, *scalarBuffer, *dirBuffer;
+        IVC src = paddedImage(&srcBuffer, width, TEST_ROWS, 1, pad);
+        IVC simd = paddedImage(&simdBuffer, width, TEST_ROWS, 1, pad);
+        IVC scalar = paddedImage(&scalarBuffer, width, TEST_ROWS, 1, pad);
+        IVC dir = paddedImage(&dirBuffer, width, TEST_ROWS, 1, pad);
+        int padErrors = 0;
+
+        for (int y = 0; y < TEST_ROWS; y++) {
+            memset(simd.data + (long int)y * simd.bytesperline + width, 77, pad);
+        }
+
+        for (int t = 0; t < (int)(sizeof(THRESHOLDS) / sizeof(THRESHOLDS[0])); t++) {
+            const float threshold = THRESHOLDS[t];
+            int errors = 0;
+
+            CHECK(detectEdgesDirection(&src, &simd, NULL, threshold) == 1,
+                  "detectEdgesDirection falhou com largura %d", width);
+            CHECK(detectEdgesDirection(&src, &scalar, &dir, threshold) == 1,
+                  "detectEdgesDirection (com direção) falhou com largura %d", width);
+            for (int y = 0; y < TEST_ROWS; y++) {
+                const unsigned char *a = simd.data + (long int)y * simd.bytesperline;
+                const unsigned char *b = scalar.data + (long int)y * scalar.bytesperline;
+                for (int x = 0; x < width; x++) {
+                    if (a[x] != b[x]) errors++;
+                }
+                for (int x = width; x < width + pad; x++) {
+                    if (a[x] != 77) padErrors++;
+                }
+            }
+            CHECK(errors == 0, "detectEdgesDirection difere da versão escalar em %d pixels (largura %d, limiar %.1f)",
+                  errors, width, threshold);
+        }
+
+        CHECK(padErrors == 0, "%d bytes de enchimento escritos pelo Sobel (largura %d)", padErrors, width);
+        freeImage(srcBuffer);
+        freeImage(simdBuffer);
+        freeImage(scalarBuffer);
+        freeImage(dirBuffer);
+    }
+}
+
+/**
+ * Uma integral calculada numa vista sobre as tabelas de uma integral
+ * maior (já usada por outra imagem) dá as mesmas somas que uma integral
+ * própria, em todas as larguras e em todos os retângulos que tocam as
+ * bordas.
+ */
+static void testIntegralView(void) {
+    IVC *bigBuffer;
+    IVC big = paddedImage(&bigBuffer, 641, 2 * TEST_ROWS, 1, 3);
+    IntegralImage *shared = createIntegral(big.width, big.height, VC_INTEGRAL_32);
+    IntegralImage view;
+
+    CHECK(!integralView(shared, big.width + 1, 1, &view), "integralView aceitou uma largura maior do que a integral");
+
+    for (int w = 0; w < NUM_WIDTHS; w++) {
+        const int width = WIDTHS[w];
+        IVC *srcBuffer;
+        IVC src = paddedImage(&srcBuffer, width, TEST_ROWS, 1, 1 + w % 5);
+        IntegralImage *own = createIntegral(width, TEST_ROWS, VC_INTEGRAL_32);
+        int errors = 0;
+
+        // As tabelas partilhadas ficam com os valores de outra imagem antes da vista
+        computeIntegral(&big, shared);
+        CHECK(integralView(shared, width, TEST_ROWS, &view), "integralView recusou largura %d", width);
+        CHECK(computeIntegral(&src, &view) == 1, "computeIntegral falhou na vista de largura %d", width);
+        computeIntegral(&src, own);
+
+        for (int y = 0; y < TEST_ROWS; y++) {
+            for (int x = 0; x < width; x++) {
+                if (integralSum(&view, 0, 0, x + 1, y + 1) != integralSum(own, 0, 0, x + 1, y + 1)) errors++;
+                if (integralSum(&view, x, y, width, TEST_ROWS) != integralSum(own, x, y, width, TEST_ROWS)) errors++;
+            }
+        }
+        CHECK(errors == 0, "integral na vista difere da própria em %d somas (largura %d)", errors, width);
+
+        freeIntegral(own);
+        freeImage(srcBuffer);
+    }
+
+    freeIntegral(shared);
+    freeImage(bigBuffer);
+}
+
+int main(void) {
+    testGrayKernels();
+    testSobelKernel();
+    testIntegralView();
+
+    if (testFailures > 0) {
+        printf("%d verificações falharam\n", testFailures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file test_parallel.cpp
+ * @brief Testes dos modos paralelos contra o processamento sequencial
+ *
+ * O tapete sintético de cinco moedas é processado frame a frame e por
+ * cada modo paralelo; as contagens de cada denominação têm de ser as
+ * mesmas, qualquer que seja o número de threads, de blocos ou de streams.
+ * As faixas de linhas do escalonador são verificadas à parte.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "vc_test.h"
+
+#define TEST_WIDTH 640
+#define TEST_HEIGHT 480
+
+// Leitura do tapete sintético: desenha os frames [t, end)
+typedef struct {
+    long long t, end;
+} BeltReader;
+
+static int readBeltSlot(void *user, FrameSlot *slot) {
+    BeltReader *reader = (BeltReader *)user;
+
+    if (reader->t >= reader->end) return 0;
+    renderBelt(slot->frame, TEST_BELT, TEST_BELT_COINS, reader->t);
+    slot->timestampMs = frameTime(reader->t);
+    reader->t++;
+    return 1;
+}
+
+// Leitura independente do tapete para processChunks(), a partir do frame dado
+static void *openBeltChunk(void *user, long long firstFrame) {
+    BeltReader *reader = (BeltReader *)malloc(sizeof(BeltReader));
+    (void)user;
+    if (reader == NULL) return NULL;
+    reader->t = firstFrame;
+    reader->end = TEST_BELT_FRAMES;
+    return reader;
+}
+
+static int readBeltFrame(void *stream, IVC *frame, long long *timestampMs) {
+    BeltReader *reader = (BeltReader *)stream;
+
+    if (reader->t >= reader->end) return 0;
+    renderBelt(frame, TEST_BELT, TEST_BELT_COINS, reader->t);
+    *timestampMs = frameTime(reader->t);
+    reader->t++;
+    return 1;
+}
+
+static void closeBeltChunk(void *stream) {
+    free(stream);
+}
+
+static FrameProcessor *createTestProcessor(void) {
+    FrameProcessor *proc = createFrameProcessor(TEST_WIDTH, TEST_HEIGHT);
+    proc->tracker->verbose = 0;
+    return proc;
+}
+
+// Verifica que as contagens de cada denominação são as da execução sequencial
+static void checkCounts(const int *counts, const int *expected, const char *mode, int n, const char *unit) {
+    for (int i = 0; i < VC_MAX_COIN_TYPES; i++) {
+        CHECK(counts[i] == expected[i], "%s com %d %s contou %d moedas do tipo %d (sequencial: %d)",
+              mode, n, unit, counts[i], i + 1, expected[i]);
+    }
+}
+
+/**
+ * runPipeline() com 1 a 4 threads de segmentação conta o mesmo que o
+ * modo sequencial; com o limiar de Otsu só aceita uma thread.
+ */
+static void testPipeline(const int *expected) {
+    for (int workers = 1; workers <= 4; workers++) {
+        FrameProcessor *proc = createTestProcessor();
+        BeltReader reader = { 0, TEST_BELT_FRAMES };
+        PipelineCallbacks callbacks = { readBeltSlot, NULL, &reader };
+        int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+        CHECK(runPipeline(proc, &callbacks, 0, workers, counts, NULL) == 1, "runPipeline falhou com %d threads",
+              workers);
+        checkCounts(counts, expected, "runPipeline", workers, "threads");
+        freeFrameProcessor(proc);
+    }
+
+    FrameProcessor *proc = createTestProcessor();
+    BeltReader reader = { 0, TEST_BELT_FRAMES };
+    PipelineCallbacks callbacks = { readBeltSlot, NULL, &reader };
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+    setMaskThreshold(proc, VC_MASK_MAIN, VC_THRESH_OTSU, 0);
+    CHECK(runPipeline(proc, &callbacks, 0, 2, counts, NULL) == 0, "runPipeline aceitou o limiar de Otsu com 2 threads");
+    CHECK(reader.t == 0 && totalCoins(counts) == 0, "runPipeline recusado leu %lld frames", reader.t);
+    freeFrameProcessor(proc);
+}
+
+/**
+ * processChunks() com 2 e 4 blocos conta o mesmo que o modo sequencial; com
+ * sobreposição 0 (que voltaria a contar as moedas perto das fronteiras) a
+ * sobreposição passa a ser a memória do rastreador e as contagens também.
+ * Com o limiar de Otsu só aceita um bloco.
+ */
+static void testChunks(const int *expected) {
+    static const int CHUNKS[] = { 2, 4, 3 };
+    static const int OVERLAPS[] = { -1, -1, 0 };
+
+    for (int i = 0; i < 3; i++) {
+        FrameProcessor *proc = createTestProcessor();
+        ChunkCallbacks callbacks = { openBeltChunk, readBeltFrame, closeBeltChunk, NULL };
+        ChunkResult results[4];
+        int counts[VC_MAX_COIN_TYPES] = { 0 };
+        const long long memory = VC_MAX(proc->tracker->coinWindow, proc->tracker->euroWindow);
+
+        CHECK(processChunks(proc, &callbacks, TEST_BELT_FRAMES, CHUNKS[i], OVERLAPS[i], counts, results) == CHUNKS[i],
+              "processChunks não processou os %d blocos", CHUNKS[i]);
+        checkCounts(counts, expected, OVERLAPS[i] == 0 ? "processChunks sem sobreposição" : "processChunks",
+                    CHUNKS[i], "blocos");
+        for (int c = 1; c < CHUNKS[i]; c++) {
+            CHECK(results[c].leadIn >= VC_MIN(memory, results[c].firstFrame),
+                  "bloco %d com %lld frames de sobreposição", c, results[c].leadIn);
+        }
+        freeFrameProcessor(proc);
+    }
+
+    FrameProcessor *proc = createTestProcessor();
+    ChunkCallbacks callbacks = { openBeltChunk, readBeltFrame, closeBeltChunk, NULL };
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+    setMaskThreshold(proc, VC_MASK_MAIN, VC_THRESH_OTSU, 0);
+    CHECK(processChunks(proc, &callbacks, TEST_BELT_FRAMES, 2, -1, counts, NULL) == 0,
+          "processChunks aceitou o limiar de Otsu com 2 blocos");
+    freeFrameProcessor(proc);
+}
+
+/**
+ * runStreams() com 2 e 3 streams do mesmo tapete (2 threads de trabalho)
+ * conta em cada stream o mesmo que o modo sequencial.
+ */
+static void testStreams(const int *expected) {
+    for (int n = 2; n <= 3; n++) {
+        VideoStream *streams[3];
+        BeltReader readers[3];
+
+        for (int i = 0; i < n; i++) {
+            streams[i] = createVideoStream(TEST_WIDTH, TEST_HEIGHT);
+            streams[i]->proc->tracker->verbose = 0;
+            readers[i].t = 0;
+            readers[i].end = TEST_BELT_FRAMES;
+            streams[i]->read = readBeltFrame;
+            streams[i]->source = &readers[i];
+        }
+
+        CHECK(runStreams(streams, n, 2) > 0, "runStreams falhou com %d streams", n);
+        for (int i = 0; i < n; i++) {
+            CHECK(streams[i]->frames == TEST_BELT_FRAMES, "stream %d de %d processou %lld frames", i, n,
+                  streams[i]->frames);
+            checkCounts(streams[i]->coinCounts, expected, "runStreams", n, "streams");
+            freeVideoStream(streams[i]);
+        }
+    }
+}
+
+/**
+ * processFrameAt() com um escalonador de 2 threads, que divide os kernels
+ * da segmentação em faixas de linhas, conta o mesmo que sem escalonador.
+ */
+static void testScheduledFrames(const int *expected) {
+    FrameProcessor *proc = createTestProcessor();
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+    proc->scheduler = createScheduler(2);
+    beltCounts(proc, TEST_BELT, TEST_BELT_COINS, TEST_BELT_FRAMES, counts);
+    checkCounts(counts, expected, "processFrameAt", schedulerWorkers(proc->scheduler), "threads");
+
+    freeScheduler(proc->scheduler);
+    proc->scheduler = NULL;
+    freeFrameProcessor(proc);
+}
+
+#define TEST_MAX_ROWS 1000
+
+// Contagem das vezes que cada linha foi processada por parallelRows()
+typedef struct {
+    std::atomic<int> hits[TEST_MAX_ROWS];
+    std::atomic<int> outside;
+} RowCoverage;
+
+static void countRows(void *arg, int y0, int y1) {
+    RowCoverage *coverage = (RowCoverage *)arg;
+
+    if (y0 < 0 || y1 > TEST_MAX_ROWS || y0 >= y1) coverage->outside++;
+    for (int y = VC_MAX(y0, 0); y < VC_MIN(y1, TEST_MAX_ROWS); y++) coverage->hits[y]++;
+}
+
+// Corre parallelRows() e verifica que as linhas [0, height) são cobertas uma única vez
+static void checkRowCoverage(TaskScheduler *sched, int height, int minRows, const char *caller) {
+    RowCoverage *coverage = new RowCoverage();
+    int wrong = 0;
+
+    parallelRows(sched, height, minRows, countRows, coverage);
+    for (int y = 0; y < TEST_MAX_ROWS; y++) {
+        if (coverage->hits[y] != (y < height ? 1 : 0)) wrong++;
+    }
+    CHECK(wrong == 0 && coverage->outside == 0,
+          "parallelRows (%s, %d threads, %d linhas, faixas de %d) cobriu mal %d linhas (%d faixas inválidas)",
+          caller, schedulerWorkers(sched), height, minRows, wrong, (int)coverage->outside);
+    delete coverage;
+}
+
+typedef struct {
+    TaskScheduler *sched;
+    int height, minRows;
+} NestedRows;
+
+static void nestedRows(void *arg) {
+    const NestedRows *nested = (const NestedRows *)arg;
+    checkRowCoverage(nested->sched, nested->height, nested->minRows, "tarefa");
+}
+
+/**
+ * parallelRows() processa cada linha exatamente uma vez, sem e com
+ * escalonador, chamada de fora do escalonador ou de dentro de uma tarefa,
+ * com alturas que não são múltiplas do número de faixas.
+ */
+static void testParallelRows(void) {
+    static const int HEIGHTS[] = { 1, 31, 63, 64, 65, 479, 480, TEST_MAX_ROWS };
+    static const int MIN_ROWS[] = { 0, 1, 8, VC_SCHED_MIN_ROWS };
+    static const int WORKERS[] = { 0, 1, 2, 4 };
+
+    for (int w = 0; w < 4; w++) {
+        TaskScheduler *sched = (WORKERS[w] > 0) ? createScheduler(WORKERS[w]) : NULL;
+
+        for (int h = 0; h < (int)(sizeof(HEIGHTS) / sizeof(HEIGHTS[0])); h++) {
+            for (int m = 0; m < 4; m++) {
+                checkRowCoverage(sched, HEIGHTS[h], MIN_ROWS[m], "chamador");
+
+                if (sched != NULL) {
+                    TaskGroup *group = createTaskGroup();
+                    NestedRows nested = { sched, HEIGHTS[h], MIN_ROWS[m] };
+                    submitTask(sched, group, nestedRows, &nested);
+                    waitTaskGroup(sched, group);
+                    freeTaskGroup(group);
+                }
+            }
+        }
+        freeScheduler(sched);
+    }
+}
+
+int main(void) {
+    testParallelRows();
+
+    int expected[VC_MAX_COIN_TYPES] = { 0 };
+    FrameProcessor *proc = createTestProcessor();
+
+    beltCounts(proc, TEST_BELT, TEST_BELT_COINS, TEST_BELT_FRAMES, expected);
+    freeFrameProcessor(proc);
+    CHECK(totalCoins(expected) == TEST_BELT_COINS, "tapete com %d moedas contado como %d no modo sequencial",
+          TEST_BELT_COINS, totalCoins(expected));
+
+    testPipeline(expected);
+    testChunks(expected);
+    testStreams(expected);
+    testScheduledFrames(expected);
+
+    if (testFailures > 0) {
+        printf("%d verificações falharam\n", testFailures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
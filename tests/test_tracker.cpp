@@ -0,0 +1,117 @@
+/**
+ * @file test_tracker.cpp
+ * @brief Testes do rastreador com deteções sintéticas (sem segmentação)
+ *
+ * Cada frame do tapete sintético dá uma deteção por moeda visível, entregue
+ * ao rastreador por addDetection() e commitDetections(), como faz a
+ * análise dos blobs.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+
+#include "vc_test.h"
+
+/**
+ * Moeda a 10 px/frame que para a meio do frame. Com gated, os frames com a
+ * moeda parada são saltados como faz o detetor de movimento (até maxSkip
+ * seguidos): o relógio avança e as moedas seguidas ficam onde estavam.
+ */
+static int countStoppedCoin(int gated, int maxSkip) {
+    const BeltCoin coin = { 320.0f, 80.0f, 0.0f, 10.0f, 152.0f, VC_MASK_COPPER, 16 };
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+    int skipped = 0;
+    CoinTracker *tracker = createTracker(640, 480);
+
+    tracker->verbose = 0;
+    for (long long t = 0; t < 120; t++) {
+        advanceClock(tracker, frameTime(t));
+
+        if (gated && t > coin.stopFrame + 1 && skipped < maxSkip) {
+            holdTracks(tracker);
+            skipped++;
+            continue;
+        }
+
+        skipped = 0;
+        detectBeltCoin(tracker, &coin, 3, t);
+        commitDetections(tracker, counts);
+    }
+
+    freeTracker(tracker);
+    return totalCoins(counts);
+}
+
+static void testStoppedBelt(void) {
+    int n = countStoppedCoin(0, 0);
+    CHECK(n == 1, "moeda que para contada %d vezes sem saltos", n);
+
+    for (int maxSkip = 1; maxSkip <= 30; maxSkip += 4) {
+        n = countStoppedCoin(1, maxSkip);
+        CHECK(n == 1, "moeda que para contada %d vezes com saltos de %d frames", n, maxSkip);
+    }
+}
+
+// Entrega ao rastreador uma deteção completa de cobre com o diâmetro e a circularidade dados
+static void detectCopper(CoinTracker *tracker, int y, float diameter, float circularity) {
+    CoinDetection d;
+
+    memset(&d, 0, sizeof(CoinDetection));
+    d.x = 320;
+    d.y = y;
+    d.type = classifyCoin(&tracker->specs, VC_MASK_COPPER, diameter, 1.0f, 1);
+    d.diameter = diameter;
+    d.circularity = circularity;
+    d.area = (int)(3.14159f * diameter * diameter / 4.0f);
+    d.label = getCoinSpec(&tracker->specs, d.type)->label;
+    d.weight = 1.0f;
+    d.track = -1;
+    addDetection(tracker, &d);
+}
+
+/**
+ * Uma moeda vista em apenas quatro frames, com diâmetros que caem em três
+ * denominações de cobre diferentes, é contada uma vez com a denominação
+ * da mediana (2c); se a circularidade mediana não chegar ao mínimo da
+ * denominação, não é contada.
+ */
+static void testMedianDenomination(void) {
+    static const float DIAMETERS[] = { 128.0f, 146.0f, 140.0f, 134.0f };
+
+    for (int round = 0; round <= 1; round++) {
+        int counts[VC_MAX_COIN_TYPES] = { 0 };
+        CoinTracker *tracker = createTracker(640, 480);
+        tracker->verbose = 0;
+
+        for (int t = 0; t < 4; t++) {
+            advanceClock(tracker, frameTime(t));
+            detectCopper(tracker, 100 + 10 * t, DIAMETERS[t], round ? 0.5f : 0.9f);
+            commitDetections(tracker, counts);
+        }
+
+        const int type2c = classifyCoin(&tracker->specs, VC_MASK_COPPER, 135.0f, 1.0f, 0);
+        if (round == 0) {
+            CHECK(totalCoins(counts) == 1 && counts[type2c - 1] == 1,
+                  "moeda com diâmetros dispersos contada %d vezes (%d como 2c)", totalCoins(counts), counts[type2c - 1]);
+        }
+        else {
+            CHECK(totalCoins(counts) == 0, "moeda pouco circular contada %d vezes", totalCoins(counts));
+        }
+        freeTracker(tracker);
+    }
+}
+
+int main(void) {
+    testStoppedBelt();
+    testMedianDenomination();
+
+    if (testFailures > 0) {
+        printf("%d verificações falharam\n", testFailures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_tripwire.cpp
+ * @brief Testes da contagem por passagem na linha com deteções sintéticas
+ *
+ * As deteções de cada frame são entregues ao rastreador por addDetection()
+ * e contadas por crossTripwire(), como faz a análise dos blobs com a linha
+ * de contagem ligada.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#include <stdio.h>
+
+#include "vc_test.h"
+
+#define TEST_LINE 240
+#define TYPE_2EURO 8
+
+// Passa as moedas pela linha durante nFrames e devolve as moedas contadas
+static int countCrossings(const BeltCoin *coins, int nCoins, int type, long long nFrames) {
+    CoinTracker *tracker = createTracker(640, 480);
+    Tripwire *tw = createTripwire(640, 480, TEST_LINE);
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+    tracker->verbose = 0;
+    tripwireBand(tw, &tracker->specs);
+
+    for (long long t = 0; t < nFrames; t++) {
+        advanceClock(tracker, frameTime(t));
+        for (int k = 0; k < nCoins; k++) detectBeltCoin(tracker, &coins[k], type, t);
+        crossTripwire(tw, tracker, counts);
+    }
+
+    freeTripwire(tw);
+    freeTracker(tracker);
+    return totalCoins(counts);
+}
+
+/**
+ * Duas moedas de 2€ na mesma pista, a 160 px uma da outra, que passam a
+ * linha com 4 frames de diferença: são duas moedas, ambas contadas.
+ */
+static void testSameLane(void) {
+    const BeltCoin coins[2] = {
+        { 200.0f, 100.0f, 0.0f, 30.0f, 195.0f, VC_MASK_EURO, -1 },
+        { 360.0f, -20.0f, 0.0f, 30.0f, 195.0f, VC_MASK_EURO, -1 },
+    };
+
+    const int n = countCrossings(coins, 2, TYPE_2EURO, 15);
+    CHECK(n == 2, "duas moedas da mesma pista contadas como %d", n);
+}
+
+/**
+ * Uma moeda partida em dois blobs afastados (mais do que o alcance da
+ * associação, menos do que o diâmetro da menor moeda) é contada uma vez.
+ */
+static void testSplitCoin(void) {
+    const BeltCoin halves[2] = {
+        { 250.0f, 100.0f, 0.0f, 10.0f, 60.0f, VC_MASK_EURO, -1 },
+        { 360.0f, 100.0f, 0.0f, 10.0f, 60.0f, VC_MASK_EURO, -1 },
+    };
+
+    const int n = countCrossings(halves, 2, TYPE_2EURO, 30);
+    CHECK(n == 1, "moeda partida em dois blobs contada %d vezes", n);
+}
+
+// Deteção de uma moeda na posição dada (tipo 0 = blob cortado pela banda, só posição)
+static void addCoin(CoinTracker *tracker, int x, int y, int type) {
+    CoinDetection d;
+
+    memset(&d, 0, sizeof(CoinDetection));
+    d.x = x;
+    d.y = y;
+    d.type = type;
+    d.weight = (type > 0) ? 1.0f : 0.0f;
+    d.track = -1;
+    addDetection(tracker, &d);
+}
+
+/**
+ * Uma moeda rápida vista inteira uma única vez, antes da linha, e cortada
+ * pela banda nos outros frames é contada uma vez; blobs cortados sem
+ * nenhuma deteção completa não são contados.
+ */
+static void testCutBlobs(void) {
+    const int steps[4] = { TEST_LINE - 180, TEST_LINE - 60, TEST_LINE + 60, TEST_LINE + 180 };
+
+    for (int whole = -1; whole < 4; whole++) {
+        CoinTracker *tracker = createTracker(640, 480);
+        Tripwire *tw = createTripwire(640, 480, TEST_LINE);
+        int counts[VC_MAX_COIN_TYPES] = { 0 };
+
+        tracker->verbose = 0;
+        tripwireBand(tw, &tracker->specs);
+        for (int t = 0; t < 4; t++) {
+            advanceClock(tracker, frameTime(t));
+            addCoin(tracker, 320, steps[t], (t == whole) ? TYPE_2EURO : 0);
+            crossTripwire(tw, tracker, counts);
+        }
+
+        const int n = totalCoins(counts);
+        CHECK(n == (whole >= 0 ? 1 : 0), "moeda vista inteira no passo %d contada %d vezes", whole, n);
+        freeTripwire(tw);
+        freeTracker(tracker);
+    }
+}
+
+int main(void) {
+    testSameLane();
+    testSplitCoin();
+    testCutBlobs();
+
+    if (testFailures > 0) {
+        printf("%d verificações falharam\n", testFailures);
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
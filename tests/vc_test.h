@@ -0,0 +1,173 @@
+/**
+ * @file vc_test.h
+ * @brief Verificações e tapete sintético comuns aos testes
+ *
+ * Os testes não usam o OpenCV nem os vídeos: os frames são desenhados
+ * aqui, com moedas lisas nas cores das máscaras a passar num fundo escuro,
+ * e as deteções podem ser dadas diretamente ao rastreador.
+ *
+ * @author Grupo 7 ( Daniel - 26432 / Maria - 26438 / Bruno - 26014 / Flávio - 21110)
+ * @date 2024/2025
+ */
+
+#ifndef VC_TEST_H
+#define VC_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "vc.h"
+
+static int testFailures = 0;
+
+// Regista uma falha (com a mensagem) sem interromper o teste
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FALHOU %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        testFailures++; \
+    } \
+} while (0)
+
+/**
+ * @brief Moeda do tapete sintético
+ *
+ * A moeda anda (vx, vy) pixels por frame a partir de (x, y) e fica parada
+ * a partir do frame stopFrame (negativo = nunca para).
+ */
+typedef struct {
+    float x, y;                 /**< Centro no frame 0 */
+    float vx, vy;               /**< Deslocamento por frame */
+    float diameter;             /**< Diâmetro em pixels */
+    int kind;                   /**< VC_MASK_COPPER, VC_MASK_GOLD ou VC_MASK_EURO */
+    long long stopFrame;        /**< Frame a partir do qual fica parada (negativo = nunca) */
+} BeltCoin;
+
+// Centro de uma moeda do tapete no frame t
+static inline void beltCoinAt(const BeltCoin *coin, long long t, float *x, float *y) {
+    if (coin->stopFrame >= 0 && t > coin->stopFrame) t = coin->stopFrame;
+    *x = coin->x + coin->vx * (float)t;
+    *y = coin->y + coin->vy * (float)t;
+}
+
+/**
+ * @brief Desenha o frame t do tapete (BGR)
+ *
+ * As moedas de cobre e de ouro são discos de uma cor; as de euro têm o
+ * anel exterior prateado e o centro dourado.
+ */
+static inline void renderBelt(IVC *frame, const BeltCoin *coins, int nCoins, long long t) {
+    static const unsigned char BACKGROUND[3] = { 35, 40, 45 };
+    static const unsigned char COPPER[3] = { 90, 140, 230 };
+    static const unsigned char GOLD[3] = { 80, 200, 240 };
+    static const unsigned char SILVER[3] = { 205, 200, 200 };
+    int x, y, k;
+
+    for (y = 0; y < frame->height; y++) {
+        unsigned char *p = frame->data + (long int)y * frame->bytesperline;
+        for (x = 0; x < frame->width; x++, p += 3) {
+            p[0] = BACKGROUND[0];
+            p[1] = BACKGROUND[1];
+            p[2] = BACKGROUND[2];
+        }
+    }
+
+    for (k = 0; k < nCoins; k++) {
+        const float r = coins[k].diameter / 2.0f;
+        float cx, cy;
+        beltCoinAt(&coins[k], t, &cx, &cy);
+
+        for (y = VC_MAX((int)(cy - r) - 1, 0); y <= VC_MIN((int)(cy + r) + 1, frame->height - 1); y++) {
+            for (x = VC_MAX((int)(cx - r) - 1, 0); x <= VC_MIN((int)(cx + r) + 1, frame->width - 1); x++) {
+                const float d = sqrtf((x - cx) * (x - cx) + (y - cy) * (y - cy));
+                if (d > r) continue;
+
+                const unsigned char *colour = (coins[k].kind == VC_MASK_COPPER) ? COPPER :
+                                              (coins[k].kind == VC_MASK_GOLD) ? GOLD :
+                                              (d > 0.7f * r) ? SILVER : GOLD;
+                unsigned char *p = frame->data + (long int)y * frame->bytesperline + x * 3;
+                p[0] = colour[0];
+                p[1] = colour[1];
+                p[2] = colour[2];
+            }
+        }
+    }
+}
+
+// Tempo de captura do frame t, a 30 fps
+static inline long long frameTime(long long t) {
+    return t * 1000 / 30;
+}
+
+/**
+ * @brief Tapete com cinco moedas das três cores, em três faixas
+ *
+ * Duas moedas nunca estão na mesma faixa ao mesmo tempo; todas saem do
+ * frame (640x480) antes de TEST_BELT_FRAMES frames.
+ */
+static const BeltCoin TEST_BELT[] = {
+    { 110.0f, -100.0f, 0.0f, 8.0f, 152.0f, VC_MASK_COPPER, -1 },
+    { 530.0f, -200.0f, 0.0f, 8.0f, 174.0f, VC_MASK_GOLD, -1 },
+    { 320.0f, -420.0f, 0.0f, 8.0f, 195.0f, VC_MASK_EURO, -1 },
+    { 110.0f, -650.0f, 0.0f, 8.0f, 122.0f, VC_MASK_COPPER, -1 },
+    { 530.0f, -780.0f, 0.0f, 8.0f, 185.0f, VC_MASK_EURO, -1 },
+};
+#define TEST_BELT_COINS ((int)(sizeof(TEST_BELT) / sizeof(TEST_BELT[0])))
+#define TEST_BELT_FRAMES 260
+
+// Entrega ao rastreador a deteção da moeda no frame t, se estiver toda à vista
+static inline void detectBeltCoin(CoinTracker *tracker, const BeltCoin *coin, int type, long long t) {
+    const CoinSpec *spec = getCoinSpec(&tracker->specs, type);
+    const float r = coin->diameter / 2.0f;
+    CoinDetection d;
+    float x, y;
+
+    beltCoinAt(coin, t, &x, &y);
+    if (x - r < 0 || y - r < 0 || x + r >= tracker->width || y + r >= tracker->height) return;
+
+    memset(&d, 0, sizeof(CoinDetection));
+    d.x = (int)(x + 0.5f);
+    d.y = (int)(y + 0.5f);
+    d.type = type;
+    d.diameter = coin->diameter;
+    d.circularity = 0.9f;
+    d.area = (int)(3.14159f * r * r);
+    d.label = spec->label;
+    d.weight = 1.0f;
+    d.track = -1;
+    addDetection(tracker, &d);
+}
+
+// Soma dos contadores de todas as denominações
+static inline int totalCoins(const int *counts) {
+    int total = 0;
+    for (int i = 0; i < VC_MAX_COIN_TYPES; i++) total += counts[i];
+    return total;
+}
+
+// Processa nFrames do tapete como o modo sequencial (frame2 a cada dois frames)
+static inline void beltCounts(FrameProcessor *proc, const BeltCoin *coins, int nCoins, long long nFrames,
+                              int *counts) {
+    IVC *frame = createImage(proc->width, proc->height, 3, 255);
+    IVC *frame2 = createImage(proc->width, proc->height, 3, 255);
+
+    for (long long t = 0; t < nFrames; t++) {
+        renderBelt(frame, coins, nCoins, t);
+        if (t % 2 == 0) memcpy(frame2->data, frame->data, frame->bytesperline * frame->height);
+        processFrameAt(proc, frame, frame2, counts, frameTime(t));
+    }
+
+    freeImage(frame);
+    freeImage(frame2);
+}
+
+// Total de moedas contadas em nFrames do tapete no modo sequencial
+static inline int countSequential(FrameProcessor *proc, const BeltCoin *coins, int nCoins, long long nFrames) {
+    int counts[VC_MAX_COIN_TYPES] = { 0 };
+    beltCounts(proc, coins, nCoins, nFrames, counts);
+    return totalCoins(counts);
+}
+
+#endif